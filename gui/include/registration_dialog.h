@@ -25,7 +25,8 @@ private:
     AppController* m_controller;
     
     // 采集状态
-    std::vector<std::vector<float>> m_capturedFeatures;
+    std::vector<Embedding> m_capturedFeatures;
+    std::vector<float> m_capturedQualities;
     int m_maxSamples; // 从配置读取
 
     QLabel *m_imageLabel;
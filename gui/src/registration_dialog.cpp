@@ -75,6 +75,7 @@ RegistrationDialog::~RegistrationDialog() {
 
 void RegistrationDialog::resetState() {
     m_capturedFeatures.clear();
+    m_capturedQualities.clear();
     m_progressBar->setValue(0);
     m_btnRegister->setText(QString("采集样本 (1/%1)").arg(m_maxSamples));
     m_btnRegister->setEnabled(true);
@@ -98,14 +99,16 @@ void RegistrationDialog::onRegisterClicked() {
     }
     
     // 尝试采集当前帧特征
-    std::vector<float> feature;
-    if (!m_controller->getLatestFeature(feature)) {
-        QMessageBox::warning(this, "采集失败", "未检测到人脸或画面中有多个人脸！请调整位置。");
+    Embedding feature;
+    float quality = 0.0f;
+    if (!m_controller->getLatestFeature(feature, &quality)) {
+        QMessageBox::warning(this, "采集失败", "未检测到合格人脸或画面中有多个人脸！请正对镜头并靠近一些。");
         return;
     }
     
     // 保存样本
     m_capturedFeatures.push_back(feature);
+    m_capturedQualities.push_back(quality);
     int currentSamples = m_capturedFeatures.size();
     
     // 更新 UI
@@ -121,30 +124,27 @@ void RegistrationDialog::onRegisterClicked() {
         m_btnRegister->setText("正在处理...");
         m_statusLabel->setText("正在合成特征并录入数据库...");
         
-        // 计算平均特征
-        size_t dim = m_capturedFeatures[0].size();
-        std::vector<float> averaged(dim, 0.0f);
+        // 计算平均特征 (各样本已归一化，求和后由 Embedding 归一化一次)
+        float sum[Embedding::DIM] = {0.0f};
         for (const auto& f : m_capturedFeatures) {
-            for (size_t i = 0; i < dim; ++i) {
-                averaged[i] += f[i];
+            const float* v = f.data();
+            for (int i = 0; i < Embedding::DIM; ++i) {
+                sum[i] += v[i];
             }
         }
+        Embedding averaged;
+        averaged.assign(sum);
         
-        // 归一化
-        float sq_sum = 0.0f;
-        for (size_t i = 0; i < dim; ++i) {
-            averaged[i] /= m_maxSamples;
-            sq_sum += averaged[i] * averaged[i];
-        }
-        float norm = std::sqrt(sq_sum);
-        if (norm > 1e-6) {
-            for (size_t i = 0; i < dim; ++i) averaged[i] /= norm;
-        }
-        
+        // 质量评分取各样本平均
+        float quality = 0.0f;
+        for (float q : m_capturedQualities) quality += q;
+        quality /= m_capturedQualities.size();
+
         // 提交注册
         m_controller->registerUser(name.toStdString(), 
                                  m_inputDept->text().toStdString(), 
-                                 averaged);
+                                 averaged,
+                                 quality);
     }
 }
 
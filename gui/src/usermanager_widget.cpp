@@ -73,8 +73,8 @@ void UserManagerWidget::deleteSelectedUser() {
         // Remove user (soft delete usually, but here hard delete for simplicity)
         userDao.delete_user(userId);
         
-        // Reload library
-        service::FeatureLibrary::instance().load_from_database();
+        // 同步内存特征库与用户表
+        service::FeatureLibrary::instance().remove_user(userId);
         
         refreshList();
     }
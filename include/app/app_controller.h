@@ -16,6 +16,7 @@
 #include "app/inference_thread.h"           // 推理线程 (新增)
 #include "core/model_manager.h"             // 模型管理 (新增)
 #include "core/postprocess.h"               // 结果结构体 (新增)
+#include "core/embedding.h"                 // 人脸特征
 #include "hardware/camera_device.h"
 #include "cameraview.h"
 
@@ -44,11 +45,12 @@ public:
                const std::string& yolo_path, 
                const std::string& facenet_path);
 
-    // 获取当前画面中的人脸特征 (用于注册)
-    bool getLatestFeature(std::vector<float>& feature);
+    // 获取当前画面中的人脸特征 (用于注册)，quality 可选输出人脸质量评分
+    bool getLatestFeature(Embedding& feature, float* quality = nullptr);
 
-    // 注册新用户 (传入已采集并处理好的特征)
-    int64_t registerUser(const std::string& name, const std::string& dept, const std::vector<float>& feature);
+    // 注册新用户 (传入已采集并处理好的特征及其质量评分)
+    int64_t registerUser(const std::string& name, const std::string& dept, const Embedding& feature,
+                         float quality = 1.0f);
 
 signals:
     // 图像更新信号 (用于多界面分发)
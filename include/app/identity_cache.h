@@ -0,0 +1,91 @@
+/**
+ * @file identity_cache.h
+ * @brief 按跟踪轨迹缓存的身份识别结果
+ * @details 同一个人停留在镜头前时，轨迹一旦被可靠识别 (高相似度一次命中，或连续
+ *          RECOGNITION_CONFIRM_COUNT 次一致) 即锁定身份，之后只在定期复核、人脸质量
+ *          明显提升或特征库变更时才重新运行 FaceNet 与检索；复核不解除锁定，
+ *          复核结果仍是同一用户时不会再次报告"刚锁定"。
+ *          检测阶段 (PostProcessThread) 与识别阶段 (RecognitionThread) 通过本缓存交换
+ *          身份信息，所有接口均线程安全。
+ */
+
+#ifndef IDENTITY_CACHE_H
+#define IDENTITY_CACHE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include "core/postprocess.h"
+#include "core/embedding.h"
+
+struct TrackIdentity {
+    int64_t user_id = -1;               // -1 表示未识别
+    std::string name;
+    float similarity = 0.0f;
+    int agree_count = 0;                // 连续识别为同一用户的次数
+    bool locked = false;                // 身份已锁定 (跳过 FaceNet)
+    int64_t reported_user_id = -1;      // 本次到访已作为"刚锁定"返回过的用户 (避免重复提交考勤)
+    bool in_flight = false;             // 已提交识别阶段、结果尚未返回
+    float best_quality = 0.0f;          // 参与识别的最佳人脸质量
+    Embedding feature;                  // 最近一次提取的特征
+    float feature_quality = 0.0f;       // feature 对应的人脸质量
+    std::chrono::steady_clock::time_point verified_at;
+    uint64_t library_version = 0;
+
+    // 到访统计 (轨迹存活期间)
+    int frames = 0;                     // 可见帧数 (= 无缓存时的 FaceNet 调用次数)
+    int npu_calls = 0;                  // 实际 FaceNet 调用次数
+};
+
+class IdentityCache {
+public:
+    IdentityCache();
+
+    /**
+     * @brief 记录轨迹出现一帧，并判断本帧是否需要运行 FaceNet
+     * @param face 检测结果 (需已填写 track_id 与 quality)
+     * @param now  当前时间
+     * @return true 需要识别, false 可直接使用缓存身份 (或已有识别请求在途)
+     */
+    bool need_recognition(const detect_result_t& face, std::chrono::steady_clock::time_point now);
+
+    // 标记该轨迹的识别请求已提交 (结果返回前不再重复提交)
+    void begin_recognition(int track_id);
+
+    // 识别请求被丢弃或失败，清除在途标记
+    void cancel_recognition(int track_id);
+
+    /**
+     * @brief 写入一次识别结果 (同时清除在途标记)
+     * @return true 表示该轨迹本次刚刚锁定身份 (每次到访每个用户只返回一次)
+     */
+    bool update(const detect_result_t& face, int64_t user_id, const std::string& name,
+                float similarity, const Embedding& feature,
+                std::chrono::steady_clock::time_point now);
+
+    // 取轨迹当前的显示名，尚无识别结果返回 false
+    bool get_name(int track_id, std::string& name);
+
+    // 轨迹身份是否已锁定 (识别调度时未锁定的轨迹优先)
+    bool is_locked(int track_id);
+
+    // 取轨迹最近一次的特征及其质量 (用于注册)，没有返回 false
+    bool get_feature(int track_id, Embedding& feature, float& quality);
+
+    // 移除已结束的轨迹，并累计到访统计
+    void evict(const std::vector<int>& track_ids);
+
+private:
+    std::unordered_map<int, TrackIdentity> entries_;
+    std::mutex mutex_;
+
+    // 到访统计 (每 VISIT_REPORT_INTERVAL 次到访打印一次)
+    int stat_visits_;
+    long stat_frames_;
+    long stat_npu_calls_;
+};
+
+#endif // IDENTITY_CACHE_H
@@ -3,9 +3,9 @@
  * @brief 后处理线程 (The Consumer 2)
  * @details 职责：
  * 1. 接收 InferenceThread 传来的原始 Tensor 数据。
- * 2. 执行 NMS、坐标还原等后处理算法。
- * 3. 对检测到的人脸进行裁剪并调用 FaceNet 进行特征提取。
- * 4. 检索数据库识别身份并更新最终结果。
+ * 2. 执行 NMS、坐标还原等后处理算法，并跨帧跟踪人脸 (track_id)。
+ * 3. 立即发布检测框；需要识别的人脸连同原图租约提交给 RecognitionThread。
+ * 4. UI 读取结果时从 IdentityCache 合并异步返回的身份。
  */
 
 #ifndef POSTPROCESS_THREAD_H
@@ -18,11 +18,16 @@
 #include <vector>
 #include <atomic>
 #include <array>
+#include <chrono>
 
 #include "core/model_manager.h"
 #include "app/performance_monitor.h"
 #include "app/preprocessing_thread.h" // for PreprocessTask
 #include "core/yolov8_face.h" // for YOLOV8_FACE_OUTPUT_NUM
+#include "core/face_tracker.h"
+#include "core/face_quality.h"
+#include "app/identity_cache.h"
+#include "app/recognition_thread.h"
 
 // 定义传递给后处理线程的任务包
 struct PostProcessTask {
@@ -43,13 +48,21 @@ public:
     // 由 InferenceThread 调用，推入 YOLO 输出数据
     void push_task(const PostProcessTask& task);
 
-    // 获取最终结果 (供 UI 读取)
+    // 获取最终结果 (供 UI 读取，身份在读取时从 IdentityCache 合并)
     bool get_latest_result(detect_result_group_t& result);
-    bool get_latest_feature(std::vector<float>& feature);
+    // 单人脸时的最新特征 (用于注册)，quality 可选输出对应的人脸质量评分
+    bool get_latest_feature(Embedding& feature, float* quality = nullptr);
 
 private:
     void thread_loop();
 
+    // YOLO 解码 + NMS + 跟踪，填充 detect_result，并把需要识别的人脸放入 request
+    void decode_frame(const PostProcessTask& task, detect_result_group_t& detect_result,
+                      RecognitionRequest& request);
+
+    // 发布一帧结果并统计耗时
+    void publish(const detect_result_group_t& detect_result, std::chrono::steady_clock::time_point start);
+
     ModelManager* model_manager_;
     PerformanceMonitor* monitor_;
 
@@ -63,9 +76,20 @@ private:
 
     // 结果数据
     detect_result_group_t latest_result_;
-    std::vector<float> latest_feature_;
     bool has_new_result_;
     std::mutex result_mutex_;
+
+    // 人脸跟踪与质量评估 (仅在本线程内访问)
+    FaceTracker tracker_;
+    FaceQualityScorer quality_scorer_;
+
+    // 按轨迹的身份缓存 (与识别线程共享) 及识别线程
+    IdentityCache identity_cache_;
+    RecognitionThread recognition_;
+
+    // 质量门限统计 (每 REPORT_INTERVAL 帧打印一次)
+    int stat_frames_;
+    int stat_low_quality_;              // 因质量不足跳过的人脸数
 };
 
 #endif // POSTPROCESS_THREAD_H
\ No newline at end of file
@@ -0,0 +1,128 @@
+/**
+ * @file recognition_thread.h
+ * @brief 人脸识别线程 (The Consumer 3)
+ * @details 职责：
+ * 1. 接收 PostProcessThread 提交的 (原图租约, 待识别人脸)。
+ * 2. 按优先级 (未锁定身份、人脸尺寸、靠近入口区域) 在每轮时间预算内挑选人脸，
+ *    低优先级人脸顺延到后续帧，超龄请求直接丢弃。
+ * 3. 按关键点对齐人脸，跨帧攒批后调用 FaceNetPool 批量提取特征。
+ * 4. 检索特征库，把身份写回 IdentityCache，并在身份锁定时提交考勤。
+ * 检测框的发布不等待本线程，身份由 PostProcessThread 读取结果时从 IdentityCache 合并。
+ */
+
+#ifndef RECOGNITION_THREAD_H
+#define RECOGNITION_THREAD_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include "opencv2/core/core.hpp"
+#include "core/model_manager.h"
+#include "core/postprocess.h"
+#include "core/embedding.h"
+#include "app/identity_cache.h"
+#include "service/hot_gallery.h"
+
+// 一帧中需要识别的人脸
+struct RecognitionRequest {
+    cv::Mat frame;                          // 原图租约 (引用计数共享，不拷贝像素)
+    std::vector<detect_result_t> faces;     // 已填写 track_id / quality 的检测结果
+    bool single_face;                       // 画面中只有一张人脸 (特征可用于注册)
+    std::chrono::steady_clock::time_point start;
+};
+
+class RecognitionThread {
+public:
+    RecognitionThread(ModelManager* model_manager, IdentityCache* identity_cache);
+    ~RecognitionThread();
+
+    void start();
+    void stop();
+
+    // 由 PostProcessThread 调用；队列满时丢弃最旧的请求
+    void push_request(RecognitionRequest&& request);
+
+    // 单人脸时的最新特征 (用于注册)
+    bool get_latest_feature(Embedding& feature, float* quality = nullptr);
+    void set_latest_feature(const Embedding& feature, float quality);
+
+private:
+    // 本轮被选中执行的人脸 (requests 下标, faces 下标)
+    struct ScheduledFace {
+        size_t request;
+        size_t face;
+        float priority;
+    };
+
+    void thread_loop();
+
+    // 取一个请求；deadline 为空时阻塞等待，否则最多等到 deadline
+    bool pop_request(RecognitionRequest& request, const std::chrono::steady_clock::time_point* deadline);
+
+    // 丢弃超过 RECOGNITION_MAX_AGE_MS 的请求
+    void shed_stale(std::vector<RecognitionRequest>& requests, std::chrono::steady_clock::time_point now);
+
+    // 按优先级挑选本轮预算内的人脸，其余顺延 (清除在途标记，由后续帧重新提交)
+    void schedule(const std::vector<RecognitionRequest>& requests, std::vector<ScheduledFace>& scheduled);
+
+    // 调度优先级，越大越先识别
+    float priority(const RecognitionRequest& request, const detect_result_t& face);
+
+    // 对齐选中的人脸，写入 crops
+    void prepare(const std::vector<RecognitionRequest>& requests, const std::vector<ScheduledFace>& scheduled,
+                 std::vector<cv::Mat>& crops);
+
+    // 对选中的人脸执行一次批量 FaceNet，然后逐个检索身份
+    void recognize(const std::vector<RecognitionRequest>& requests, const std::vector<ScheduledFace>& scheduled,
+                   const std::vector<cv::Mat>& crops);
+
+    // 取第 index 个复用的对齐缓冲 (不足时扩容)
+    cv::Mat& acquire_crop(size_t index, int width, int height);
+
+    // 请求未被执行 (丢弃/停止)，清除其轨迹的在途标记
+    void cancel(const RecognitionRequest& request);
+
+    ModelManager* model_manager_;
+    IdentityCache* identity_cache_;
+
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    // 请求队列
+    std::deque<RecognitionRequest> queue_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+
+    // 注册用特征
+    Embedding latest_feature_;
+    float latest_feature_quality_;
+    std::mutex feature_mutex_;
+
+    // 对齐人脸缓冲池 (跨批次复用，避免每张人脸重新分配)
+    std::vector<cv::Mat> crop_pool_;
+
+    // 本批人脸特征 (跨批次复用，稳态下提取特征不分配内存)
+    std::vector<Embedding> features_;
+
+    // 最近匹配用户的热层 (先于全库检索，仅本线程使用)
+    service::HotGallery hot_gallery_;
+
+    // 单张人脸 FaceNet 耗时的滑动平均 (毫秒)，用于换算每轮预算内可处理的人脸数
+    double est_ms_per_face_;
+
+    // FaceNet 批量推理统计 (每 REPORT_INTERVAL 次打印一次)
+    int stat_batches_;
+    int stat_faces_;
+    std::atomic<int> stat_dropped_;         // 由 push_request (检测线程) 累加
+    int stat_deferred_;                     // 超出预算顺延的人脸数
+    int stat_shed_;                         // 超龄丢弃的人脸数
+    double stat_facenet_ms_;
+    double stat_latency_ms_;                // 请求从检测完成到识别完成的耗时
+};
+
+#endif // RECOGNITION_THREAD_H
@@ -33,11 +33,15 @@ namespace Path {
     // 数据路径 (绝对路径)
     constexpr const char* FEATURE_LIB = "/home/firefly/cjh/cam_demo/data/face_feature_lib/";
     constexpr const char* DATABASE = "./data.db";
+    constexpr const char* GALLERY_FLOAT_STORE = "./gallery_float.bin"; // int8 特征库的精确 float 向量 (mmap)
+    constexpr const char* GALLERY_IVF_CENTROIDS = "./gallery_ivf.bin"; // IVF 索引聚类中心 (记录训练所用的数据库)
+    constexpr const char* GALLERY_SNAPSHOT = "./gallery_snapshot.bin"; // 归一化模板矩阵快照 (启动时 mmap 恢复)
 }
 
 // ==================== 模型参数 [固定] ====================
 namespace Model {
     constexpr int FEATURE_DIM = 512;               // 特征向量维度 (MobileFaceNet)
+    constexpr bool FACENET_RAW_OUTPUT = true;      // 读取 FaceNet 的原始 FP16/INT8 输出，转换与归一化在一个 SIMD 核中完成
     constexpr int YOLO_INPUT_SIZE = 640;           // YOLO 输入尺寸
 }
 // ==================== 性能参数 [固定] ====================
@@ -45,6 +49,11 @@ namespace Performance {
     constexpr int REPORT_INTERVAL = 50;            // 性能报告间隔 (帧数)
     constexpr int QUEUE_MAX_SIZE = 2;              // 线程队列最大大小
     constexpr bool USE_RGA = true;                // 是否启用RGA硬件加速 (禁用可避免Valgrind警告)
+    constexpr int FACENET_CONTEXT_NUM = 3;         // FaceNet 并行上下文数 (每个绑定一个 NPU 核心)
+    constexpr int RECOGNITION_BATCH_DEADLINE_MS = 8; // 跨帧攒批最长等待时间 (毫秒, 0=只合并已排队的帧)
+    constexpr size_t RECOGNITION_QUEUE_MAX_SIZE = 4;  // 识别线程请求队列最大长度
+    constexpr int RECOGNITION_FRAME_BUDGET_MS = 33;  // 每轮识别的时间预算 (约一帧间隔)，超出的低优先级人脸顺延
+    constexpr int RECOGNITION_MAX_AGE_MS = 200;     // 请求超过该时长未处理则直接丢弃 (不再迟到处理)
 }
 // ==================== 摄像头参数 [固定] ====================
 namespace Camera {
@@ -59,6 +68,70 @@ namespace Detection {
     constexpr float NMS_THRESHOLD = 0.45f;         // NMS阈值
 }
 
+// ==================== 跟踪参数 [固定] ====================
+namespace Tracker {
+    constexpr float IOU_THRESHOLD = 0.3f;          // 检测框与预测框关联的最小 IoU
+    constexpr int CONFIRM_HITS = 3;                // 连续命中多少帧后确认轨迹
+    constexpr int MAX_LOST_FRAMES = 15;            // 丢失超过该帧数后删除轨迹
+}
+
+// ==================== 人脸质量参数 [固定] ====================
+namespace Quality {
+    constexpr int MIN_FACE_SIZE = 40;              // 低于该高度 (像素) 的人脸评分为 0
+    constexpr int GOOD_FACE_SIZE = 112;            // 达到该高度 (像素) 尺寸评分为 1
+    constexpr float MAX_YAW_DEG = 45.0f;           // 偏航角超过该值评分为 0
+    constexpr float MAX_ROLL_DEG = 30.0f;          // 翻滚角超过该值评分为 0
+    constexpr int BLUR_SAMPLE_SIZE = 64;           // 清晰度评估前的缩放尺寸
+    constexpr float BLUR_GOOD_VARIANCE = 100.0f;   // Laplacian 方差达到该值清晰度评分为 1
+    constexpr float MIN_SCORE = 0.25f;             // 综合评分低于该值不提取特征
+}
+
+// ==================== 识别缓存参数 [固定] ====================
+namespace Recognition {
+    constexpr float CONFIDENT_SIMILARITY = 0.75f;  // 单次匹配即可锁定身份的相似度
+    constexpr int REVERIFY_INTERVAL_MS = 3000;     // 已锁定轨迹的定期复核间隔 (毫秒)
+    constexpr float QUALITY_IMPROVE_RATIO = 1.5f;  // 人脸质量超过历史最佳该倍数时提前复核
+    constexpr int VISIT_REPORT_INTERVAL = 10;      // 每多少次到访打印一次 NPU 调用统计
+    constexpr float MATCH_MARGIN = 0.08f;          // 第一名需领先第二名 (不同用户) 的最小相似度差 (对齐后收紧，阈值不变)
+
+    // 识别调度优先级：未锁定身份 > 人脸尺寸 + 靠近入口区域
+    constexpr float ENTRY_ZONE_X = 0.5f;           // 入口区域中心 (相对画面宽度)
+    constexpr float ENTRY_ZONE_Y = 0.5f;           // 入口区域中心 (相对画面高度)
+    constexpr float PRIORITY_UNIDENTIFIED = 2.0f;  // 未锁定轨迹的优先级加成 (大于尺寸与位置项之和)
+}
+
+// ==================== 特征库参数 [固定] ====================
+namespace Gallery {
+    constexpr bool INT8_STORAGE = false;           // 模板以 int8 存储 (内存约 1/4)，float 向量放在映射文件中重排
+    constexpr bool FP16_STORAGE = false;           // 模板以半精度存储 (内存减半，直接以半精度得分排序；INT8_STORAGE 优先)
+    constexpr int RERANK_CANDIDATES = 32;          // int8 扫描后用精确 float 向量重排的候选数
+    constexpr size_t FLOAT_STORE_MAX_TEMPLATES = 1 << 20; // float 映射文件的最大行数 (一次映射，稀疏文件)
+    constexpr bool ANN_ENABLED = true;             // 模板数达到 ANN_MIN_TEMPLATES 时改用 IVF 近似检索 (仅 float 存储)
+    constexpr size_t ANN_MIN_TEMPLATES = 20000;    // 低于该模板数时精确扫描更快也更准
+    constexpr int IVF_NPROBE = 32;                 // 每次检索扫描的倒排表数 (nlist = sqrt(模板数))
+    constexpr int IVF_TRAIN_ITERATIONS = 10;       // k-means 迭代次数
+    constexpr size_t DELTA_MAX_TEMPLATES = 256;    // 快照增量区的模板数上限，超出后并入基础存储
+    constexpr size_t DELTA_MAX_REMOVED = 64;       // 待合并删除的用户数上限，超出后并入基础存储
+    constexpr int SCAN_THREADS = 4;                // 并行扫描线程数 (含调用线程，对应 4 个 A76 大核)
+    constexpr int SCAN_FIRST_CPU = 4;              // 工作线程 w 绑定 cpu SCAN_FIRST_CPU + w (w=0 为调用线程；RK3588 的 A76 为 cpu4-7)
+    constexpr size_t SCAN_SHARD_ROWS = 256;        // 每个分片的模板数 (float 512 KB，约为 A76 的 L2)
+    constexpr size_t PARALLEL_SCAN_MIN_TEMPLATES = 8192; // 模板数达到该值才并行扫描 (唤醒线程的开销可以摊薄)
+    constexpr bool HOT_TIER_ENABLED = true;        // 识别时先检索最近匹配过的用户 (热层)，不能判定时再检索全库
+    constexpr size_t HOT_MAX_TEMPLATES = 128;      // 热层模板数上限 (float 256 KB，留在 A76 的 512 KB L2 中)
+    constexpr float HOT_EXIT_MARGIN = 0.10f;       // 热层第一名超过识别阈值该值且领先热层第二名 MATCH_MARGIN 时不再检索全库
+    constexpr const char* SITE_DEPARTMENTS = "";   // 本机站点的部门 (逗号分隔)，识别只检索这些部门的启用用户；为空时不限部门 (启动时读取)
+}
+
+// ==================== 考勤写入参数 [固定] ====================
+namespace Attendance {
+    constexpr int WRITE_BATCH_SIZE = 32;           // 单个事务最多写入的考勤事件数
+    constexpr int WRITE_FLUSH_INTERVAL_MS = 500;   // 首个事件入队后最长等待多久提交
+    constexpr int WRITE_QUEUE_CAPACITY = 1024;     // 待写队列上限 (超出丢弃并计数)
+    constexpr int WRITE_COMMIT_ATTEMPTS = 2;       // 一批事件最多提交几次 (失败回滚后重试)，仍失败才丢弃
+    constexpr int WRITE_RETRY_DELAY_MS = 200;      // 提交失败后等待多久重试 (存储短暂忙/抖动)
+    constexpr int METRICS_REPORT_INTERVAL = 20;    // 每多少次提交打印一次写入统计
+}
+
 // ==================== 默认值 [UI 可配置] ====================
 // 这些值仅作为 ConfigManager 的初始默认值
 // 运行时应从 ConfigManager 读取用户设置
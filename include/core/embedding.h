@@ -0,0 +1,74 @@
+/**
+ * @file embedding.h
+ * @brief 定长、缓存行对齐的人脸特征值类型
+ * @details 替代 std::vector<float> 在 FaceNet 输出、识别、特征库与注册之间传递特征：
+ *          数据内联在对象中 (无堆分配)，起始地址对齐缓存行，可直接交给 SIMD 核；
+ *          非空的 Embedding 总是单位向量，只在 assign() 时归一化一次，下游不再重复归一化；
+ *          NPU 的半精度 / int8 原始输出由 assign_f16() / assign_i8() 在转换的同时归一化。
+ *          连续存放的 std::vector<Embedding> 可按 EMBEDDING_STRIDE 作为多查询矩阵直接扫描。
+ */
+
+#ifndef _EMBEDDING_H_
+#define _EMBEDDING_H_
+
+#include "core/aligned_allocator.h"
+#include "core/feature_kernels.h"
+#include "config.h"
+#include <array>
+#include <cstring>
+#include <vector>
+
+class alignas(CACHE_LINE_SIZE) Embedding {
+public:
+    static constexpr int DIM = Config::Model::FEATURE_DIM;
+
+    Embedding() = default;
+
+    // 从原始向量构造 (复制并归一化)，维度不符时为空
+    explicit Embedding(const std::vector<float>& raw) { assign(raw.data(), raw.size()); }
+
+    /**
+     * @brief 复制 n 个 float 并归一化
+     * @return n 不等于 DIM 或模长为 0 时返回 false，Embedding 变为空
+     */
+    bool assign(const float* raw, size_t n = DIM) {
+        valid_ = false;
+        if (!raw || n != static_cast<size_t>(DIM)) return false;
+        memcpy(values_.data(), raw, sizeof(values_));
+        valid_ = feature_normalize(values_.data(), DIM) > 1e-6f; // 模长过小时 feature_normalize 不做处理
+        return valid_;
+    }
+
+    // 从 FaceNet 的半精度原始输出 (DIM 个) 转换并归一化，一次写入，不经过中间 float 缓冲
+    bool assign_f16(const uint16_t* raw) {
+        valid_ = raw && feature_normalize_f16(raw, DIM, values_.data()) > 1e-6f;
+        return valid_;
+    }
+
+    // 从 FaceNet 的 int8 原始输出 (DIM 个，零点 zp) 反量化并归一化
+    bool assign_i8(const int8_t* raw, int32_t zp) {
+        valid_ = raw && feature_normalize_i8(raw, zp, DIM, values_.data()) > 1e-6f;
+        return valid_;
+    }
+
+    void clear() { valid_ = false; }
+    bool empty() const { return !valid_; }
+
+    const float* data() const { return values_.data(); }
+    static constexpr size_t size() { return DIM; }
+
+    // 余弦相似度 (两者均为单位向量)
+    float dot(const Embedding& other) const { return feature_dot(data(), other.data(), DIM); }
+
+    std::vector<float> to_vector() const { return std::vector<float>(values_.begin(), values_.end()); }
+
+private:
+    std::array<float, DIM> values_{};
+    bool valid_ = false;
+};
+
+// std::vector<Embedding> 中相邻特征起始地址相隔的 float 个数 (多查询扫描的 q_stride)
+constexpr size_t EMBEDDING_STRIDE = sizeof(Embedding) / sizeof(float);
+static_assert(sizeof(Embedding) % sizeof(float) == 0, "Embedding stride must be a whole number of floats");
+
+#endif // _EMBEDDING_H_
@@ -0,0 +1,48 @@
+/**
+ * @file face_quality.h
+ * @brief 人脸质量评估
+ * @details 在调用 FaceNet 前对人脸做廉价的质量打分：尺寸、由 5 个关键点估计的
+ *          偏航/翻滚角、缩小后 Laplacian 方差 (清晰度) 以及检测置信度。
+ *          评分过低的人脸 (过小、模糊、侧脸) 几乎不可能匹配成功，直接跳过识别。
+ */
+
+#ifndef _FACE_QUALITY_H_
+#define _FACE_QUALITY_H_
+
+#include "opencv2/core/core.hpp"
+#include "core/postprocess.h"
+
+struct FaceQuality {
+    float yaw;          // 偏航角估计 (度)
+    float roll;         // 翻滚角 (度)
+    float blur_var;     // 缩小后灰度图的 Laplacian 方差
+
+    float size_score;   // 各分项评分 0~1
+    float pose_score;
+    float blur_score;
+    float score;        // 综合评分 = 尺寸 × 姿态 × 清晰度 × 置信度
+};
+
+class FaceQualityScorer {
+public:
+    /**
+     * @brief 评估单个人脸
+     * @param img  原图 (整帧, BGR)
+     * @param face 检测结果 (原图坐标)
+     * @return 质量评分
+     */
+    FaceQuality evaluate(const cv::Mat& img, const detect_result_t& face);
+
+    // 综合评分是否达到提取特征的门限
+    static bool passes(const FaceQuality& q);
+
+private:
+    float blur_variance(const cv::Mat& img, const cv::Rect& roi);
+
+    // 复用的中间缓冲
+    cv::Mat small_;
+    cv::Mat gray_;
+    cv::Mat lap_;
+};
+
+#endif // _FACE_QUALITY_H_
@@ -0,0 +1,63 @@
+/**
+ * @file face_tracker.h
+ * @brief 多目标人脸跟踪器
+ * @details IoU 关联 + 匀速卡尔曼预测 (SORT 思路)，为跨帧的同一张人脸分配稳定的
+ *          track_id，使识别/考勤等重计算可以按人而不是按帧执行。
+ */
+
+#ifndef _FACE_TRACKER_H_
+#define _FACE_TRACKER_H_
+
+#include <vector>
+#include "core/postprocess.h"
+
+class FaceTracker {
+public:
+    // 单个坐标分量的匀速卡尔曼滤波 (状态: 位置 + 速度)
+    struct KalmanAxis {
+        float x;
+        float v;
+        float p00, p01, p11;    // 协方差
+
+        void init(float z, float var);
+        void predict(float q_pos, float q_vel);
+        void update(float z, float r);
+    };
+
+    struct Track {
+        int id;
+        TRACK_STATE state;
+        int hits;               // 累计命中帧数
+        int lost_frames;        // 连续未命中帧数
+        KalmanAxis cx, cy, w, h;
+        BOX_RECT box;           // 当前估计框 (命中时为滤波结果，丢失时为预测结果)
+    };
+
+    FaceTracker();
+
+    /**
+     * @brief 用一帧检测结果更新跟踪器，并回填每个结果的 track_id / track_state
+     * @param group 检测结果 (就地修改)
+     */
+    void update(detect_result_group_t* group);
+
+    // 清空所有轨迹 (ID 继续递增，不会复用)
+    void reset();
+
+    // 当前所有轨迹 (含 TRACK_LOST)
+    const std::vector<Track>& tracks() const { return tracks_; }
+
+    // 最近一次 update() 中被删除的轨迹 ID，供上层清理按轨迹缓存的数据
+    const std::vector<int>& removed_tracks() const { return removed_; }
+
+private:
+    void predict(Track& track);
+    void correct(Track& track, const BOX_RECT& box);
+    void start_track(detect_result_t& det);
+
+    std::vector<Track> tracks_;
+    std::vector<int> removed_;
+    int next_id_;
+};
+
+#endif // _FACE_TRACKER_H_
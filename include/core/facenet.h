@@ -4,10 +4,26 @@
 #include <stdint.h>
 #include <vector>
 #include "rknn_api.h"
+#include "core/embedding.h"
 
 int create_facenet(char *model_name, rknn_context *ctx, int &width, int &height, int &channel, rknn_input_output_num &io_num, unsigned char *model_data);
 
-int facenet_inference(rknn_context *ctx, cv::Mat img, rknn_input_output_num io_num, rknn_input *inputs, rknn_output *outputs, float **result);
+// 查询模型输入的 batch 维 (dims[0])，batch-N 模型返回 N
+int query_facenet_batch(rknn_context *ctx);
+
+// 第 0 个输出 ([batch, 512] 特征) 在输出缓冲中的格式
+struct FaceNetOutputFormat {
+	rknn_tensor_type type = RKNN_TENSOR_FLOAT32;  // FLOAT32 表示由运行时转换 (want_float=1)
+	int32_t zp = 0;                               // INT8 输出的零点
+	uint32_t size = 0;                            // 预分配输出缓冲的字节数
+};
+
+// 查询第 0 个输出的属性：raw 为 true 且输出为 FP16/INT8 时直接读取原始输出，否则请求 float 输出
+int query_facenet_output(rknn_context *ctx, bool raw, FaceNetOutputFormat &format);
+
+// 批量推理：input 为 batch 张连续排列的 NHWC uint8 图像，result 输出 batch 个归一化特征
+// outputs[0] 按 format 配置 (预分配缓冲)，原始输出在一次 SIMD 核中完成转换与归一化
+int facenet_inference_batch(rknn_context *ctx, const uint8_t *input, size_t input_size, int batch, rknn_input_output_num io_num, rknn_input *inputs, rknn_output *outputs, const FaceNetOutputFormat &format, Embedding *result);
 
 int facenet_output_release(rknn_context *ctx, rknn_input_output_num io_num, rknn_output *outputs);
 
@@ -0,0 +1,104 @@
+/**
+ * @file facenet_pool.h
+ * @brief FaceNet 批量推理池
+ * @details 将一组人脸裁剪图按模型 batch 维打包，并分发到多个 RKNN 上下文
+ *          (rknn_dup_context 共享权重，各自绑定一个 NPU 核心) 并行执行，
+ *          使单张人脸的识别开销随人脸数增加而下降。
+ *          特征输出写入每个上下文预分配的缓冲；模型输出为 FP16/INT8 时不再由运行时转成 float，
+ *          而是在复制到 Embedding 时一次完成转换与归一化。
+ */
+
+#ifndef _FACENET_POOL_H_
+#define _FACENET_POOL_H_
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "rknn_api.h"
+#include "core/embedding.h"
+#include "opencv2/core/core.hpp"
+#include "core/facenet.h"
+
+class FaceNetPool {
+public:
+    FaceNetPool();
+    ~FaceNetPool();
+
+    /**
+     * @brief 初始化推理池
+     * @param ctx          已初始化的 FaceNet 主上下文 (由池内第 0 个 worker 使用，不负责销毁)
+     * @param width        模型输入宽度
+     * @param height       模型输入高度
+     * @param channel      模型输入通道数
+     * @param io_num       输入输出数量
+     * @param num_contexts 上下文总数 (含主上下文)，其余通过 rknn_dup_context 创建
+     * @return 0 成功, -1 失败
+     */
+    int init(rknn_context* ctx, int width, int height, int channel,
+             const rknn_input_output_num& io_num, int num_contexts);
+
+    /**
+     * @brief 释放复制出的上下文并停止 worker 线程
+     */
+    void release();
+
+    bool is_initialized() const { return !workers_.empty(); }
+
+    // 模型 batch 维 (batch-1 模型返回 1)
+    int batch_size() const { return batch_; }
+
+    // 一次调度可同时处理的人脸数 (batch × 上下文数)
+    int capacity() const { return batch_ * static_cast<int>(workers_.size()); }
+
+    /**
+     * @brief 批量提取人脸特征 (阻塞直到全部完成)
+     * @param crops    人脸图像，均为 width×height×channel 的 uint8 连续图像
+     * @param features 输出归一化特征，与 crops 一一对应；失败的人脸对应空 Embedding
+     *                 (调用方复用同一个 vector 时稳态下不分配内存)
+     * @return 0 全部成功, 其他表示至少一个 batch 失败
+     */
+    int extract(const std::vector<cv::Mat>& crops, std::vector<Embedding>& features);
+
+private:
+    struct Worker {
+        rknn_context ctx;
+        bool owns_ctx;                  // 是否由本池创建 (需要销毁)
+        rknn_input input;
+        std::vector<rknn_output> outputs;
+        std::vector<uint8_t> input_buf; // batch 打包缓冲
+        std::vector<uint8_t, AlignedAllocator<uint8_t>> output_buf; // 预分配的特征输出 (原始 FP16/INT8 或 float)
+        std::vector<Embedding> result_buf; // batch 个特征
+        std::vector<uint8_t> slot_valid; // batch 内各位置是否为有效人脸
+        std::thread thread;
+    };
+
+    void worker_loop(int index);
+
+    // 领取并执行当前作业中的 chunk，直到没有剩余
+    void drain_chunks(Worker& worker);
+    int run_chunk(Worker& worker, int first, int count);
+
+    std::vector<Worker> workers_;
+    rknn_input_output_num io_num_;
+    int width_;
+    int height_;
+    int channel_;
+    int batch_;
+    FaceNetOutputFormat output_format_;
+
+    // 当前作业 (受 mutex_ 保护)
+    std::mutex mutex_;
+    std::condition_variable job_cv_;
+    std::condition_variable done_cv_;
+    const std::vector<cv::Mat>* job_crops_;
+    std::vector<Embedding>* job_features_;
+    int job_next_chunk_;
+    int job_num_chunks_;
+    int job_running_;
+    int job_ret_;
+    bool stopping_;
+};
+
+#endif // _FACENET_POOL_H_
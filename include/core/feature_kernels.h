@@ -0,0 +1,83 @@
+/**
+ * @file feature_kernels.h
+ * @brief 特征向量 SIMD 计算核
+ * @details 特征库检索的内层循环：单对点积、查询向量对连续多行的点积、L2 归一化。
+ *          aarch64 上使用 NEON，x86 上编译开启 AVX2/FMA 时使用 AVX2 (仅用于 PC 基准测试)，
+ *          其余平台回退到标量实现。所有实现的结果在浮点舍入误差内一致。
+ *          int8 核用于量化特征库：A76/A55 上以 armv8.2-a+dotprod 编译时使用 sdot 指令，
+ *          整数结果在各实现间完全一致。
+ *          半精度核用于 FaceNet 原始输出与半精度特征库：aarch64 上使用 NEON 的 fcvtl/fcvtn，
+ *          x86 上需同时开启 F16C，半精度值以 IEEE binary16 的位模式 (uint16_t) 传递。
+ */
+
+#ifndef _FEATURE_KERNELS_H_
+#define _FEATURE_KERNELS_H_
+
+#include <cstddef>
+#include <stdint.h>
+
+// 当前编译所选用的实现 ("neon" / "avx2" / "scalar")
+const char* feature_kernel_isa();
+
+// 两个向量的点积
+float feature_dot(const float* a, const float* b, int dim);
+
+/**
+ * @brief 查询向量与 count 行连续存储的向量逐行求点积
+ * @param query  查询向量 (dim 个 float)
+ * @param rows   第 0 行起始地址，行与行之间相隔 stride 个 float
+ * @param stride 行跨度 (float 个数, >= dim)
+ * @param count  行数
+ * @param dim    向量维度
+ * @param out    输出 count 个点积
+ * @details 每次同时处理 4 行，查询向量的每次加载服务 4 行，减少访存。
+ */
+void feature_dot_rows(const float* query, const float* rows, size_t stride, int count, int dim, float* out);
+
+/**
+ * @brief nq 个查询向量与 count 行向量两两求点积 (小矩阵 × 大矩阵的 GEMM 核)
+ * @param queries  第 0 个查询起始地址，查询之间相隔 q_stride 个 float
+ * @param nq       查询数
+ * @param out      输出 nq × count 的点积矩阵 (第 q 个查询的结果从 out + q * count 开始)
+ * @details 以 2 个查询 × 4 行为单位计算，每次加载的行数据同时服务 2 个查询、
+ *          查询数据同时服务 4 行；调用方按缓存大小对行分块，使一块行数据服务全部查询。
+ */
+void feature_dot_rows_multi(const float* queries, size_t q_stride, int nq,
+                            const float* rows, size_t stride, int count, int dim, float* out);
+
+// 原地 L2 归一化，返回归一化前的模长 (模长过小时不做处理)
+float feature_normalize(float* v, int dim);
+
+/**
+ * @brief 半精度向量转 float 并 L2 归一化 (一次转换同时累加平方和，结果直接写入 out)
+ * @return 归一化前的模长 (模长过小时 out 为未归一化的转换结果)
+ */
+float feature_normalize_f16(const uint16_t* in, int dim, float* out);
+
+/**
+ * @brief 非对称量化的 int8 向量反量化并 L2 归一化：out 与 (in[i] - zp) 同方向
+ * @details 反量化的 scale 在归一化中抵消，不需要传入。
+ * @return 归一化前 (in[i] - zp) 的模长 (模长过小时 out 为未归一化的值)
+ */
+float feature_normalize_i8(const int8_t* in, int32_t zp, int dim, float* out);
+
+// float 与半精度之间的转换 (就近舍入)
+void feature_f32_to_f16(const float* in, int dim, uint16_t* out);
+void feature_f16_to_f32(const uint16_t* in, int dim, float* out);
+
+// float 查询与 count 行半精度向量逐行求点积，行跨度 stride 个元素 (每次同时处理 4 行)
+void feature_dot_rows_f16(const float* query, const uint16_t* rows, size_t stride, int count, int dim, float* out);
+
+/**
+ * @brief 对称 int8 量化：out[i] = round(v[i] / scale)，scale = max|v| / 127
+ * @return scale (反量化时 v[i] ≈ out[i] * scale)
+ */
+float feature_quantize_i8(const float* v, int dim, int8_t* out);
+
+// int8 向量点积 (int32 累加)
+int32_t feature_dot_i8(const int8_t* a, const int8_t* b, int dim);
+
+// 查询向量与 count 行 int8 向量逐行求点积，行跨度 stride 字节
+void feature_dot_rows_i8(const int8_t* query, const int8_t* rows, size_t stride, int count, int dim, int32_t* out);
+
+#endif // _FEATURE_KERNELS_H_
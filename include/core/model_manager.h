@@ -14,6 +14,7 @@
 #include "opencv2/core/core.hpp"
 #include "core/postprocess.h"
 #include "core/yolov8_face.h"
+#include "core/facenet_pool.h"
 
 /**
  * @brief 模型管理器类
@@ -74,9 +75,9 @@ public:
     rknn_input* get_facenet_inputs() { return facenet_inputs_; }
 
     /**
-     * @brief 获取 FaceNet 输出配置
+     * @brief 获取 FaceNet 批量推理池 (多上下文 + batch 打包)
      */
-    rknn_output* get_facenet_outputs() { return facenet_outputs_; }
+    FaceNetPool* get_facenet_pool() { return &facenet_pool_; }
 
     /**
      * @brief 获取人脸检测模型尺寸
@@ -131,7 +132,7 @@ private:
     rknn_input_output_num facenet_io_num_;
     unsigned char* facenet_model_data_;
     rknn_input facenet_inputs_[1];
-    rknn_output* facenet_outputs_;
+    FaceNetPool facenet_pool_;
 
     // 初始化标志
     bool face_detector_initialized_;
@@ -54,12 +54,22 @@ typedef struct _KEY_POINT {
     int point_5_y;  // 右嘴角 y
 } KEY_POINT;
 
+// 跟踪状态 (由 FaceTracker 填写)
+typedef enum _TRACK_STATE {
+    TRACK_NEW = 0,        // 新出现，尚未连续命中足够帧数
+    TRACK_CONFIRMED = 1,  // 已确认的稳定轨迹
+    TRACK_LOST = 2        // 暂时丢失 (仍在预测，等待重新关联)
+} TRACK_STATE;
+
 // 单个检测结果
 typedef struct __detect_result_t {
     char name[OBJ_NAME_MAX_SIZE];
     BOX_RECT box;
     KEY_POINT point;
     float prop;     // 置信度
+    int track_id;   // 跟踪 ID (-1 表示未跟踪)
+    int track_state; // TRACK_STATE
+    float quality;  // 人脸质量综合评分 0~1 (由 FaceQualityScorer 填写，未评估为 0)
 } detect_result_t;
 
 // 检测结果组
@@ -102,13 +112,30 @@ int post_process_yolov8_face(rknn_output* outputs, rknn_tensor_attr* output_attr
 // ============================================
 
 /**
- * @brief 计算相似变换矩阵
+ * @brief 5 点相似变换 (2D Umeyama 闭式解，无 SVD / cv::Mat 临时对象)
+ * @param src 源关键点 [x1,y1,...,x5,y5]
+ * @param dst 目标关键点 [x1,y1,...,x5,y5]
+ * @param M   输出 2×3 仿射矩阵 (行优先)，满足 dst ≈ M * [src;1]
+ */
+void similar_transform_5pt(const float src[10], const float dst[10], float M[6]);
+
+/**
+ * @brief 计算相似变换矩阵 (兼容接口，内部调用 similar_transform_5pt)
  * @param src 源关键点 (5×2)
  * @param dst 目标关键点 (5×2)
  * @return 3×3 变换矩阵
  */
 cv::Mat similarTransform(cv::Mat src, cv::Mat dst);
 
+/**
+ * @brief 根据 5 个关键点把人脸对齐到 ArcFace 模板
+ * @details 一次 warpAffine 从整帧直接采样到 out，无需先裁剪再缩放
+ * @param img   原图 (整帧)
+ * @param point 关键点 (原图坐标)
+ * @param out   输出图像，需预先分配为 FaceNet 输入尺寸 (CV_8UC3)，可复用
+ */
+void align_face(const cv::Mat& img, const KEY_POINT& point, cv::Mat& out);
+
 // ============================================
 // 特征比较函数
 // ============================================
@@ -16,6 +16,9 @@ public:
     
     // 获取指定时间范围内的打卡记录
     std::vector<AttendanceRecord> get_records_by_user(int64_t user_id, std::time_t start_time, std::time_t end_time);
+
+    // 获取指定时间范围内所有用户的打卡记录 (按时间升序，用于预热考勤状态)
+    std::vector<AttendanceRecord> get_records_in_range(std::time_t start_time, std::time_t end_time);
 };
 
 } // namespace db
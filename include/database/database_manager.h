@@ -3,14 +3,51 @@
 
 #include <sqlite3.h>
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <functional>
+#include <unordered_map>
+#include <stdint.h>
 
 namespace db {
 
+class DatabaseManager;
+
+/**
+ * @brief 从语句缓存借出的预编译语句 (RAII)
+ * @details 由 DatabaseManager::prepare 返回，可直接当作 sqlite3_stmt* 传给 sqlite3_bind_* / sqlite3_step / sqlite3_column_*。
+ *          析构时 reset 并清除绑定后归还缓存 (临时编译的语句直接 finalize)，查询中途退出也会结束读事务。
+ */
+class Statement {
+public:
+    Statement() = default;
+    ~Statement() { release(); }
+    Statement(Statement&& other) noexcept;
+    Statement& operator=(Statement&& other) noexcept;
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+
+    operator sqlite3_stmt*() const { return stmt_; }
+
+private:
+    friend class DatabaseManager;
+
+    // 缓存中的一条语句
+    struct CacheEntry {
+        sqlite3_stmt* stmt = nullptr;
+        bool in_use = false;
+    };
+
+    void release();
+
+    sqlite3_stmt* stmt_ = nullptr;
+    CacheEntry* entry_ = nullptr;   // 缓存中的条目 (临时语句为空)
+    uint64_t generation_ = 0;       // 借出时的缓存代数，close 后归还的语句直接 finalize
+};
+
 /**
  * @brief 数据库管理器 (单例)
- * 负责 SQLite 连接的生命周期管理
+ * 负责 SQLite 连接的生命周期管理，以及各 DAO 共用的预编译语句缓存
  */
 class DatabaseManager {
 public:
@@ -27,11 +64,32 @@ public:
     // 执行无返回值的 SQL (建表、插入、更新等)
     bool execute(const std::string& sql);
 
-    // 事务支持
+    /**
+     * @brief 取 SQL 对应的预编译语句 (DAO 使用)
+     * @details 语句按 SQL 文本缓存，首次使用时编译，之后借出的语句已 reset 且没有绑定；
+     *          同一条 SQL 正被借用 (其他线程或嵌套调用) 时临时编译一条，用完即 finalize。
+     * @return 未打开数据库或编译失败时为空 (原因见 sqlite3_errmsg)
+     */
+    Statement prepare(const char* sql);
+
+    // 开关语句缓存 (关闭时清空缓存，之后每次 prepare 都重新编译；用于基准对比)
+    void set_statement_cache(bool enable);
+
+    // 已缓存的语句数
+    size_t cached_statements();
+
+    // 事务支持：begin 成功后本线程持有写操作锁，直到 commit 成功 (或事务已结束) 或 rollback
     bool begin_transaction();
     bool commit_transaction();
     bool rollback_transaction();
 
+    /**
+     * @brief 获取写操作锁 (DAO 的写方法在编译语句前获取)
+     * @details 各线程共用一个连接：其他线程的事务未结束时，写操作会混入该事务并随其回滚。
+     *          写操作锁在事务期间一直被持有，因此写操作等到事务结束后才执行；同一线程可重入。
+     */
+    std::unique_lock<std::recursive_mutex> lock_writes() { return std::unique_lock<std::recursive_mutex>(write_mutex_); }
+
     // 获取原始句柄 (供 DAO 使用)
     sqlite3* connection() const { return db_; }
 
@@ -39,6 +97,8 @@ public:
     bool is_open() const { return db_ != nullptr; }
 
 private:
+    friend class Statement;
+
     DatabaseManager();
     DatabaseManager(const DatabaseManager&) = delete;
     DatabaseManager& operator=(const DatabaseManager&) = delete;
@@ -46,10 +106,28 @@ private:
     // 创建必要的表结构
     bool create_tables();
 
+    // 归还借出的语句
+    void release_statement(Statement& statement);
+
+    // finalize 空闲的缓存语句，借出中的语句在归还时 finalize (需持有 cache_mutex_)
+    void clear_statement_cache();
+
     sqlite3* db_ = nullptr;
     std::mutex mutex_;
+
+    // 写操作锁，begin_transaction 加锁后持有到事务结束
+    std::recursive_mutex write_mutex_;
+    bool in_transaction_ = false;   // 是否有未结束的显式事务 (受 write_mutex_ 保护)
+
+    // 语句缓存 (SQL 文本 → 语句)，条目地址在 rehash 时不变；
+    // 键指向语句自身保存的 SQL 文本 (sqlite3_sql)，查找时直接用调用方的 const char*，不构造 std::string
+    std::mutex cache_mutex_;
+    std::unordered_map<std::string_view, Statement::CacheEntry> statements_;
+    uint64_t cache_generation_ = 0;
+    bool cache_enabled_ = true;
 };
 
+
 } // namespace db
 
 #endif // DATABASE_MANAGER_H
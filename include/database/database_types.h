@@ -5,6 +5,7 @@
 #include <vector>
 #include <cstdint>
 #include <ctime>
+#include "core/embedding.h"
 
 namespace db {
 
@@ -25,10 +26,19 @@ struct User {
 struct FaceFeature {
     int64_t feature_id = -1;        // 主键
     int64_t user_id = -1;           // 外键
-    std::vector<float> feature_vector; // 512维特征向量
+    Embedding feature_vector;       // 512维归一化特征向量 (读取时归一化，长度不符的 BLOB 为空)
     float feature_quality = 0.0f;   // 注册时的画质评分
 };
 
+/**
+ * @brief face_features 表的修订号 (由触发器在每次增删改时递增)
+ * @details instance 在建表时随机生成，用于区分不同的数据库文件。
+ */
+struct FeatureRevision {
+    int64_t instance = 0;
+    int64_t revision = -1;
+};
+
 /**
  * @brief 考勤记录
  */
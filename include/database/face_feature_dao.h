@@ -15,6 +15,9 @@ public:
     // 获取所有特征（用于系统启动时加载到内存）
     std::vector<FaceFeature> get_all_features();
     
+    // 读取特征表修订号 (用于判断特征库快照文件是否过期)
+    bool get_revision(FeatureRevision& out);
+
     bool delete_feature(int64_t feature_id);
     bool delete_features_by_user_id(int64_t user_id);
 };
@@ -0,0 +1,88 @@
+/**
+ * @file attendance_recorder.h
+ * @brief 异步考勤写入器头文件
+ * @details 识别线程只负责把考勤事件放入队列，由独立的写线程按批次
+ *          (数量或时间触发) 在显式事务中落库，避免 SD 卡写入抖动阻塞识别。
+ */
+
+#ifndef ATTENDANCE_RECORDER_H
+#define ATTENDANCE_RECORDER_H
+
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+namespace service {
+
+struct AttendanceEvent {
+    int64_t user_id;
+    float similarity;
+    std::time_t check_time;     // 事件发生时间 (而非落库时间)
+};
+
+// 写入统计
+struct AttendanceRecorderMetrics {
+    size_t queue_depth = 0;     // 当前队列长度
+    size_t peak_depth = 0;      // 历史最大队列长度
+    uint64_t events = 0;        // 已提交事件数
+    uint64_t commits = 0;       // 已提交事务数
+    uint64_t dropped = 0;       // 队列满丢弃数
+    uint64_t commit_failures = 0; // 提交失败 (已回滚，之后重试) 的事务数
+    uint64_t discarded = 0;     // 重试后仍提交失败而丢弃的事件数
+    double avg_commit_ms = 0.0; // 平均事务耗时
+    double max_commit_ms = 0.0; // 最大事务耗时
+};
+
+class AttendanceRecorder {
+public:
+    static AttendanceRecorder& instance();
+
+    ~AttendanceRecorder();
+
+    // 启动写线程 (数据库需已打开)
+    void start();
+
+    // 停止写线程：先把队列中剩余事件全部落库再返回
+    void stop();
+
+    /**
+     * @brief 提交考勤事件 (非阻塞)
+     * @return false 表示写线程未运行或队列已满，事件被丢弃
+     */
+    bool submit(int64_t user_id, float similarity);
+
+    AttendanceRecorderMetrics metrics();
+
+private:
+    AttendanceRecorder() = default;
+    AttendanceRecorder(const AttendanceRecorder&) = delete;
+    AttendanceRecorder& operator=(const AttendanceRecorder&) = delete;
+
+    void writer_loop();
+
+    // 写入一批事件，提交失败时重试，全部失败才丢弃
+    void flush(const std::vector<AttendanceEvent>& batch);
+
+    // 在一个事务中写入一批事件，失败时回滚并让内存考勤状态与数据库重新对齐
+    bool write_batch(const std::vector<AttendanceEvent>& batch);
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+
+    std::deque<AttendanceEvent> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // 统计 (受 mutex_ 保护)
+    AttendanceRecorderMetrics metrics_;
+    double total_commit_ms_ = 0.0;
+};
+
+} // namespace service
+
+#endif // ATTENDANCE_RECORDER_H
@@ -8,6 +8,7 @@
 
 #include <string>
 #include <memory>
+#include <ctime>
 
 namespace service {
 
@@ -19,14 +20,10 @@ public:
      * @brief 记录考勤
      * @param user_id 用户ID
      * @param similarity 相似度
+     * @param check_time 打卡时间 (0 表示当前时间；异步写入时为事件发生时间)
      * @return 记录ID，失败返回 -1
      */
-    int64_t record_attendance(int64_t user_id, float similarity);
-
-private:
-    // 简单的判定逻辑：早上9点前正常，之后迟到
-    // 实际项目中应从配置读取
-    const int WORK_START_HOUR = 9; 
+    int64_t record_attendance(int64_t user_id, float similarity, std::time_t check_time = 0);
 };
 
 } // namespace service
@@ -0,0 +1,61 @@
+/**
+ * @file attendance_state_cache.h
+ * @brief 考勤状态内存缓存头文件
+ * @details 每个用户只保留当天的打卡状态 (首次签到时间、最后打卡时间/类型)，
+ *          启动时从数据库预热，跨零点自动清空。签到/签退判定与防重复打卡
+ *          因此是 O(1) 的内存操作，不再需要每次查询当天记录。
+ */
+
+#ifndef ATTENDANCE_STATE_CACHE_H
+#define ATTENDANCE_STATE_CACHE_H
+
+#include "database/database_types.h"
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
+
+namespace service {
+
+struct UserAttendanceState {
+    std::time_t first_check_in = 0;     // 今日首次签到时间
+    std::time_t last_check_time = 0;    // 今日最后一次打卡时间
+    int last_type = 0;                  // 最后一次打卡类型 (1=签到, 2=签退)
+};
+
+class AttendanceStateCache {
+public:
+    static AttendanceStateCache& instance();
+
+    // 从数据库加载今日记录 (数据库打开后调用；提交失败后也可重新调用以与数据库对齐)
+    void warm_up();
+
+    /**
+     * @brief 判定一次打卡
+     * @param user_id    用户ID
+     * @param check_time 打卡时间
+     * @param record     输出：填写 check_type / status
+     * @return false 表示距上次打卡不足 DUPLICATE_CHECK_INTERVAL，应忽略
+     */
+    bool decide(int64_t user_id, std::time_t check_time, db::AttendanceRecord& record);
+
+    // 记录写入成功后更新状态
+    void apply(const db::AttendanceRecord& record);
+
+private:
+    AttendanceStateCache() = default;
+
+    // 从数据库加载今日记录 (需持有 mutex_)
+    void load_today();
+
+    // t 已跨过当前缓存日时清空并切换到 t 所在日 (需持有 mutex_)
+    void roll_over(std::time_t t);
+
+    std::unordered_map<int64_t, UserAttendanceState> states_;
+    std::time_t day_start_ = 0;
+    std::time_t day_end_ = 0;
+    std::mutex mutex_;
+};
+
+} // namespace service
+
+#endif // ATTENDANCE_STATE_CACHE_H
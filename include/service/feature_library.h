@@ -1,44 +1,296 @@
 /**
  * @file feature_library.h
  * @brief 人脸特征库管理头文件
+ * @details 检索读取的全部状态组成一个不可变快照 (GallerySnapshot)，通过原子 shared_ptr 发布 (RCU)：
+ *          检索线程取得快照后无锁扫描，注册/删除在写线程中基于当前快照构造新快照再整体替换，
+ *          旧快照在最后一个读者释放后回收。
+ *          模板另存为二进制快照文件 (gallery_file.h)，启动时修订号与数据库一致则直接映射读取，
+ *          跳过逐行解析 BLOB；每次更新后由后台线程重写该文件。
+ *          每个用户的模板带一个检索标签 (部门；禁用用户单独一个标签)，检索按标签位图预过滤：
+ *          基础存储按标签分区排列，过滤检索只扫描位图中标签的行区间。
  */
 
 #ifndef FEATURE_LIBRARY_H
 #define FEATURE_LIBRARY_H
 
 #include "database/database_types.h"
+#include "core/embedding.h"
+#include "service/feature_matrix.h"
+#include "service/quantized_matrix.h"
+#include "service/half_matrix.h"
+#include "service/mapped_feature_file.h"
+#include "service/top_k.h"
+#include "service/ivf_index.h"
+#include "config.h"
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <condition_variable>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <optional>
 
 namespace service {
 
-struct LoadedFeature {
-    int64_t user_id;
-    std::vector<float> feature; // 归一化后的特征
+// 检索标签位图：第 t 位对应标签 t
+using TagMask = uint64_t;
+constexpr int TAG_COUNT = 64;
+constexpr int TAG_DISABLED = 0;                     // 禁用用户 (及用户表中不存在的模板)
+constexpr int TAG_OVERFLOW = TAG_COUNT - 1;         // 部门数超出标签数后，其余部门共用该标签 (不能按部门过滤)
+constexpr TagMask TAGS_ACTIVE = ~(TagMask(1) << TAG_DISABLED); // 全部启用用户
+constexpr TagMask TAGS_ALL = ~TagMask(0);           // 不过滤 (含禁用用户)
+
+// 检索过滤条件：标签位图 (为 0 时不匹配任何用户)，或 TAGS_DEFAULT
+using TagFilter = std::optional<TagMask>;
+constexpr std::nullopt_t TAGS_DEFAULT = std::nullopt; // 本机默认：启用用户且部门属于 set_site_departments
+
+// 内存用户表条目 (识别热路径只需要显示信息)
+struct UserInfo {
+    int64_t user_id = -1;
+    std::string name;
+    std::string department;
+    int status = 1;
+    int tag = TAG_DISABLED;                         // 检索标签 (由部门与状态决定)
+};
+
+// 一个用户及其待加入的模板 (批量增量加入)
+struct UserTemplates {
+    db::User user;
+    std::vector<Embedding> features;
+};
+
+/**
+ * @brief 特征库的一个不可变版本
+ * @details 基础存储按格式四选一 (float 矩阵 / int8 矩阵 + float 映射文件 / 半精度矩阵 / IVF 索引)，在快照之间共享；
+ *          增量注册的模板先放入小的 delta 矩阵，删除的用户记入 removed (检索基础存储时跳过)，
+ *          两者超过上限后才合并进新的基础存储，因此一次注册/删除只复制很少的数据。
+ */
+struct GallerySnapshot {
+    explicit GallerySnapshot(int dim) : delta(dim) {}
+
+    std::shared_ptr<const FeatureMatrix> base;              // float 存储 (精确扫描)
+    std::shared_ptr<const QuantizedFeatureMatrix> quantized; // int8 存储时的模板
+    std::shared_ptr<MappedFeatureFile> float_store;         // int8 存储时的精确 float 向量 (只追加)
+    std::shared_ptr<const HalfFeatureMatrix> half;          // 半精度存储时的模板
+    std::shared_ptr<const IvfIndex> index;                  // float 模板较多时的近似检索索引
+
+    FeatureMatrix delta;                                    // 上次合并后加入的模板 (归一化 float)
+    std::unordered_set<int64_t> removed;                    // 上次合并后删除的用户 (仅作用于基础存储)
+    std::shared_ptr<const std::unordered_map<int64_t, UserInfo>> users;
+
+    // 基础存储 (float / int8 / 半精度矩阵) 的行按标签排列，标签 t 的行为 [partitions[t], partitions[t+1])；IVF 时为空
+    std::vector<size_t> partitions;
+    std::shared_ptr<const std::unordered_map<std::string, int>> department_tags; // 部门 → 标签
+    TagMask default_tags = TAGS_ACTIVE;                     // TAGS_DEFAULT 对应的位图
+    bool rounded = false;                                   // 基础存储的模板经过半精度舍入 (与数据库不完全一致)
 };
 
 class FeatureLibrary {
 public:
     static FeatureLibrary& instance();
+    ~FeatureLibrary();
     
-    // 从数据库加载特征
+    // 从数据库加载特征及启用用户表 (读库与构建都在新快照上进行，不影响进行中的检索)
+    // 快照文件与数据库修订号一致时直接读取文件，否则从数据库重建并重写快照文件
     void load_from_database();
+
+    // 注册成功后增量加入 (无需整库重新加载)，空特征丢弃
+    void add_user(const db::User& user, const Embedding& feature);
+    void add_user_templates(const db::User& user, const std::vector<Embedding>& features);
+
+    // 批量增量加入，只发布一个新快照
+    void add_users(const std::vector<UserTemplates>& entries);
+
+    // 删除用户后增量移除
+    void remove_user(int64_t user_id);
+
+    /**
+     * @brief 更新一个用户的检索标签 (部门或启用状态改变，模板不变)
+     * @details 应用目前没有修改用户的入口 (UserDao::update_user 没有调用方)，只有 gallery_bench 使用；
+     *          直接在数据库中修改的部门/状态要等下次 load_from_database (重启) 才生效。
+     *          今后增加用户编辑入口时，应在 UserDao::update_user 成功后调用本函数。
+     */
+    void update_user(const db::User& user);
+
+    // 本机所在站点的部门 (TAGS_DEFAULT 只检索这些部门的启用用户)，为空时不限部门
+    // 应用在构造时取 Config::Gallery::SITE_DEPARTMENTS，本函数供测试与工具切换
+    void set_site_departments(const std::vector<std::string>& departments);
+
+    // 指定部门的标签位图 (尚无用户的部门没有标签，全部未知时为 0，检索不到任何用户)；
+    // 共用 TAG_OVERFLOW 的部门不能单独过滤，报错后不计入位图。与 TAGS_ACTIVE 以外的位组合时注意禁用标签
+    TagMask department_tags(const std::vector<std::string>& departments);
+
+    // 按 ID 查询用户 (纯内存)，不存在或已禁用返回 false
+    bool get_user(int64_t user_id, UserInfo& out);
     
     // 搜索最相似的人脸
-    // 返回 user_id, 没找到返回 -1
-    int64_t search(const std::vector<float>& feature, float threshold, float& out_similarity);
+    // 返回 user_id, 没找到返回 -1；tags 为检索的标签位图
+    int64_t search(const Embedding& feature, float threshold, float& out_similarity, TagFilter tags = TAGS_DEFAULT);
+
+    /**
+     * @brief 搜索最相似的 k 个不同用户 (每个用户取其所有模板中的最高分)
+     * @param feature    查询特征 (已归一化，不再复制)
+     * @param k          返回的用户数
+     * @param out_margin 可选输出：第一名与第二名的相似度差 (只有一个用户时第二名按 0 计)
+     * @param tags       只检索标签在位图中的模板 (默认为本机站点的启用用户)
+     * @return 按相似度降序排列的结果，特征库为空或查询为空时为空
+     */
+    std::vector<SearchMatch> search_topk(const Embedding& feature, int k, float* out_margin = nullptr,
+                                         TagFilter tags = TAGS_DEFAULT);
+
+    /**
+     * @brief 批量检索：对每个查询返回前 k 个不同用户 (语义同 search_topk)
+     * @param queries     查询特征 (空查询返回空结果)
+     * @param k           每个查询返回的用户数
+     * @param out_margins 可选输出：每个查询第一名与第二名的相似度差
+     * @param tags        只检索标签在位图中的模板 (全部查询共用)
+     * @details float 存储时以分块 GEMM 方式扫描，特征库只从内存流过一次即服务全部查询；
+     *          查询全部非空时直接在 queries 的存储上扫描，不复制。
+     */
+    std::vector<std::vector<SearchMatch>> search_batch(const std::vector<Embedding>& queries, int k,
+                                                       std::vector<float>* out_margins = nullptr,
+                                                       TagFilter tags = TAGS_DEFAULT);
+
+    // 模板的基础存储格式 (增量区总是 float)
+    enum class Storage {
+        FLOAT32,    // float 矩阵，模板较多时可改用 IVF 索引
+        INT8,       // int8 模板 + 映射文件中的 float 向量重排
+        FLOAT16,    // 半精度矩阵：内存与扫描带宽减半，直接按半精度得分排序
+    };
+
+    /**
+     * @brief 切换模板存储格式 (已加载的模板转换到新快照)
+     * @return int8 的映射文件无法创建时返回 false 并保持原存储
+     * @details 半精度存储下导出的模板 (快照文件、热层) 为半精度舍入后的值；快照文件头标明精度，
+     *          以 float / int8 存储加载时拒绝这样的文件并从数据库重建。
+     */
+    bool set_storage(Storage storage);
+    Storage storage() const { return storage_of(*snapshot()); }
+
+    // true: int8 存储; false: float 矩阵
+    bool set_quantized(bool enable) { return set_storage(enable ? Storage::INT8 : Storage::FLOAT32); }
+    bool quantized() const { return snapshot()->quantized != nullptr; }
+
+    /**
+     * @brief 设置近似检索 (IVF) 策略
+     * @param enable        是否允许使用 IVF 索引 (false 时始终精确扫描)
+     * @param min_templates float 存储的模板数达到该值时建立索引
+     */
+    void set_ann(bool enable, size_t min_templates = Config::Gallery::ANN_MIN_TEMPLATES);
+    bool ann_active() const { return snapshot()->index != nullptr; }
+
+    /**
+     * @brief 取出指定用户的全部模板 (归一化 float，不含已删除用户)
+     * @param user_ids 用户 ID 集合
+     * @param out      追加模板的矩阵 (维度须为 FEATURE_DIM)
+     * @param tags     只取标签在位图内的用户 (TAGS_DEFAULT 为本机默认过滤，与检索一致)
+     * @return 读取时的特征库版本号 (不晚于所读快照，版本号变化后调用方应重新读取)
+     * @details 只遍历一次模板 ID，不扫描向量，用于热层等小规模副本。
+     */
+    uint64_t export_users(const std::unordered_set<int64_t>& user_ids, FeatureMatrix& out, TagFilter tags = TAGS_ALL);
+
+    // 已存储的模板数 (删除的模板在合并前仍计入) / 常驻内存的模板存储字节数
+    size_t template_count();
+    size_t memory_bytes();
+
+    // 等待后台的快照文件写入完成
+    void flush_snapshot_file();
+
+    // 设置快照文件路径 (默认 Config::Path::GALLERY_SNAPSHOT；测试/工具使用临时路径)，下次加载与写入时生效
+    void set_snapshot_path(const std::string& path);
+
+    // 设置 IVF 聚类中心文件路径 (默认 Config::Path::GALLERY_IVF_CENTROIDS)，下次建立索引时生效
+    void set_index_path(const std::string& path);
+
+    // 设置 int8 存储的 float 映射文件路径 (默认 Config::Path::GALLERY_FLOAT_STORE，打开时删除同名文件)，
+    // 下次建立 int8 存储时生效
+    void set_float_store_path(const std::string& path);
+
+    // 特征库版本号，每次发布新快照后递增 (用于使上层缓存的识别结果失效)
+    uint64_t version() const { return version_.load(); }
 
 private:
-    FeatureLibrary() = default;
-    
-    // 计算余弦相似度
-    float cosine_similarity(const std::vector<float>& f1, const std::vector<float>& f2);
-    
-    // 归一化向量
-    void normalize(std::vector<float>& feature);
+    FeatureLibrary();
+
+    using Snapshot = std::shared_ptr<const GallerySnapshot>;
+
+    // 取当前快照 (无锁路径上唯一的同步点)
+    Snapshot snapshot() const { return std::atomic_load(&snapshot_); }
+
+    static Storage storage_of(const GallerySnapshot& snap) {
+        return snap.quantized ? Storage::INT8 : snap.half ? Storage::FLOAT16 : Storage::FLOAT32;
+    }
+
+    // 计算 TAGS_DEFAULT 的位图后发布新快照 (需持有 update_mutex_)
+    void publish(std::shared_ptr<GallerySnapshot> next);
+
+    // 把模板加入 next 的 delta，用户写入 users，空模板丢弃 (需持有 update_mutex_)
+    static void stage_user(GallerySnapshot& next, std::unordered_map<int64_t, UserInfo>& users,
+                           std::unordered_map<std::string, int>& departments,
+                           const db::User& user, const std::vector<Embedding>& features);
+
+    // delta/removed 超过上限时合并 (需持有 update_mutex_)
+    void maybe_compact(GallerySnapshot& next);
+
+    // 把 delta 与 removed 并入基础存储的副本，并按策略建立或撤销 IVF 索引 (需持有 update_mutex_)
+    void compact(GallerySnapshot& next);
+
+    // 快照中的全部有效模板 (归一化 float，含增量区、不含已删除用户)
+    static FeatureMatrix export_rows(const GallerySnapshot& snap);
+
+    // 数据库已打开时读取修订号，请求后台重写快照文件 (需持有 update_mutex_)
+    void schedule_save(Snapshot snap);
+
+    // 后台写线程：多次更新合并为一次写入最新快照
+    void save_loop();
+
+    // 用 rows 构造指定格式的基础存储；int8 映射文件无法创建时返回 false (需持有 update_mutex_)
+    bool build_base(GallerySnapshot& next, FeatureMatrix&& rows, Storage storage);
+
+    // float 存储时按当前策略建立或撤销 IVF 索引 (需持有 update_mutex_)
+    void update_index(GallerySnapshot& next);
+
+    // 用 rows 建立索引；数据库已打开时聚类中心优先从磁盘恢复 (须由同一数据库训练)，否则重新训练
+    // (需持有 update_mutex_)
+    std::shared_ptr<const IvfIndex> build_index(const FeatureMatrix& rows);
+
+    // 扫描快照中标签在 tags 中的模板，把每个模板的得分交给 top
+    static void collect(const GallerySnapshot& snap, const float* query, int k, TagMask tags, TopKUsers& top);
+
+    // 结果排序并计算第一/第二名差值
+    static std::vector<SearchMatch> finish(const TopKUsers& top, float* out_margin);
+
+    // 精确扫描 float / 半精度矩阵 (大特征库分片并行) 或 IVF 检索
+    static void collect_float(const GallerySnapshot& snap, const float* query, int k, TagMask tags, TopKUsers& top);
+
+    // int8 扫描 (大特征库分片并行) + float 重排 (int8 存储时)
+    static void collect_quantized(const GallerySnapshot& snap, const float* query, int k, TagMask tags,
+                                  TopKUsers& top);
+
+    std::shared_ptr<const GallerySnapshot> snapshot_;   // 只通过 std::atomic_load/atomic_store 访问
+    std::mutex update_mutex_;                   // 串行化写者 (检索不获取)
+    Storage storage_;                           // 写者使用的存储策略 (受 update_mutex_ 保护)
+    bool ann_enabled_;
+    size_t ann_min_templates_;
+    std::vector<std::string> site_departments_; // 本机站点的部门 (受 update_mutex_ 保护)
+    bool site_overflow_reported_ = false;       // 站点部门共用溢出标签的错误已报告 (受 update_mutex_ 保护)
+    std::string snapshot_path_;                 // 快照文件路径 (受 update_mutex_ 保护)
+    std::string index_path_;                    // IVF 聚类中心文件路径 (受 update_mutex_ 保护)
+    std::string float_store_path_;              // int8 存储的 float 映射文件路径 (受 update_mutex_ 保护)
+    std::atomic<uint64_t> version_{0};
 
-    std::vector<LoadedFeature> features_;
-    std::mutex mutex_;
+    // 快照文件的后台写入
+    std::thread save_thread_;
+    std::mutex save_mutex_;
+    std::condition_variable save_cv_;
+    Snapshot pending_save_;                     // 待写入的快照 (只保留最新的)
+    db::FeatureRevision pending_revision_;
+    std::string pending_path_;
+    bool saving_;
+    bool save_stop_;
 };
 
 } // namespace service
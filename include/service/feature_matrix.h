@@ -0,0 +1,124 @@
+/**
+ * @file feature_matrix.h
+ * @brief 特征库的连续矩阵存储 (SoA)
+ * @details 所有模板存放在一块 64 字节对齐的 N×stride float 矩阵中 (每行起始地址对齐缓存行)，
+ *          用户 ID 存放在平行数组中。检索时按行块顺序扫描，由 feature_dot_rows 一次处理多行，
+ *          避免逐个 std::vector 的指针追逐与缓存缺失。
+ */
+
+#ifndef FEATURE_MATRIX_H
+#define FEATURE_MATRIX_H
+
+#include "core/aligned_allocator.h"
+#include "core/feature_kernels.h"
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace service {
+
+// 检索候选：行下标及其得分
+struct ScoredRow {
+    float score;
+    size_t index;
+};
+
+class FeatureMatrix {
+public:
+    explicit FeatureMatrix(int dim);
+
+    int dim() const { return dim_; }
+    size_t stride() const { return stride_; }          // 行跨度 (float 个数，补齐到缓存行)
+    size_t size() const { return ids_.size(); }
+    bool empty() const { return ids_.empty(); }
+
+    void clear();
+    void reserve(size_t rows);
+
+    // 追加一行 (原样拷贝 dim 个 float，调用方保证已归一化)
+    void append(int64_t id, const float* feature);
+
+    // 整体替换为 count 行：rows 已按本矩阵的 stride 排列 (一次拷贝，用于从快照文件恢复)
+    void assign(const int64_t* ids, const float* rows, size_t count);
+
+    // 删除 ID 等于 id 的所有行 (保持其余行顺序)，返回删除的行数
+    size_t remove(int64_t id);
+
+    const float* row(size_t index) const { return data_.data() + index * stride_; }
+    int64_t id(size_t index) const { return ids_[index]; }
+    const std::vector<int64_t>& ids() const { return ids_; }
+
+    /**
+     * @brief 全量扫描求与 query 点积最大的行
+     * @param query     已归一化的查询向量 (dim 个 float)
+     * @param out_score 输出最大点积 (即余弦相似度)
+     * @return 行下标，矩阵为空返回 -1
+     */
+    long best_match(const float* query, float& out_score) const;
+
+    // 全量扫描，对每一行调用 visit(行下标, 点积)
+    template <typename Visitor>
+    void scan(const float* query, Visitor&& visit) const {
+        scan_range(query, 0, size(), visit);
+    }
+
+    // 只扫描 [begin, end) 行 (并行扫描时每个分片调用一次)
+    template <typename Visitor>
+    void scan_range(const float* query, size_t begin, size_t end, Visitor&& visit) const {
+        float scores[SCAN_BLOCK_ROWS];
+        for (size_t start = begin; start < end; start += SCAN_BLOCK_ROWS) {
+            int count = static_cast<int>(std::min<size_t>(SCAN_BLOCK_ROWS, end - start));
+            feature_dot_rows(query, row(start), stride_, count, dim_, scores);
+            for (int i = 0; i < count; i++) {
+                visit(start + i, scores[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief 多查询全量扫描，对每个 (查询, 行) 调用 visit(查询下标, 行下标, 点积)
+     * @param queries 第 0 个查询起始地址，查询之间相隔 q_stride 个 float
+     * @details 行按 BATCH_BLOCK_ROWS 分块 (一块约 64 KB，驻留 L1/L2)，每块行数据
+     *          读入缓存后服务全部查询，特征库只需从内存流过一次。
+     */
+    template <typename Visitor>
+    void scan_batch(const float* queries, size_t q_stride, int nq, Visitor&& visit) const {
+        scan_batch_range(queries, q_stride, nq, 0, size(), visit);
+    }
+
+    // 只扫描 [begin, end) 行的多查询扫描
+    template <typename Visitor>
+    void scan_batch_range(const float* queries, size_t q_stride, int nq, size_t begin, size_t end,
+                          Visitor&& visit) const {
+        // 得分缓冲按线程复用 (扫描线程与识别线程常驻，稳态下不再分配)
+        static thread_local std::vector<float> scores;
+        if (scores.size() < static_cast<size_t>(nq) * BATCH_BLOCK_ROWS) {
+            scores.resize(static_cast<size_t>(nq) * BATCH_BLOCK_ROWS);
+        }
+        for (size_t start = begin; start < end; start += BATCH_BLOCK_ROWS) {
+            int count = static_cast<int>(std::min<size_t>(BATCH_BLOCK_ROWS, end - start));
+            feature_dot_rows_multi(queries, q_stride, nq, row(start), stride_, count, dim_, scores.data());
+            for (int q = 0; q < nq; q++) {
+                const float* qs = scores.data() + static_cast<size_t>(q) * count;
+                for (int i = 0; i < count; i++) {
+                    visit(q, start + i, qs[i]);
+                }
+            }
+        }
+    }
+
+private:
+    // 每次交给 feature_dot_rows 的行数 (得分缓冲放在栈上)
+    static const int SCAN_BLOCK_ROWS = 64;
+    // 多查询扫描的行分块大小
+    static const int BATCH_BLOCK_ROWS = 32;
+
+    int dim_;
+    size_t stride_;
+    std::vector<float, AlignedAllocator<float>> data_;
+    std::vector<int64_t> ids_;
+};
+
+} // namespace service
+
+#endif // FEATURE_MATRIX_H
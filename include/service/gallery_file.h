@@ -0,0 +1,41 @@
+/**
+ * @file gallery_file.h
+ * @brief 特征库快照文件 (二进制，mmap 读取)
+ * @details 启动时逐行读取 SQLite BLOB、拷贝到 std::vector 再归一化，特征库较大时要花数秒。
+ *          快照文件直接保存归一化后的模板矩阵，布局与 FeatureMatrix 一致：
+ *          64 字节文件头 | 用户 ID 数组 (补齐到 64 字节) | N×stride float 矩阵。
+ *          文件头记录格式版本、维度、行数、模板精度、数据校验和以及对应的 face_features 修订号；
+ *          SQLite 仍是唯一可信来源，修订号不一致、校验失败或精度低于调用方要求时调用方从数据库重建。
+ */
+
+#ifndef GALLERY_FILE_H
+#define GALLERY_FILE_H
+
+#include "database/database_types.h"
+#include "service/feature_matrix.h"
+#include <string>
+
+namespace service {
+
+// 快照中模板的精度 (数值越大损失越多)
+enum class GalleryPrecision : uint32_t {
+    EXACT = 0,      // 与数据库一致的归一化 float 模板
+    FP16 = 1,       // 经过半精度舍入 (半精度存储导出)
+};
+
+// 写入快照 (先写临时文件、fsync 后 rename，再 fsync 所在目录，掉电不会留下半个文件或丢失 rename)
+bool save_gallery_file(const std::string& path, const FeatureMatrix& rows, const db::FeatureRevision& revision,
+                       GalleryPrecision precision = GalleryPrecision::EXACT);
+
+/**
+ * @brief mmap 读取快照到 out
+ * @param accept        可接受的最低精度 (EXACT 时拒绝半精度舍入过的文件)
+ * @param out_precision 可选输出：文件中模板的精度
+ * @return 文件不存在、损坏、维度不符、精度低于 accept 或修订号与 revision 不一致时返回 false (out 不变)
+ */
+bool load_gallery_file(const std::string& path, const db::FeatureRevision& revision, FeatureMatrix& out,
+                       GalleryPrecision accept = GalleryPrecision::EXACT, GalleryPrecision* out_precision = nullptr);
+
+} // namespace service
+
+#endif // GALLERY_FILE_H
@@ -0,0 +1,69 @@
+/**
+ * @file half_matrix.h
+ * @brief 半精度 (FP16) 的特征库矩阵
+ * @details 归一化模板转为 IEEE 半精度后存放在 64 字节对齐的连续矩阵中，内存与扫描带宽约为
+ *          float 矩阵的 1/2。单位向量各分量的半精度相对误差约 5e-4，点积误差远小于识别阈值的间隔，
+ *          因此扫描得分直接用于排序，不需要 int8 存储那样的 float 重排。
+ */
+
+#ifndef HALF_MATRIX_H
+#define HALF_MATRIX_H
+
+#include "core/aligned_allocator.h"
+#include "core/feature_kernels.h"
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace service {
+
+class HalfFeatureMatrix {
+public:
+    explicit HalfFeatureMatrix(int dim);
+
+    int dim() const { return dim_; }
+    size_t stride() const { return stride_; }          // 行跨度 (半精度元素个数，补齐到缓存行)
+    size_t size() const { return ids_.size(); }
+    bool empty() const { return ids_.empty(); }
+
+    void clear();
+    void reserve(size_t rows);
+
+    // 转换为半精度并追加一行 (调用方保证已归一化)
+    void append(int64_t id, const float* feature);
+
+    int64_t id(size_t index) const { return ids_[index]; }
+    const uint16_t* row(size_t index) const { return data_.data() + index * stride_; }
+
+    // 第 index 行转回 float (dim 个)
+    void decode(size_t index, float* out) const { feature_f16_to_f32(row(index), dim_, out); }
+
+    // 只扫描 [begin, end) 行，对每一行调用 visit(行下标, 点积)
+    template <typename Visitor>
+    void scan_range(const float* query, size_t begin, size_t end, Visitor&& visit) const {
+        float scores[SCAN_BLOCK_ROWS];
+        for (size_t start = begin; start < end; start += SCAN_BLOCK_ROWS) {
+            int count = static_cast<int>(std::min<size_t>(SCAN_BLOCK_ROWS, end - start));
+            feature_dot_rows_f16(query, row(start), stride_, count, dim_, scores);
+            for (int i = 0; i < count; i++) {
+                visit(start + i, scores[i]);
+            }
+        }
+    }
+
+    // 矩阵及 ID 数组占用的内存 (字节)
+    size_t memory_bytes() const;
+
+private:
+    // 每次交给 feature_dot_rows_f16 的行数 (得分缓冲放在栈上)
+    static const int SCAN_BLOCK_ROWS = 64;
+
+    int dim_;
+    size_t stride_;
+    std::vector<uint16_t, AlignedAllocator<uint16_t>> data_;
+    std::vector<int64_t> ids_;
+};
+
+} // namespace service
+
+#endif // HALF_MATRIX_H
@@ -0,0 +1,75 @@
+/**
+ * @file hot_gallery.h
+ * @brief 最近匹配用户的热层
+ * @details 入口处绝大多数识别是几分钟内刚出现过的人或常客，却每次都要扫描全库。
+ *          热层保存最近匹配过的少量用户的模板 (小矩阵，驻留 L2)，检索时先扫描热层：
+ *          第一名超过阈值足够多且明显领先热层第二名时直接返回，否则再整批检索全库。
+ *          用户按最近匹配时间淘汰 (LRU)；特征库版本变化 (注册/删除/修改用户) 后热层从特征库重新取模板，
+ *          只保留本机默认过滤 (TAGS_DEFAULT) 范围内的用户。
+ *          非线程安全：由识别线程独占使用。
+ */
+
+#ifndef HOT_GALLERY_H
+#define HOT_GALLERY_H
+
+#include "service/feature_matrix.h"
+#include "service/top_k.h"
+#include "core/embedding.h"
+#include "config.h"
+#include <stdint.h>
+#include <vector>
+
+namespace service {
+
+class HotGallery {
+public:
+    // max_templates 为 0 时热层关闭，search_batch 直接检索全库
+    explicit HotGallery(size_t max_templates = Config::Gallery::HOT_MAX_TEMPLATES);
+
+    /**
+     * @brief 批量检索：热层能判定的查询直接返回，其余查询整批交给 FeatureLibrary::search_batch
+     * @param queries     查询特征 (空查询返回空结果)
+     * @param k           每个查询返回的用户数
+     * @param threshold   识别阈值 (热层第一名需达到 threshold + HOT_EXIT_MARGIN)
+     * @param out_margins 可选输出：每个查询第一名与第二名的相似度差 (热层返回时为与热层第二名的差)
+     * @param out_hot     可选输出：每个查询是否由热层返回
+     * @return 与 FeatureLibrary::search_batch 相同
+     */
+    std::vector<std::vector<SearchMatch>> search_batch(const std::vector<Embedding>& queries, int k,
+                                                       float threshold, std::vector<float>* out_margins = nullptr,
+                                                       std::vector<bool>* out_hot = nullptr);
+
+    // 识别成功后调用：用户加入热层或移到最近使用 (模板在下次检索前从特征库取出)
+    void touch(int64_t user_id);
+
+    void clear();
+
+    // 热层中的用户数 / 模板数
+    size_t user_count() const { return lru_.size(); }
+    size_t template_count() const { return rows_.size(); }
+
+    // 累计统计，take_stats() 取出后清零
+    struct Stats {
+        int queries = 0;        // 检索的查询数
+        int hot_hits = 0;       // 由热层返回的查询数
+        double hot_ms = 0.0;    // 扫描热层的总耗时
+        double full_ms = 0.0;   // 未命中查询检索全库的总耗时
+    };
+    Stats take_stats();
+
+private:
+    // 特征库版本变化或有新用户加入时重新取模板，超出模板上限时淘汰最久未匹配的用户
+    void refresh();
+
+    size_t max_templates_;
+    FeatureMatrix rows_;            // 热层用户的归一化模板
+    std::vector<int64_t> lru_;      // 热层用户，按最近匹配时间从新到旧
+    uint64_t version_;              // rows_ 对应的特征库版本号
+    bool dirty_;                    // lru_ 中有尚未取出模板的用户
+    std::vector<Embedding> rest_;   // 热层未命中的查询 (跨批次复用，避免重复分配)
+    Stats stats_;
+};
+
+} // namespace service
+
+#endif // HOT_GALLERY_H
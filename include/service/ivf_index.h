@@ -0,0 +1,85 @@
+/**
+ * @file ivf_index.h
+ * @brief IVF-Flat 近似最近邻索引
+ * @details 用球面 k-means 把模板划分到 nlist 个倒排表 (每个表是一个连续的 FeatureMatrix)，
+ *          检索时先与全部中心求点积，只扫描最接近的 nprobe 个表。支持增量插入/删除；
+ *          聚类中心可保存到磁盘 (记录训练所用的特征库)，重启时恢复后只需重新分配模板，无需重新训练。
+ */
+
+#ifndef IVF_INDEX_H
+#define IVF_INDEX_H
+
+#include "service/feature_matrix.h"
+#include <string>
+#include <vector>
+
+namespace service {
+
+class IvfIndex {
+public:
+    explicit IvfIndex(int dim);
+
+    bool trained() const { return !centroids_.empty(); }
+    int nlist() const { return static_cast<int>(centroids_.size()); }
+    size_t size() const { return size_; }
+
+    /**
+     * @brief 用 data 中的模板训练 nlist 个聚类中心 (清空已有倒排表)
+     * @param iterations k-means 迭代次数
+     */
+    void train(const FeatureMatrix& data, int nlist, int iterations);
+
+    // 聚类中心的保存与恢复；gallery 标识训练所用的特征库 (数据库实例号)，
+    // 维度或特征库不符、文件损坏时返回 false
+    bool save_centroids(const std::string& path, int64_t gallery) const;
+    bool load_centroids(const std::string& path, int64_t gallery);
+
+    // 清空倒排表 (保留聚类中心)
+    void clear();
+
+    // 插入一个已归一化的模板 (须已训练)
+    void add(int64_t id, const float* feature);
+
+    // 删除 ID 等于 id 的所有模板，返回删除数
+    size_t remove(int64_t id);
+
+    // 把全部模板追加到 out (切回精确检索时使用)
+    void export_to(FeatureMatrix& out) const;
+
+    // 倒排表占用的内存 (字节)
+    size_t memory_bytes() const;
+
+    // 遍历全部模板，对每个模板调用 visit(用户ID, 向量)
+    template <typename Visitor>
+    void for_each(Visitor&& visit) const {
+        for (const auto& list : lists_) {
+            for (size_t i = 0; i < list.size(); i++) visit(list.id(i), list.row(i));
+        }
+    }
+
+    // 扫描与 query 最接近的 nprobe 个倒排表，对每个模板调用 visit(用户ID, 点积)
+    template <typename Visitor>
+    void search(const float* query, int nprobe, Visitor&& visit) const {
+        std::vector<int> probes;
+        nearest_lists(query, nprobe, probes);
+        for (int l : probes) {
+            const FeatureMatrix& list = lists_[l];
+            list.scan(query, [&](size_t index, float score) {
+                visit(list.id(index), score);
+            });
+        }
+    }
+
+private:
+    // 与 v 最接近的 n 个中心 (按相似度降序)
+    void nearest_lists(const float* v, int n, std::vector<int>& out) const;
+
+    int dim_;
+    FeatureMatrix centroids_;   // nlist 个归一化中心 (id 为表号)
+    std::vector<FeatureMatrix> lists_;
+    size_t size_;
+};
+
+} // namespace service
+
+#endif // IVF_INDEX_H
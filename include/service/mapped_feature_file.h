@@ -0,0 +1,50 @@
+/**
+ * @file mapped_feature_file.h
+ * @brief 内存映射的 float 特征文件 (只追加)
+ * @details 量化特征库只在内存中保留 int8 模板，精确的 float 向量写入本文件并通过 mmap 访问：
+ *          检索时只有重排的少量候选行会被读入页缓存，冷数据可由内核随时回收，不占用进程堆内存。
+ *          行一经写入不再修改，删除模板时只删除引用它的 int8 行。
+ *          打开时按最大行数一次映射整个 (稀疏) 文件，追加不会重新映射，已发布的行地址始终有效：
+ *          旧特征库快照仍在读取时，写线程可以继续追加。整库重新加载时创建新文件 (旧文件先 unlink，
+ *          仍持有它的快照释放后由内核回收)。
+ */
+
+#ifndef MAPPED_FEATURE_FILE_H
+#define MAPPED_FEATURE_FILE_H
+
+#include <stddef.h>
+#include <string>
+
+namespace service {
+
+class MappedFeatureFile {
+public:
+    MappedFeatureFile();
+    ~MappedFeatureFile();
+
+    MappedFeatureFile(const MappedFeatureFile&) = delete;
+    MappedFeatureFile& operator=(const MappedFeatureFile&) = delete;
+
+    // 创建新文件并映射 max_rows 行，dim 为每行 float 个数 (同名旧文件先 unlink)
+    bool open(const std::string& path, int dim, size_t max_rows);
+    void close();
+    bool is_open() const { return fd_ >= 0; }
+
+    // 追加一行，返回行号，已满或失败返回 -1 (只能由一个写线程调用)
+    long append(const float* feature);
+
+    const float* row(size_t index) const { return data_ + index * dim_; }
+    size_t size() const { return rows_; }
+
+private:
+    int fd_;
+    float* data_;
+    size_t rows_;
+    size_t capacity_;
+    int dim_;
+    std::string path_;
+};
+
+} // namespace service
+
+#endif // MAPPED_FEATURE_FILE_H
@@ -0,0 +1,65 @@
+/**
+ * @file quantized_matrix.h
+ * @brief int8 量化的特征库矩阵
+ * @details 每个模板按对称 int8 量化 (每行一个 scale)，存放在 64 字节对齐的连续矩阵中，
+ *          内存约为 float 矩阵的 1/4。扫描使用 int8 点积核得到近似得分，
+ *          返回的候选行再由调用方用精确的 float 向量 (float_row 指向 MappedFeatureFile) 重排。
+ */
+
+#ifndef QUANTIZED_MATRIX_H
+#define QUANTIZED_MATRIX_H
+
+#include "core/aligned_allocator.h"
+#include "service/feature_matrix.h"
+#include <stdint.h>
+#include <vector>
+
+namespace service {
+
+class QuantizedFeatureMatrix {
+public:
+    explicit QuantizedFeatureMatrix(int dim);
+
+    int dim() const { return dim_; }
+    size_t stride() const { return stride_; }          // 行跨度 (字节，补齐到缓存行)
+    size_t size() const { return ids_.size(); }
+    bool empty() const { return ids_.empty(); }
+
+    void clear();
+    void reserve(size_t rows);
+
+    // 量化并追加一行，float_row 为该模板精确向量在 float 存储中的行号
+    void append(int64_t id, const float* feature, uint32_t float_row);
+
+    // 删除 ID 等于 id 的所有行 (保持其余行顺序)，返回删除的行数
+    size_t remove(int64_t id);
+
+    int64_t id(size_t index) const { return ids_[index]; }
+    uint32_t float_row(size_t index) const { return float_rows_[index]; }
+
+    /**
+     * @brief 近似扫描，取近似得分最高的 k 行
+     * @param query       已归一化查询向量的 int8 量化结果
+     * @param query_scale 查询向量的量化 scale
+     * @param k           候选数
+     * @param out         输出候选，按近似得分降序
+     * @param begin, end  只扫描 [begin, end) 行 (并行扫描时每个分片调用一次；默认全部行)
+     */
+    void top_candidates(const int8_t* query, float query_scale, int k, std::vector<ScoredRow>& out,
+                        size_t begin = 0, size_t end = SIZE_MAX) const;
+
+    // 矩阵及平行数组占用的内存 (字节)
+    size_t memory_bytes() const;
+
+private:
+    int dim_;
+    size_t stride_;
+    std::vector<int8_t, AlignedAllocator<int8_t>> data_;
+    std::vector<float> scales_;
+    std::vector<int64_t> ids_;
+    std::vector<uint32_t> float_rows_;
+};
+
+} // namespace service
+
+#endif // QUANTIZED_MATRIX_H
@@ -0,0 +1,59 @@
+/**
+ * @file scan_pool.h
+ * @brief 特征库并行扫描线程池
+ * @details 常驻的工作线程 (绑定到 A76 大核)，检索时与调用线程一起分片扫描大特征库，
+ *          不为每次查询创建线程。同一时刻只服务一个调用方：线程池忙时 run() 立即返回 false，
+ *          调用方自行串行扫描，检索因此永远不会等待其他查询。
+ */
+
+#ifndef SCAN_POOL_H
+#define SCAN_POOL_H
+
+#include <stdint.h>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace service {
+
+class ScanPool {
+public:
+    static ScanPool& instance();
+    ~ScanPool();
+
+    // 参与扫描的线程数 (含调用线程)
+    int threads() const { return threads_; }
+
+    // 调整线程数，范围 [1, Config::Gallery::SCAN_THREADS] (测试/基准按线程数测量；不受 CPU 数限制)
+    void resize(int threads);
+
+    /**
+     * @brief 在全部线程上各执行一次 task(worker)，调用线程为 worker 0，全部完成后返回
+     * @return 线程池正被其他调用方使用时返回 false (task 未执行)
+     */
+    bool run(const std::function<void(int)>& task);
+
+private:
+    ScanPool();
+
+    void start(int threads);
+    void stop();
+    void worker_loop(int worker, uint64_t generation);
+
+    std::mutex run_mutex_;                  // 当前调用方 (try_lock)
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    std::vector<std::thread> workers_;
+    const std::function<void(int)>* task_;
+    uint64_t generation_;                   // 每次 run() 递增，唤醒工作线程
+    int pending_;                           // 尚未完成本轮任务的工作线程数
+    bool stop_;
+    int threads_;
+};
+
+} // namespace service
+
+#endif // SCAN_POOL_H
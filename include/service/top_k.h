@@ -0,0 +1,91 @@
+/**
+ * @file top_k.h
+ * @brief 按用户去重的 Top-K 选择
+ * @details 在特征库扫描内层逐行调用 offer()：只保留得分最高的 k 个不同用户，
+ *          每个用户取其所有模板中的最高分。未进入前 k 的行只有一次比较的开销，
+ *          因此 Top-K 检索与单纯求最大值的全量扫描代价相同。
+ */
+
+#ifndef TOP_K_H
+#define TOP_K_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+namespace service {
+
+// 检索结果：用户及其模板中的最高相似度
+struct SearchMatch {
+    int64_t user_id;
+    float similarity;
+};
+
+class TopKUsers {
+public:
+    explicit TopKUsers(int k) : k_(std::max(k, 1)) { heap_.reserve(k_); }
+
+    // 清空结果并改为取前 k 名 (复用的缓冲保留已分配的容量)
+    void reset(int k) {
+        k_ = std::max(k, 1);
+        heap_.clear();
+        heap_.reserve(k_);
+    }
+
+    // 该得分能否进入当前前 k (调用方可在代价较高的过滤之前先判断)
+    bool accepts(float score) const {
+        return static_cast<int>(heap_.size()) < k_ || score > heap_.front().similarity;
+    }
+
+    // 加入一行的得分
+    void offer(int64_t user_id, float score) {
+        if (!accepts(score)) return; // 绝大多数行在这里返回
+        bool full = static_cast<int>(heap_.size()) == k_;
+
+        // 该用户已在前 k 中：只保留其最高分
+        for (auto& m : heap_) {
+            if (m.user_id == user_id) {
+                if (score > m.similarity) {
+                    m.similarity = score;
+                    std::make_heap(heap_.begin(), heap_.end(), worse);
+                }
+                return;
+            }
+        }
+
+        if (full) {
+            std::pop_heap(heap_.begin(), heap_.end(), worse);
+            heap_.back() = {user_id, score};
+        } else {
+            heap_.push_back({user_id, score});
+        }
+        std::push_heap(heap_.begin(), heap_.end(), worse);
+    }
+
+    // 并入另一个 TopKUsers 的结果 (分片扫描后合并；同一用户仍只保留最高分)
+    void merge(const TopKUsers& other) {
+        for (const auto& m : other.heap_) {
+            offer(m.user_id, m.similarity);
+        }
+    }
+
+    // 输出按相似度降序排列的结果
+    std::vector<SearchMatch> sorted() const {
+        std::vector<SearchMatch> out = heap_;
+        std::sort(out.begin(), out.end(), [](const SearchMatch& a, const SearchMatch& b) {
+            return a.similarity > b.similarity;
+        });
+        return out;
+    }
+
+private:
+    // 小顶堆：堆顶为当前第 k 名
+    static bool worse(const SearchMatch& a, const SearchMatch& b) { return a.similarity > b.similarity; }
+
+    int k_;
+    std::vector<SearchMatch> heap_;
+};
+
+} // namespace service
+
+#endif // TOP_K_H
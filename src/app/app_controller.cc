@@ -30,6 +30,8 @@
 #include "database/user_dao.h"
 #include "database/face_feature_dao.h"
 #include "service/feature_library.h"
+#include "service/attendance_recorder.h"
+#include "service/attendance_state_cache.h"
 #include "app/postprocess_thread.h" // 新增
 
 AppController::AppController(CameraView *view, QObject *parent) 
@@ -97,6 +99,9 @@ AppController::~AppController() {
         m_postThread->stop();
         delete m_postThread;
     }
+
+    // 后处理线程已停止，不会再有新的考勤事件：把队列中剩余事件落库
+    service::AttendanceRecorder::instance().stop();
     
     // 释放模型
     if (m_modelManager) {
@@ -139,6 +144,10 @@ bool AppController::start(int camIndex, int w, int h,
     } else {
         // 加载特征库
         service::FeatureLibrary::instance().load_from_database();
+
+        // 预热今日考勤状态，并启动考勤异步写线程
+        service::AttendanceStateCache::instance().warm_up();
+        service::AttendanceRecorder::instance().start();
     }
 
     // 加载 YOLOv8
@@ -150,7 +159,7 @@ bool AppController::start(int camIndex, int w, int h,
     // 加载 FaceNet
     if (m_modelManager->init_facenet(facenet_path.c_str()) != 0) {
         std::cerr << "Failed to load FaceNet model: " << facenet_path << std::endl;
-        // FaceNet 失败不应该阻塞程序运行，可能只是识别功能不可用
+        return false;
     }
 
     // --- 启动线程 ---
@@ -173,12 +182,13 @@ bool AppController::start(int camIndex, int w, int h,
     return true;
 }
 
-bool AppController::getLatestFeature(std::vector<float>& feature) {
+bool AppController::getLatestFeature(Embedding& feature, float* quality) {
     if (!m_postThread) return false;
-    return m_postThread->get_latest_feature(feature);
+    return m_postThread->get_latest_feature(feature, quality);
 }
 
-int64_t AppController::registerUser(const std::string& name, const std::string& dept, const std::vector<float>& feature) {
+int64_t AppController::registerUser(const std::string& name, const std::string& dept, const Embedding& feature,
+                                    float quality) {
 #if (PROJECT_MODE == 1)
     if (feature.empty()) {
         emit registrationFinished(false, "Feature vector is empty!");
@@ -209,7 +219,7 @@ int64_t AppController::registerUser(const std::string& name, const std::string&
     db::FaceFeature ff;
     ff.user_id = uid;
     ff.feature_vector = feature;
-    ff.feature_quality = 1.0f; // 暂未做质量评估
+    ff.feature_quality = quality;
     
     db::FaceFeatureDao featureDao;
     if (featureDao.add_feature(ff) == -1) {
@@ -219,8 +229,9 @@ int64_t AppController::registerUser(const std::string& name, const std::string&
         return -1;
     }
     
-    // 3. 刷新内存特征库
-    service::FeatureLibrary::instance().load_from_database();
+    // 3. 增量更新内存特征库与用户表
+    user.user_id = uid;
+    service::FeatureLibrary::instance().add_user(user, feature);
     
     emit registrationFinished(true, QString("Success! User ID: %1").arg(uid));
     return uid;
@@ -313,9 +324,10 @@ void AppController::drawResult(cv::Mat& frame, const detect_result_group_t& resu
     // --- 新增：绘制实时时间 ---
     char time_str[64];
     time_t now = time(nullptr);
-    struct tm *tstruct = localtime(&now);
+    struct tm tstruct;
+    localtime_r(&now, &tstruct); // 考勤线程同时在做日期计算，不使用 localtime 的静态缓冲
     // 格式化时间：年-月-日 时:分:秒
-    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tstruct);
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tstruct);
     
     // 设置时间显示的参数
     int font_face = cv::FONT_HERSHEY_SIMPLEX;
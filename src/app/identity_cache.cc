@@ -0,0 +1,158 @@
+/**
+ * @file identity_cache.cc
+ * @brief 按跟踪轨迹缓存的身份识别结果实现
+ */
+
+#include "app/identity_cache.h"
+#include "config.h"
+#include "service/feature_library.h"
+#include <iostream>
+
+IdentityCache::IdentityCache()
+    : stat_visits_(0)
+    , stat_frames_(0)
+    , stat_npu_calls_(0)
+{
+}
+
+bool IdentityCache::need_recognition(const detect_result_t& face, std::chrono::steady_clock::time_point now) {
+    if (face.track_id < 0) return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    TrackIdentity& entry = entries_[face.track_id];
+    entry.frames++;
+
+    // 上一次请求尚未返回，避免同一轨迹在识别队列中堆积
+    if (entry.in_flight) return false;
+
+    if (!entry.locked) return true;
+
+    // 特征库已变更 (注册/删除用户)：按新特征库复核一次。保持锁定，
+    // 复核结果仍是同一用户时 update() 不会再报告"刚锁定" (不重复提交考勤)
+    if (entry.library_version != service::FeatureLibrary::instance().version()) return true;
+
+    // 定期复核
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.verified_at).count();
+    if (elapsed >= Config::Recognition::REVERIFY_INTERVAL_MS) return true;
+
+    // 人脸质量明显提升 (靠近镜头/转正)，用更好的样本再确认一次
+    if (face.quality > entry.best_quality * Config::Recognition::QUALITY_IMPROVE_RATIO) return true;
+
+    return false;
+}
+
+bool IdentityCache::update(const detect_result_t& face, int64_t user_id, const std::string& name,
+                           float similarity, const Embedding& feature,
+                           std::chrono::steady_clock::time_point now) {
+    if (face.track_id < 0) return user_id != -1;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(face.track_id);
+    if (it == entries_.end()) return false; // 结果返回前轨迹已结束
+
+    TrackIdentity& entry = it->second;
+    entry.in_flight = false;
+    entry.npu_calls++;
+    entry.feature = feature;
+    entry.feature_quality = face.quality;
+    entry.library_version = service::FeatureLibrary::instance().version();
+
+    if (face.quality > entry.best_quality) {
+        entry.best_quality = face.quality;
+    }
+
+    if (user_id == -1 || user_id != entry.user_id) {
+        // 未识别或身份变化：重新累计
+        bool was_locked = entry.locked;
+        entry.locked = false;
+        entry.agree_count = (user_id == -1) ? 0 : 1;
+        entry.user_id = user_id;
+        entry.name = name;
+        entry.similarity = similarity;
+        if (was_locked) {
+            std::cout << "[IdentityCache] track " << face.track_id << " identity changed, unlocked" << std::endl;
+        }
+    } else {
+        entry.agree_count++;
+        entry.similarity = similarity;
+    }
+
+    if (entry.user_id == -1) return false;
+
+    if (entry.locked) {
+        // 复核通过
+        entry.verified_at = now;
+        return false;
+    }
+
+    if (similarity >= Config::Recognition::CONFIDENT_SIMILARITY ||
+        entry.agree_count >= Config::Default::RECOGNITION_CONFIRM_COUNT) {
+        entry.locked = true;
+        entry.verified_at = now;
+        if (entry.reported_user_id == entry.user_id) return false; // 本次到访已报告过该用户
+        entry.reported_user_id = entry.user_id;
+        return true;
+    }
+    return false;
+}
+
+void IdentityCache::begin_recognition(int track_id) {
+    if (track_id < 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[track_id].in_flight = true;
+}
+
+void IdentityCache::cancel_recognition(int track_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(track_id);
+    if (it != entries_.end()) {
+        it->second.in_flight = false;
+    }
+}
+
+bool IdentityCache::get_name(int track_id, std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(track_id);
+    if (it == entries_.end() || it->second.npu_calls == 0) return false;
+    name = it->second.name;
+    return true;
+}
+
+bool IdentityCache::is_locked(int track_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(track_id);
+    return it != entries_.end() && it->second.locked;
+}
+
+bool IdentityCache::get_feature(int track_id, Embedding& feature, float& quality) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(track_id);
+    if (it == entries_.end() || it->second.feature.empty()) return false;
+    feature = it->second.feature;
+    quality = it->second.feature_quality;
+    return true;
+}
+
+void IdentityCache::evict(const std::vector<int>& track_ids) {
+    if (track_ids.empty()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int id : track_ids) {
+        auto it = entries_.find(id);
+        if (it == entries_.end()) continue;
+
+        stat_visits_++;
+        stat_frames_ += it->second.frames;
+        stat_npu_calls_ += it->second.npu_calls;
+        entries_.erase(it);
+    }
+
+    if (stat_visits_ >= Config::Recognition::VISIT_REPORT_INTERVAL) {
+        std::cout << "[IdentityCache] visits: " << stat_visits_
+                  << ", FaceNet calls/visit: " << static_cast<double>(stat_npu_calls_) / stat_visits_
+                  << " (uncached: " << static_cast<double>(stat_frames_) / stat_visits_ << ")" << std::endl;
+        stat_visits_ = 0;
+        stat_frames_ = 0;
+        stat_npu_calls_ = 0;
+    }
+}
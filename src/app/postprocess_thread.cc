@@ -1,7 +1,8 @@
 /**
  * @file postprocess_thread.cc
  * @brief 后处理线程实现
- * @details 实现了基于流水线并行的后处理逻辑，将耗时的 NMS 和人脸识别从推理线程中分离。
+ * @details 实现了基于流水线并行的后处理逻辑，将耗时的 NMS 从推理线程中分离；
+ *          人脸识别进一步拆分到 RecognitionThread，检测框延迟不再随人脸数增加。
  */
 
 #include "app/postprocess_thread.h"
@@ -9,10 +10,6 @@
 #include <opencv2/imgproc.hpp>
 #include "config.h"
 #include "core/postprocess.h"
-#include "core/facenet.h"
-#include "service/feature_library.h"
-#include "service/attendance_service.h"
-#include "database/user_dao.h"
 #include <chrono>
 
 PostProcessThread::PostProcessThread(ModelManager* model_manager, PerformanceMonitor* monitor)
@@ -20,6 +17,9 @@ PostProcessThread::PostProcessThread(ModelManager* model_manager, PerformanceMon
     , monitor_(monitor)
     , running_(false)
     , has_new_result_(false)
+    , recognition_(model_manager, &identity_cache_)
+    , stat_frames_(0)
+    , stat_low_quality_(0)
 {
 }
 
@@ -30,6 +30,7 @@ PostProcessThread::~PostProcessThread() {
 void PostProcessThread::start() {
     if (running_) return;
     running_ = true;
+    recognition_.start();
     thread_ = std::thread(&PostProcessThread::thread_loop, this);
 }
 
@@ -39,6 +40,7 @@ void PostProcessThread::stop() {
     if (thread_.joinable()) {
         thread_.join();
     }
+    recognition_.stop();
 }
 
 void PostProcessThread::push_task(const PostProcessTask& task) {
@@ -53,17 +55,26 @@ void PostProcessThread::push_task(const PostProcessTask& task) {
 }
 
 bool PostProcessThread::get_latest_result(detect_result_group_t& result) {
-    std::lock_guard<std::mutex> lock(result_mutex_);
-    if (!has_new_result_) return false;
-    memcpy(&result, &latest_result_, sizeof(detect_result_group_t));
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        if (!has_new_result_) return false;
+        memcpy(&result, &latest_result_, sizeof(detect_result_group_t));
+    }
+
+    // 合并识别线程异步返回的身份
+    std::string name;
+    for (int i = 0; i < result.count; i++) {
+        detect_result_t& face = result.results[i];
+        if (face.track_id >= 0 && identity_cache_.get_name(face.track_id, name)) {
+            strncpy(face.name, name.c_str(), OBJ_NAME_MAX_SIZE - 1);
+            face.name[OBJ_NAME_MAX_SIZE - 1] = '\0';
+        }
+    }
     return true;
 }
 
-bool PostProcessThread::get_latest_feature(std::vector<float>& feature) {
-    std::lock_guard<std::mutex> lock(result_mutex_);
-    if (latest_feature_.empty()) return false;
-    feature = latest_feature_;
-    return true;
+bool PostProcessThread::get_latest_feature(Embedding& feature, float* quality) {
+    return recognition_.get_latest_feature(feature, quality);
 }
 
 void PostProcessThread::thread_loop() {
@@ -72,109 +83,119 @@ void PostProcessThread::thread_loop() {
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             queue_cv_.wait(lock, [this] { return !task_queue_.empty() || !running_; });
-            
             if (!running_) break;
-            
             task = task_queue_.front();
             task_queue_.pop();
         }
+        auto start = std::chrono::steady_clock::now();
 
-        auto t0 = std::chrono::steady_clock::now();
-
-        // 1. YOLOv8 Post-process (NMS, Box decoding)
+        // 1. YOLOv8 Post-process (NMS, Box decoding) + 跟踪 + 质量评估
         detect_result_group_t detect_result;
-        memset(&detect_result, 0, sizeof(detect_result));
-
-        int ret = yolov8_face_postprocess(
-            task.output_buffers,
-            model_manager_->get_face_detector_output_attrs(),
-            model_manager_->get_face_detector_io_num().n_output,
-            task.model_h, task.model_w, 
-            task.raw_task.orig_img.cols, task.raw_task.orig_img.rows,
-            BOX_THRESH, NMS_THRESH,
-            &detect_result
-        );
-
-        if (ret == 0) {
-            // 2. FaceNet Recognition & Search
-            int fn_w, fn_h, fn_c;
-            model_manager_->get_facenet_size(fn_w, fn_h, fn_c);
-
-            for (int i = 0; i < detect_result.count; i++) {
-                detect_result_t& face = detect_result.results[i];
-                
-                cv::Rect roi(face.box.left, face.box.top, 
-                             face.box.right - face.box.left, 
-                             face.box.bottom - face.box.top);
-                             
-                roi = roi & cv::Rect(0, 0, task.raw_task.orig_img.cols, task.raw_task.orig_img.rows);
-                if (roi.area() <= 0) continue;
-                
-                if (fn_w > 0 && fn_h > 0) {
-                    cv::Mat face_img = task.raw_task.orig_img(roi).clone();
-                    cv::Mat resized_face;
-                    cv::resize(face_img, resized_face, cv::Size(fn_w, fn_h));
-                    
-                    float* embedding = nullptr;
-                    int ret_fn = facenet_inference(
-                        model_manager_->get_facenet_ctx(),
-                        resized_face,
-                        model_manager_->get_facenet_io_num(),
-                        model_manager_->get_facenet_inputs(),
-                        model_manager_->get_facenet_outputs(),
-                        &embedding
-                    );
-                    
-                    if (ret_fn == 0 && embedding) {
-                        std::vector<float> feature(embedding, embedding + 512);
-                        
-                        // 注册用的特征缓存 (单人脸时)
-                        if (detect_result.count == 1) {
-                            std::lock_guard<std::mutex> lock(result_mutex_);
-                            latest_feature_ = feature;
-                        } else {
-                            std::lock_guard<std::mutex> lock(result_mutex_);
-                            latest_feature_.clear();
-                        }
-
-                        // 搜索
-                        float similarity = 0.0f;
-                        int64_t user_id = service::FeatureLibrary::instance().search(feature, FACENET_THRESH, similarity);
-                        
-                        if (user_id != -1) {
-                            db::UserDao userDao;
-                            auto user = userDao.get_user_by_id(user_id);
-                            if (user) {
-                                strncpy(face.name, user->user_name.c_str(), OBJ_NAME_MAX_SIZE - 1);
-                                service::AttendanceService attendanceService;
-                                attendanceService.record_attendance(user_id, similarity);
-                            }
-                        } else {
-                            strncpy(face.name, "Unknown", OBJ_NAME_MAX_SIZE - 1);
-                        }
-                        
-                        facenet_output_release(
-                            model_manager_->get_facenet_ctx(),
-                            model_manager_->get_facenet_io_num(),
-                            model_manager_->get_facenet_outputs()
-                        );
-                    }
-                }
+        RecognitionRequest request;
+        decode_frame(task, detect_result, request);
+
+        // 2. 立即发布检测框 (不等待识别)
+        publish(detect_result, start);
+
+        // 3. 需要识别的人脸交给识别线程
+        if (!request.faces.empty()) {
+            recognition_.push_request(std::move(request));
+        }
+    }
+}
+
+void PostProcessThread::decode_frame(const PostProcessTask& task, detect_result_group_t& detect_result,
+                                     RecognitionRequest& request) {
+    memset(&detect_result, 0, sizeof(detect_result));
+
+    int ret = yolov8_face_postprocess(
+        task.output_buffers,
+        model_manager_->get_face_detector_output_attrs(),
+        model_manager_->get_face_detector_io_num().n_output,
+        task.model_h, task.model_w,
+        task.raw_task.orig_img.cols, task.raw_task.orig_img.rows,
+        BOX_THRESH, NMS_THRESH,
+        &detect_result
+    );
+
+    // 跨帧关联，为每张人脸分配稳定的 track_id (解码失败时按空帧处理，使轨迹正常老化)
+    tracker_.update(&detect_result);
+    identity_cache_.evict(tracker_.removed_tracks());
+    if (ret != 0) return;
+
+    int fn_w, fn_h, fn_c;
+    model_manager_->get_facenet_size(fn_w, fn_h, fn_c);
+    if (fn_w <= 0 || fn_h <= 0) return;
+
+    // 只有单人脸时才可用于注册
+    bool single_face = (detect_result.count == 1);
+    if (!single_face) {
+        recognition_.set_latest_feature(Embedding(), 0.0f);
+    }
+
+    request.frame = task.raw_task.orig_img;
+    request.single_face = single_face;
+    request.start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < detect_result.count; i++) {
+        detect_result_t& face = detect_result.results[i];
+
+        cv::Rect roi(face.box.left, face.box.top,
+                     face.box.right - face.box.left,
+                     face.box.bottom - face.box.top);
+
+        roi = roi & cv::Rect(0, 0, task.raw_task.orig_img.cols, task.raw_task.orig_img.rows);
+        if (roi.area() <= 0) continue;
+
+        FaceQuality quality = quality_scorer_.evaluate(task.raw_task.orig_img, face);
+        face.quality = quality.score;
+
+        // 已锁定身份 (或识别请求在途) 的轨迹沿用缓存结果
+        if (!identity_cache_.need_recognition(face, request.start)) {
+            if (single_face) {
+                Embedding feature;
+                float feature_quality = 0.0f;
+                identity_cache_.get_feature(face.track_id, feature, feature_quality);
+                recognition_.set_latest_feature(feature, feature_quality);
             }
+            continue;
         }
 
-        // 3. Update Result
-        {
-            std::lock_guard<std::mutex> lock(result_mutex_);
-            latest_result_ = detect_result; 
-            has_new_result_ = true;
+        // 过小/模糊/侧脸不可能可靠匹配，不提取特征 (也不可用于注册)
+        if (!FaceQualityScorer::passes(quality)) {
+            stat_low_quality_++;
+            if (single_face) {
+                recognition_.set_latest_feature(Embedding(), 0.0f);
+            }
+            continue;
         }
 
-        // 4. Performance Monitor (PostProcess FPS)
-        if (monitor_) {
-             auto t1 = std::chrono::steady_clock::now();
-             double ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
-             monitor_->markPostProcess(ms); // Need to add this method to monitor
+        identity_cache_.begin_recognition(face.track_id);
+        request.faces.push_back(face);
+    }
+}
+
+void PostProcessThread::publish(const detect_result_group_t& detect_result, std::chrono::steady_clock::time_point start) {
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        latest_result_ = detect_result;
+        has_new_result_ = true;
+    }
+
+    // Performance Monitor (PostProcess FPS)
+    if (monitor_) {
+        auto t1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - start).count();
+        monitor_->markPostProcess(ms);
+    }
+
+    stat_frames_++;
+    if (stat_frames_ >= Config::Performance::REPORT_INTERVAL) {
+        if (stat_low_quality_ > 0) {
+            std::cout << "[PostProcess] faces skipped (low quality) in last " << stat_frames_
+                      << " frames: " << stat_low_quality_ << std::endl;
         }
+        stat_frames_ = 0;
+        stat_low_quality_ = 0;
     }
-}
\ No newline at end of file
+}
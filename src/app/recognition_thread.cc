@@ -0,0 +1,308 @@
+/**
+ * @file recognition_thread.cc
+ * @brief 人脸识别线程实现
+ * @details 从检测阶段拆分出的独立流水线级：检测框在 NMS 后立即发布，
+ *          FaceNet/检索/考勤在本线程异步完成，结果经 IdentityCache 合并回显示。
+ *          人脸多于一帧间隔内能处理的数量时，按优先级截断并把其余人脸顺延到后续帧。
+ */
+
+#include "app/recognition_thread.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include "config.h"
+#include "core/facenet_pool.h"
+#include "service/feature_library.h"
+#include "service/attendance_recorder.h"
+
+RecognitionThread::RecognitionThread(ModelManager* model_manager, IdentityCache* identity_cache)
+    : model_manager_(model_manager)
+    , identity_cache_(identity_cache)
+    , running_(false)
+    , latest_feature_quality_(0.0f)
+    , hot_gallery_(Config::Gallery::HOT_TIER_ENABLED ? Config::Gallery::HOT_MAX_TEMPLATES : 0)
+    , est_ms_per_face_(0.0)
+    , stat_batches_(0)
+    , stat_faces_(0)
+    , stat_dropped_(0)
+    , stat_deferred_(0)
+    , stat_shed_(0)
+    , stat_facenet_ms_(0.0)
+    , stat_latency_ms_(0.0)
+{
+}
+
+RecognitionThread::~RecognitionThread() {
+    stop();
+}
+
+void RecognitionThread::start() {
+    if (running_) return;
+    running_ = true;
+    thread_ = std::thread(&RecognitionThread::thread_loop, this);
+}
+
+void RecognitionThread::stop() {
+    running_ = false;
+    queue_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    for (const auto& request : queue_) {
+        cancel(request);
+    }
+    queue_.clear();
+}
+
+void RecognitionThread::push_request(RecognitionRequest&& request) {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    // 识别跟不上时丢弃最旧的请求 (对应轨迹之后会重新提交)
+    if (queue_.size() >= Config::Performance::RECOGNITION_QUEUE_MAX_SIZE) {
+        cancel(queue_.front());
+        queue_.pop_front();
+        stat_dropped_++;
+    }
+    queue_.push_back(std::move(request));
+    lock.unlock();
+    queue_cv_.notify_one();
+}
+
+bool RecognitionThread::get_latest_feature(Embedding& feature, float* quality) {
+    std::lock_guard<std::mutex> lock(feature_mutex_);
+    if (latest_feature_.empty()) return false;
+    feature = latest_feature_;
+    if (quality) *quality = latest_feature_quality_;
+    return true;
+}
+
+void RecognitionThread::set_latest_feature(const Embedding& feature, float quality) {
+    std::lock_guard<std::mutex> lock(feature_mutex_);
+    latest_feature_ = feature;
+    latest_feature_quality_ = quality;
+}
+
+void RecognitionThread::thread_loop() {
+    FaceNetPool* pool = model_manager_->get_facenet_pool();
+
+    while (running_) {
+        std::vector<RecognitionRequest> requests(1);
+        if (!pop_request(requests[0], nullptr)) break;
+        size_t face_count = requests[0].faces.size();
+
+        // 跨帧攒批：未装满时在截止时间内继续合并后续请求
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(Config::Performance::RECOGNITION_BATCH_DEADLINE_MS);
+        while (static_cast<int>(face_count) < pool->capacity()) {
+            RecognitionRequest next;
+            if (!pop_request(next, &deadline)) break;
+            face_count += next.faces.size();
+            requests.push_back(std::move(next));
+        }
+
+        shed_stale(requests, std::chrono::steady_clock::now());
+
+        std::vector<ScheduledFace> scheduled;
+        schedule(requests, scheduled);
+
+        std::vector<cv::Mat> crops;
+        prepare(requests, scheduled, crops);
+        recognize(requests, scheduled, crops);
+    }
+}
+
+bool RecognitionThread::pop_request(RecognitionRequest& request, const std::chrono::steady_clock::time_point* deadline) {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    auto ready = [this] { return !queue_.empty() || !running_; };
+    if (deadline) {
+        if (!queue_cv_.wait_until(lock, *deadline, ready)) return false;
+    } else {
+        queue_cv_.wait(lock, ready);
+    }
+
+    if (!running_ || queue_.empty()) return false;
+
+    request = std::move(queue_.front());
+    queue_.pop_front();
+    return true;
+}
+
+void RecognitionThread::shed_stale(std::vector<RecognitionRequest>& requests, std::chrono::steady_clock::time_point now) {
+    auto stale = [this, now](const RecognitionRequest& request) {
+        auto age = std::chrono::duration_cast<std::chrono::milliseconds>(now - request.start).count();
+        if (age <= Config::Performance::RECOGNITION_MAX_AGE_MS) return false;
+        // 迟到的身份对显示与考勤都已无意义，对应轨迹会在新帧中重新提交
+        cancel(request);
+        stat_shed_ += static_cast<int>(request.faces.size());
+        return true;
+    };
+    requests.erase(std::remove_if(requests.begin(), requests.end(), stale), requests.end());
+}
+
+void RecognitionThread::schedule(const std::vector<RecognitionRequest>& requests, std::vector<ScheduledFace>& scheduled) {
+    scheduled.clear();
+    for (size_t r = 0; r < requests.size(); r++) {
+        for (size_t f = 0; f < requests[r].faces.size(); f++) {
+            scheduled.push_back({r, f, priority(requests[r], requests[r].faces[f])});
+        }
+    }
+
+    // 本轮预算可容纳的人脸数 (尚无耗时估计时按批容量)
+    size_t budget = static_cast<size_t>(std::max(model_manager_->get_facenet_pool()->capacity(), 1));
+    if (est_ms_per_face_ > 0.0) {
+        size_t fit = static_cast<size_t>(Config::Performance::RECOGNITION_FRAME_BUDGET_MS / est_ms_per_face_);
+        budget = std::min(budget, std::max<size_t>(fit, 1));
+    }
+    if (scheduled.size() <= budget) return;
+
+    std::stable_sort(scheduled.begin(), scheduled.end(),
+                     [](const ScheduledFace& a, const ScheduledFace& b) { return a.priority > b.priority; });
+    for (size_t i = budget; i < scheduled.size(); i++) {
+        identity_cache_->cancel_recognition(requests[scheduled[i].request].faces[scheduled[i].face].track_id);
+    }
+    stat_deferred_ += static_cast<int>(scheduled.size() - budget);
+    scheduled.resize(budget);
+}
+
+float RecognitionThread::priority(const RecognitionRequest& request, const detect_result_t& face) {
+    float frame_w = static_cast<float>(std::max(request.frame.cols, 1));
+    float frame_h = static_cast<float>(std::max(request.frame.rows, 1));
+
+    // 尺寸项：人脸高度占画面高度的比例 [0, 1]
+    float size = std::min(1.0f, (face.box.bottom - face.box.top) / frame_h);
+
+    // 位置项：人脸中心离入口区域越近越大 [0, 1]
+    float dx = (face.box.left + face.box.right) * 0.5f / frame_w - Config::Recognition::ENTRY_ZONE_X;
+    float dy = (face.box.top + face.box.bottom) * 0.5f / frame_h - Config::Recognition::ENTRY_ZONE_Y;
+    float closeness = 1.0f - std::min(1.0f, std::sqrt(dx * dx + dy * dy));
+
+    float score = size + closeness;
+    if (!identity_cache_->is_locked(face.track_id)) {
+        score += Config::Recognition::PRIORITY_UNIDENTIFIED;
+    }
+    return score;
+}
+
+void RecognitionThread::prepare(const std::vector<RecognitionRequest>& requests, const std::vector<ScheduledFace>& scheduled,
+                                std::vector<cv::Mat>& crops) {
+    int fn_w, fn_h, fn_c;
+    model_manager_->get_facenet_size(fn_w, fn_h, fn_c);
+
+    for (const auto& item : scheduled) {
+        // 按 5 个关键点对齐，一次 warpAffine 从整帧写入复用的裁剪缓冲
+        cv::Mat& aligned = acquire_crop(crops.size(), fn_w, fn_h);
+        align_face(requests[item.request].frame, requests[item.request].faces[item.face].point, aligned);
+        crops.push_back(aligned);
+    }
+}
+
+cv::Mat& RecognitionThread::acquire_crop(size_t index, int width, int height) {
+    if (index >= crop_pool_.size()) {
+        crop_pool_.resize(index + 1);
+    }
+    // 尺寸/类型不变时 create() 不会重新分配
+    crop_pool_[index].create(height, width, CV_8UC3);
+    return crop_pool_[index];
+}
+
+void RecognitionThread::cancel(const RecognitionRequest& request) {
+    for (const auto& face : request.faces) {
+        identity_cache_->cancel_recognition(face.track_id);
+    }
+}
+
+void RecognitionThread::recognize(const std::vector<RecognitionRequest>& requests, const std::vector<ScheduledFace>& scheduled,
+                                  const std::vector<cv::Mat>& crops) {
+    if (crops.empty()) return;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Embedding>& features = features_;
+    model_manager_->get_facenet_pool()->extract(crops, features);
+    auto t1 = std::chrono::steady_clock::now();
+
+    double facenet_ms = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1000.0;
+    double ms_per_face = facenet_ms / crops.size();
+    est_ms_per_face_ = (est_ms_per_face_ > 0.0) ? est_ms_per_face_ * 0.8 + ms_per_face * 0.2 : ms_per_face;
+
+    // 整批一次检索 (取前两名：与第二名过于接近的匹配不可靠，按未识别处理)
+    // 先查最近匹配过的用户，热层不能判定的人脸再整批检索全库
+    std::vector<float> margins;
+    auto batch_matches = hot_gallery_.search_batch(features, 2, FACENET_THRESH, &margins);
+
+    for (size_t k = 0; k < scheduled.size(); k++) {
+        const RecognitionRequest& request = requests[scheduled[k].request];
+        const detect_result_t& face = request.faces[scheduled[k].face];
+        const Embedding& feature = features[k];
+        if (feature.empty()) {
+            identity_cache_->cancel_recognition(face.track_id);
+            continue;
+        }
+
+        // 注册用的特征缓存 (单人脸时)
+        if (request.single_face) {
+            set_latest_feature(feature, face.quality);
+        }
+
+        float similarity = 0.0f;
+        int64_t user_id = -1;
+        const auto& matches = batch_matches[k];
+        if (!matches.empty()) {
+            similarity = matches[0].similarity;
+            if (similarity >= FACENET_THRESH && margins[k] >= Config::Recognition::MATCH_MARGIN) {
+                user_id = matches[0].user_id;
+            }
+        }
+
+        // 显示信息取自内存用户表，热路径不访问数据库
+        std::string name = "Unknown";
+        service::UserInfo user;
+        if (user_id != -1) {
+            if (service::FeatureLibrary::instance().get_user(user_id, user)) {
+                name = user.name;
+                hot_gallery_.touch(user_id);
+            } else {
+                user_id = -1;
+            }
+        }
+
+        // 每次到访只在身份锁定时记录一次考勤 (异步落库，不阻塞识别)
+        if (identity_cache_->update(face, user_id, name, similarity, feature, t1)) {
+            service::AttendanceRecorder::instance().submit(user_id, similarity);
+        }
+    }
+
+    auto t2 = std::chrono::steady_clock::now();
+    stat_batches_++;
+    stat_faces_ += static_cast<int>(crops.size());
+    stat_facenet_ms_ += facenet_ms;
+    for (const auto& item : scheduled) {
+        stat_latency_ms_ += std::chrono::duration_cast<std::chrono::microseconds>(t2 - requests[item.request].start).count() / 1000.0;
+    }
+    if (stat_batches_ >= Config::Performance::REPORT_INTERVAL) {
+        std::cout << "[Recognition] FaceNet batches: " << stat_batches_
+                  << ", avg faces/batch: " << static_cast<double>(stat_faces_) / stat_batches_
+                  << ", avg ms/face: " << stat_facenet_ms_ / stat_faces_
+                  << ", avg identity latency ms: " << stat_latency_ms_ / stat_faces_
+                  << ", deferred faces: " << stat_deferred_
+                  << ", shed faces: " << stat_shed_
+                  << ", dropped requests: " << stat_dropped_ << std::endl;
+
+        service::HotGallery::Stats hot = hot_gallery_.take_stats();
+        if (hot.queries > 0) {
+            int misses = hot.queries - hot.hot_hits;
+            std::cout << "[Recognition] hot tier: " << hot_gallery_.user_count() << " users / "
+                      << hot_gallery_.template_count() << " templates, hit rate: "
+                      << 100.0 * hot.hot_hits / hot.queries << "%, hot scan us/query: "
+                      << hot.hot_ms * 1000.0 / hot.queries << ", full search us/miss: "
+                      << (misses > 0 ? hot.full_ms * 1000.0 / misses : 0.0) << std::endl;
+        }
+        stat_batches_ = 0;
+        stat_faces_ = 0;
+        stat_dropped_ = 0;
+        stat_deferred_ = 0;
+        stat_shed_ = 0;
+        stat_facenet_ms_ = 0.0;
+        stat_latency_ms_ = 0.0;
+    }
+}
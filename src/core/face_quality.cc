@@ -0,0 +1,75 @@
+/**
+ * @file face_quality.cc
+ * @brief 人脸质量评估实现
+ */
+
+#include "core/face_quality.h"
+#include "config.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const float RAD2DEG = 57.29578f;
+
+static inline float clamp01(float v) {
+    return std::max(0.0f, std::min(1.0f, v));
+}
+
+float FaceQualityScorer::blur_variance(const cv::Mat& img, const cv::Rect& roi) {
+    // 先缩放到固定小尺寸：耗时与人脸大小无关，且不同尺寸人脸的方差可比
+    cv::resize(img(roi), small_, cv::Size(Config::Quality::BLUR_SAMPLE_SIZE, Config::Quality::BLUR_SAMPLE_SIZE),
+               0, 0, cv::INTER_AREA);
+    cv::cvtColor(small_, gray_, cv::COLOR_BGR2GRAY);
+    cv::Laplacian(gray_, lap_, CV_16S, 3);
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(lap_, mean, stddev);
+    return (float)(stddev[0] * stddev[0]);
+}
+
+FaceQuality FaceQualityScorer::evaluate(const cv::Mat& img, const detect_result_t& face) {
+    FaceQuality q;
+    memset(&q, 0, sizeof(q));
+
+    // 1. 尺寸
+    int face_h = face.box.bottom - face.box.top;
+    q.size_score = clamp01((float)(face_h - Config::Quality::MIN_FACE_SIZE) /
+                           (Config::Quality::GOOD_FACE_SIZE - Config::Quality::MIN_FACE_SIZE));
+
+    // 2. 姿态：翻滚角取双眼连线角度；偏航角由鼻尖在双眼连线方向上的偏移估计
+    const KEY_POINT& p = face.point;
+    float dx = (float)(p.point_2_x - p.point_1_x);
+    float dy = (float)(p.point_2_y - p.point_1_y);
+    if (dx < 0) {
+        dx = -dx;
+        dy = -dy;
+    }
+    float eye_dist = std::sqrt(dx * dx + dy * dy);
+    if (eye_dist > 1.0f) {
+        float mid_x = (p.point_1_x + p.point_2_x) * 0.5f;
+        float mid_y = (p.point_1_y + p.point_2_y) * 0.5f;
+        float along = ((p.point_3_x - mid_x) * dx + (p.point_3_y - mid_y) * dy) / eye_dist;
+        float ratio = std::max(-1.0f, std::min(1.0f, along / (eye_dist * 0.5f)));
+        q.yaw = std::asin(ratio) * RAD2DEG;
+        q.roll = std::atan2(dy, dx) * RAD2DEG;
+        q.pose_score = clamp01(1.0f - std::fabs(q.yaw) / Config::Quality::MAX_YAW_DEG) *
+                       clamp01(1.0f - std::fabs(q.roll) / Config::Quality::MAX_ROLL_DEG);
+    }
+
+    // 3. 清晰度 (尺寸/姿态已不合格时不再计算)
+    cv::Rect roi(face.box.left, face.box.top, face.box.right - face.box.left, face.box.bottom - face.box.top);
+    roi &= cv::Rect(0, 0, img.cols, img.rows);
+    if (q.size_score > 0.0f && q.pose_score > 0.0f && roi.area() > 0) {
+        q.blur_var = blur_variance(img, roi);
+        q.blur_score = clamp01(q.blur_var / Config::Quality::BLUR_GOOD_VARIANCE);
+    }
+
+    // 4. 综合 (乘积：任一分项很差都会拉低总分)
+    q.score = q.size_score * q.pose_score * q.blur_score * face.prop;
+    return q;
+}
+
+bool FaceQualityScorer::passes(const FaceQuality& q) {
+    return q.score >= Config::Quality::MIN_SCORE;
+}
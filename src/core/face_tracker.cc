@@ -0,0 +1,194 @@
+/**
+ * @file face_tracker.cc
+ * @brief 多目标人脸跟踪器实现
+ * @details 每条轨迹对框的中心/宽/高分别做一维匀速卡尔曼滤波 (协方差为块对角，
+ *          与 SORT 的 8 维滤波等价但无需矩阵运算)。关联采用按 IoU 降序的贪心匹配，
+ *          单帧人脸数不超过 OBJ_NUMB_MAX_SIZE，开销可忽略。
+ */
+
+#include "core/face_tracker.h"
+#include "config.h"
+#include <algorithm>
+
+// 噪声按框高的比例设置，使大小人脸具有相同的相对容忍度
+static const float STD_POSITION = 1.0f / 20.0f;
+static const float STD_VELOCITY = 1.0f / 160.0f;
+
+static float box_iou(const BOX_RECT& a, const BOX_RECT& b) {
+    int xx1 = std::max(a.left, b.left);
+    int yy1 = std::max(a.top, b.top);
+    int xx2 = std::min(a.right, b.right);
+    int yy2 = std::min(a.bottom, b.bottom);
+    float iw = std::max(0, xx2 - xx1);
+    float ih = std::max(0, yy2 - yy1);
+    float inter = iw * ih;
+    float area_a = (float)(a.right - a.left) * (a.bottom - a.top);
+    float area_b = (float)(b.right - b.left) * (b.bottom - b.top);
+    float uni = area_a + area_b - inter;
+    return uni <= 0.f ? 0.f : inter / uni;
+}
+
+// ============================================
+// KalmanAxis
+// ============================================
+
+void FaceTracker::KalmanAxis::init(float z, float var) {
+    x = z;
+    v = 0.f;
+    p00 = var;
+    p01 = 0.f;
+    p11 = var;
+}
+
+void FaceTracker::KalmanAxis::predict(float q_pos, float q_vel) {
+    // x' = x + v, P' = F P F^T + Q
+    x += v;
+    p00 += 2.f * p01 + p11 + q_pos;
+    p01 += p11;
+    p11 += q_vel;
+}
+
+void FaceTracker::KalmanAxis::update(float z, float r) {
+    float s = p00 + r;
+    float k0 = p00 / s;
+    float k1 = p01 / s;
+    float y = z - x;
+    x += k0 * y;
+    v += k1 * y;
+    p11 -= k1 * p01;
+    p01 *= (1.f - k0);
+    p00 *= (1.f - k0);
+}
+
+// ============================================
+// FaceTracker
+// ============================================
+
+FaceTracker::FaceTracker()
+    : next_id_(0)
+{
+}
+
+void FaceTracker::reset() {
+    for (const auto& t : tracks_) {
+        removed_.push_back(t.id);
+    }
+    tracks_.clear();
+}
+
+void FaceTracker::predict(Track& track) {
+    float h = std::max(track.h.x, 1.f);
+    float q_pos = (STD_POSITION * h) * (STD_POSITION * h);
+    float q_vel = (STD_VELOCITY * h) * (STD_VELOCITY * h);
+    track.cx.predict(q_pos, q_vel);
+    track.cy.predict(q_pos, q_vel);
+    track.w.predict(q_pos, q_vel);
+    track.h.predict(q_pos, q_vel);
+
+    float half_w = std::max(track.w.x, 1.f) * 0.5f;
+    float half_h = std::max(track.h.x, 1.f) * 0.5f;
+    track.box.left = (int)(track.cx.x - half_w);
+    track.box.right = (int)(track.cx.x + half_w);
+    track.box.top = (int)(track.cy.x - half_h);
+    track.box.bottom = (int)(track.cy.x + half_h);
+}
+
+void FaceTracker::correct(Track& track, const BOX_RECT& box) {
+    float h = std::max((float)(box.bottom - box.top), 1.f);
+    float r = (STD_POSITION * h) * (STD_POSITION * h);
+    track.cx.update((box.left + box.right) * 0.5f, r);
+    track.cy.update((box.top + box.bottom) * 0.5f, r);
+    track.w.update((float)(box.right - box.left), r);
+    track.h.update((float)(box.bottom - box.top), r);
+    // 命中时直接使用检测框，滤波状态只用于下一帧预测
+    track.box = box;
+}
+
+void FaceTracker::start_track(detect_result_t& det) {
+    Track t;
+    t.id = next_id_++;
+    t.hits = 1;
+    t.lost_frames = 0;
+    t.state = (Config::Tracker::CONFIRM_HITS <= 1) ? TRACK_CONFIRMED : TRACK_NEW;
+    t.box = det.box;
+
+    float h = std::max((float)(det.box.bottom - det.box.top), 1.f);
+    float var = (2.f * STD_POSITION * h) * (2.f * STD_POSITION * h);
+    t.cx.init((det.box.left + det.box.right) * 0.5f, var);
+    t.cy.init((det.box.top + det.box.bottom) * 0.5f, var);
+    t.w.init((float)(det.box.right - det.box.left), var);
+    t.h.init((float)(det.box.bottom - det.box.top), var);
+    tracks_.push_back(t);
+
+    det.track_id = t.id;
+    det.track_state = t.state;
+}
+
+void FaceTracker::update(detect_result_group_t* group) {
+    removed_.clear();
+
+    // 1. 预测
+    for (auto& t : tracks_) {
+        predict(t);
+    }
+
+    // 2. IoU 贪心关联
+    struct Pair {
+        float iou;
+        int track;
+        int det;
+    };
+    std::vector<Pair> pairs;
+    for (int ti = 0; ti < (int)tracks_.size(); ++ti) {
+        for (int di = 0; di < group->count; ++di) {
+            float iou = box_iou(tracks_[ti].box, group->results[di].box);
+            if (iou >= Config::Tracker::IOU_THRESHOLD) {
+                pairs.push_back({iou, ti, di});
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b) { return a.iou > b.iou; });
+
+    std::vector<char> track_matched(tracks_.size(), 0);
+    std::vector<char> det_matched(group->count, 0);
+    for (const auto& p : pairs) {
+        if (track_matched[p.track] || det_matched[p.det]) continue;
+        track_matched[p.track] = 1;
+        det_matched[p.det] = 1;
+
+        Track& t = tracks_[p.track];
+        detect_result_t& det = group->results[p.det];
+        correct(t, det.box);
+        t.hits++;
+        t.lost_frames = 0;
+        if (t.state == TRACK_LOST || t.hits >= Config::Tracker::CONFIRM_HITS) {
+            t.state = TRACK_CONFIRMED;
+        }
+        det.track_id = t.id;
+        det.track_state = t.state;
+    }
+
+    // 3. 未命中的轨迹：未确认的直接删除，已确认的进入丢失状态
+    size_t keep = 0;
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        Track& t = tracks_[i];
+        if (!track_matched[i]) {
+            t.lost_frames++;
+            if (t.state == TRACK_NEW || t.lost_frames > Config::Tracker::MAX_LOST_FRAMES) {
+                removed_.push_back(t.id);
+                continue;
+            }
+            t.state = TRACK_LOST;
+        }
+        if (keep != i) tracks_[keep] = t;
+        keep++;
+    }
+    tracks_.resize(keep);
+
+    // 4. 未关联的检测开启新轨迹
+    for (int di = 0; di < group->count; ++di) {
+        if (!det_matched[di]) {
+            start_track(group->results[di]);
+        }
+    }
+}
@@ -183,22 +183,83 @@ int create_facenet(char *model_name, rknn_context *ctx, int &width, int &height,
   	return ret;
 }
 
-int facenet_inference(rknn_context *ctx, cv::Mat img, rknn_input_output_num io_num, rknn_input *inputs, rknn_output *outputs, float **result){
-    int ret;
-
-    // 直接使用 uint8 输入，/home/firefly/RK_NPU2_SDK/convert.py转换脚本，RKNN 会按 config 中的 mean/std 做归一化
-    inputs[0].buf = (void*)img.data;
-    inputs[0].size = img.total() * img.elemSize();  // uint8 尺寸
+int query_facenet_batch(rknn_context *ctx)
+{
+	rknn_tensor_attr input_attr;
+	memset(&input_attr, 0, sizeof(input_attr));
+	input_attr.index = 0;
+	int ret = rknn_query(*ctx, RKNN_QUERY_INPUT_ATTR, &input_attr, sizeof(rknn_tensor_attr));
+	if (ret < 0 || input_attr.n_dims < 4 || input_attr.dims[0] < 1) {
+		return 1;
+	}
+	return input_attr.dims[0];
+}
 
-    ret = rknn_inputs_set(*ctx, io_num.n_input, inputs);
+int query_facenet_output(rknn_context *ctx, bool raw, FaceNetOutputFormat &format)
+{
+	rknn_tensor_attr output_attr;
+	memset(&output_attr, 0, sizeof(output_attr));
+	output_attr.index = 0;
+	int ret = rknn_query(*ctx, RKNN_QUERY_OUTPUT_ATTR, &output_attr, sizeof(rknn_tensor_attr));
+	if (ret < 0) {
+		printf("rknn_query output attr error ret=%d\n", ret);
+		return ret;
+	}
+
+	format = FaceNetOutputFormat();
+	if (raw && output_attr.type == RKNN_TENSOR_FLOAT16) {
+		format.type = RKNN_TENSOR_FLOAT16;
+		format.size = output_attr.n_elems * sizeof(uint16_t);
+	} else if (raw && output_attr.type == RKNN_TENSOR_INT8 && output_attr.qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC) {
+		format.type = RKNN_TENSOR_INT8;
+		format.zp = output_attr.zp;
+		format.size = output_attr.n_elems * sizeof(int8_t);
+	} else {
+		format.size = output_attr.n_elems * sizeof(float);
+	}
+	return 0;
+}
 
-    ret = rknn_run(*ctx, NULL);
-    ret = rknn_outputs_get(*ctx, io_num.n_output, outputs, NULL);
-    result[0] = (float*)outputs[0].buf;
+int facenet_inference_batch(rknn_context *ctx, const uint8_t *input, size_t input_size, int batch, rknn_input_output_num io_num, rknn_input *inputs, rknn_output *outputs, const FaceNetOutputFormat &format, Embedding *result)
+{
+	int ret;
 
-    l2_normalize(result[0]);
+	inputs[0].buf = const_cast<uint8_t*>(input);
+	inputs[0].size = input_size;
+
+	ret = rknn_inputs_set(*ctx, io_num.n_input, inputs);
+	if (ret < 0) {
+		printf("rknn_inputs_set error ret=%d\n", ret);
+		return ret;
+	}
+	ret = rknn_run(*ctx, NULL);
+	if (ret < 0) {
+		printf("rknn_run error ret=%d\n", ret);
+		return ret;
+	}
+	ret = rknn_outputs_get(*ctx, io_num.n_output, outputs, NULL);
+	if (ret < 0) {
+		printf("rknn_outputs_get error ret=%d\n", ret);
+		return ret;
+	}
+
+	// 输出为 [batch, 512]：原始 FP16/INT8 输出转换、求模与归一化一次完成，直接写入 Embedding
+	for (int b = 0; b < batch; ++b) {
+		size_t offset = static_cast<size_t>(b) * FACENET_FEATURE_DIM;
+		switch (format.type) {
+		case RKNN_TENSOR_FLOAT16:
+			result[b].assign_f16((const uint16_t*)outputs[0].buf + offset);
+			break;
+		case RKNN_TENSOR_INT8:
+			result[b].assign_i8((const int8_t*)outputs[0].buf + offset, format.zp);
+			break;
+		default:
+			result[b].assign((const float*)outputs[0].buf + offset, FACENET_FEATURE_DIM);
+			break;
+		}
+	}
 
-    return ret;
+	return rknn_outputs_release(*ctx, io_num.n_output, outputs);
 }
 
 int facenet_output_release(rknn_context *ctx, rknn_input_output_num io_num, rknn_output *outputs)
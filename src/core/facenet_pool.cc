@@ -0,0 +1,235 @@
+/**
+ * @file facenet_pool.cc
+ * @brief FaceNet 批量推理池实现
+ * @details 调用线程本身作为第 0 个 worker (使用主上下文)，其余 worker 为常驻线程，
+ *          各自持有一个 rknn_dup_context 复制的上下文。一次 extract() 调用被切分为
+ *          若干个 batch 大小的 chunk，由所有 worker 竞争领取并行执行。
+ */
+
+#include "core/facenet_pool.h"
+#include "core/facenet.h"
+#include "core/postprocess.h"
+#include "config.h"
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+// 多上下文时每个上下文绑定一个独立 NPU 核心
+static const rknn_core_mask CORE_MASKS[] = {RKNN_NPU_CORE_0, RKNN_NPU_CORE_1, RKNN_NPU_CORE_2};
+static const int NUM_CORE_MASKS = sizeof(CORE_MASKS) / sizeof(CORE_MASKS[0]);
+
+FaceNetPool::FaceNetPool()
+    : width_(0)
+    , height_(0)
+    , channel_(0)
+    , batch_(1)
+    , job_crops_(nullptr)
+    , job_features_(nullptr)
+    , job_next_chunk_(0)
+    , job_num_chunks_(0)
+    , job_running_(0)
+    , job_ret_(0)
+    , stopping_(false)
+{
+    memset(&io_num_, 0, sizeof(io_num_));
+}
+
+FaceNetPool::~FaceNetPool() {
+    release();
+}
+
+int FaceNetPool::init(rknn_context* ctx, int width, int height, int channel,
+                      const rknn_input_output_num& io_num, int num_contexts) {
+    if (is_initialized()) {
+        std::cerr << "FaceNetPool already initialized" << std::endl;
+        return -1;
+    }
+
+    width_ = width;
+    height_ = height;
+    channel_ = channel;
+    io_num_ = io_num;
+    batch_ = query_facenet_batch(ctx);
+    num_contexts = std::max(1, num_contexts);
+
+    size_t input_size = static_cast<size_t>(batch_) * width_ * height_ * channel_;
+    if (query_facenet_output(ctx, Config::Model::FACENET_RAW_OUTPUT, output_format_) < 0) {
+        return -1;
+    }
+
+    workers_.resize(num_contexts);
+    for (int i = 0; i < num_contexts; ++i) {
+        Worker& w = workers_[i];
+        if (i == 0) {
+            w.ctx = *ctx;
+            w.owns_ctx = false;
+        } else {
+            int ret = rknn_dup_context(ctx, &w.ctx);
+            if (ret < 0) {
+                std::cerr << "rknn_dup_context failed (ret=" << ret << "), FaceNet contexts: " << i << std::endl;
+                workers_.resize(i);
+                break;
+            }
+            w.owns_ctx = true;
+        }
+
+        if (num_contexts > 1) {
+            int ret = rknn_set_core_mask(w.ctx, CORE_MASKS[i % NUM_CORE_MASKS]);
+            if (ret < 0) {
+                std::cerr << "rknn_set_core_mask failed for FaceNet context " << i << std::endl;
+            }
+        }
+
+        memset(&w.input, 0, sizeof(w.input));
+        w.input.index = 0;
+        w.input.type = RKNN_TENSOR_UINT8;
+        w.input.fmt = RKNN_TENSOR_NHWC;
+        w.input.size = input_size;
+        w.input.pass_through = 0;
+
+        w.outputs.resize(io_num_.n_output);
+        memset(w.outputs.data(), 0, sizeof(rknn_output) * io_num_.n_output);
+        for (auto& out : w.outputs) {
+            out.want_float = 1;
+        }
+        // 特征输出按原始类型写入预分配缓冲 (每次推理不再分配、也不经过运行时的 float 转换)
+        w.output_buf.assign(output_format_.size, 0);
+        w.outputs[0].index = 0;
+        w.outputs[0].want_float = (output_format_.type == RKNN_TENSOR_FLOAT32);
+        w.outputs[0].is_prealloc = 1;
+        w.outputs[0].buf = w.output_buf.data();
+        w.outputs[0].size = output_format_.size;
+
+        w.input_buf.assign(input_size, 0);
+        w.result_buf.resize(batch_);
+        w.slot_valid.assign(batch_, 0);
+    }
+
+    stopping_ = false;
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        workers_[i].thread = std::thread(&FaceNetPool::worker_loop, this, static_cast<int>(i));
+    }
+
+    const char* output_type = output_format_.type == RKNN_TENSOR_FLOAT16 ? "fp16"
+                            : output_format_.type == RKNN_TENSOR_INT8 ? "int8" : "float";
+    std::cout << "FaceNetPool initialized: batch=" << batch_
+              << ", contexts=" << workers_.size() << ", output=" << output_type << std::endl;
+    return 0;
+}
+
+void FaceNetPool::release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    job_cv_.notify_all();
+
+    for (auto& w : workers_) {
+        if (w.thread.joinable()) {
+            w.thread.join();
+        }
+        if (w.owns_ctx) {
+            rknn_destroy(w.ctx);
+        }
+    }
+    workers_.clear();
+}
+
+int FaceNetPool::extract(const std::vector<cv::Mat>& crops, std::vector<Embedding>& features) {
+    features.resize(crops.size());
+    for (auto& f : features) f.clear();
+    if (crops.empty()) return 0;
+    if (workers_.empty()) return -1;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_crops_ = &crops;
+    job_features_ = &features;
+    job_next_chunk_ = 0;
+    job_num_chunks_ = (static_cast<int>(crops.size()) + batch_ - 1) / batch_;
+    job_running_ = 0;
+    job_ret_ = 0;
+    bool parallel = workers_.size() > 1 && job_num_chunks_ > 1;
+    lock.unlock();
+
+    if (parallel) {
+        job_cv_.notify_all();
+    }
+
+    // 调用线程作为 worker 0 参与执行
+    drain_chunks(workers_[0]);
+
+    lock.lock();
+    done_cv_.wait(lock, [this] { return job_next_chunk_ >= job_num_chunks_ && job_running_ == 0; });
+    int ret = job_ret_;
+    job_crops_ = nullptr;
+    job_features_ = nullptr;
+    return ret;
+}
+
+void FaceNetPool::worker_loop(int index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        job_cv_.wait(lock, [this] {
+            return stopping_ || (job_crops_ != nullptr && job_next_chunk_ < job_num_chunks_);
+        });
+        if (stopping_) break;
+
+        lock.unlock();
+        drain_chunks(workers_[index]);
+        lock.lock();
+    }
+}
+
+void FaceNetPool::drain_chunks(Worker& worker) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (job_crops_ != nullptr && job_next_chunk_ < job_num_chunks_) {
+        int chunk = job_next_chunk_++;
+        job_running_++;
+        int total = static_cast<int>(job_crops_->size());
+        lock.unlock();
+
+        int first = chunk * batch_;
+        int count = std::min(batch_, total - first);
+        int ret = run_chunk(worker, first, count);
+
+        lock.lock();
+        job_running_--;
+        if (ret != 0) {
+            job_ret_ = ret;
+        }
+    }
+    if (job_running_ == 0) {
+        done_cv_.notify_all();
+    }
+}
+
+int FaceNetPool::run_chunk(Worker& worker, int first, int count) {
+    const std::vector<cv::Mat>& crops = *job_crops_;
+    size_t image_size = static_cast<size_t>(width_) * height_ * channel_;
+
+    // 打包 batch 输入，不足 batch 的部分补零
+    for (int i = 0; i < batch_; ++i) {
+        uint8_t* dst = worker.input_buf.data() + i * image_size;
+        const cv::Mat* crop = (i < count) ? &crops[first + i] : nullptr;
+        bool ok = crop && crop->isContinuous() && crop->total() * crop->elemSize() == image_size;
+        if (ok) {
+            memcpy(dst, crop->data, image_size);
+        } else {
+            memset(dst, 0, image_size);
+        }
+        worker.slot_valid[i] = ok;
+    }
+
+    int ret = facenet_inference_batch(&worker.ctx, worker.input_buf.data(), worker.input_buf.size(), batch_,
+                                      io_num_, &worker.input, worker.outputs.data(), output_format_,
+                                      worker.result_buf.data());
+    if (ret < 0) {
+        return ret;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (!worker.slot_valid[i]) continue;
+        (*job_features_)[first + i] = worker.result_buf[i];
+    }
+    return 0;
+}
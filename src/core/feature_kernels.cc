@@ -0,0 +1,551 @@
+/**
+ * @file feature_kernels.cc
+ * @brief 特征向量 SIMD 计算核实现
+ */
+
+#include "core/feature_kernels.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FEATURE_KERNEL_NEON 1
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define FEATURE_KERNEL_AVX2 1
+#if defined(__F16C__)
+#define FEATURE_KERNEL_F16C 1
+#endif
+#endif
+
+const char* feature_kernel_isa() {
+#if defined(FEATURE_KERNEL_NEON) && defined(__ARM_FEATURE_DOTPROD)
+    return "neon+dotprod";
+#elif defined(FEATURE_KERNEL_NEON)
+    return "neon";
+#elif defined(FEATURE_KERNEL_F16C)
+    return "avx2+f16c";
+#elif defined(FEATURE_KERNEL_AVX2)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+#if defined(FEATURE_KERNEL_AVX2)
+static inline float hsum256(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+    return _mm_cvtss_f32(lo);
+}
+#endif
+
+float feature_dot(const float* a, const float* b, int dim) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(FEATURE_KERNEL_NEON)
+    // 两组累加器隐藏 FMA 延迟
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= dim; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#elif defined(FEATURE_KERNEL_AVX2)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    sum = hsum256(_mm256_add_ps(acc0, acc1));
+#endif
+    for (; i < dim; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void feature_dot_rows(const float* query, const float* rows, size_t stride, int count, int dim, float* out) {
+    int r = 0;
+#if defined(FEATURE_KERNEL_NEON)
+    int vec_dim = dim & ~3;
+    for (; r + 4 <= count; r += 4) {
+        const float* r0 = rows + r * stride;
+        const float* r1 = r0 + stride;
+        const float* r2 = r1 + stride;
+        const float* r3 = r2 + stride;
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        float32x4_t acc2 = vdupq_n_f32(0.0f);
+        float32x4_t acc3 = vdupq_n_f32(0.0f);
+        for (int i = 0; i < vec_dim; i += 4) {
+            float32x4_t q = vld1q_f32(query + i);
+            acc0 = vfmaq_f32(acc0, vld1q_f32(r0 + i), q);
+            acc1 = vfmaq_f32(acc1, vld1q_f32(r1 + i), q);
+            acc2 = vfmaq_f32(acc2, vld1q_f32(r2 + i), q);
+            acc3 = vfmaq_f32(acc3, vld1q_f32(r3 + i), q);
+        }
+        float s0 = vaddvq_f32(acc0), s1 = vaddvq_f32(acc1);
+        float s2 = vaddvq_f32(acc2), s3 = vaddvq_f32(acc3);
+        for (int i = vec_dim; i < dim; i++) {
+            s0 += r0[i] * query[i];
+            s1 += r1[i] * query[i];
+            s2 += r2[i] * query[i];
+            s3 += r3[i] * query[i];
+        }
+        out[r] = s0; out[r + 1] = s1; out[r + 2] = s2; out[r + 3] = s3;
+    }
+#elif defined(FEATURE_KERNEL_AVX2)
+    int vec_dim = dim & ~7;
+    for (; r + 4 <= count; r += 4) {
+        const float* r0 = rows + r * stride;
+        const float* r1 = r0 + stride;
+        const float* r2 = r1 + stride;
+        const float* r3 = r2 + stride;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        for (int i = 0; i < vec_dim; i += 8) {
+            __m256 q = _mm256_loadu_ps(query + i);
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(r0 + i), q, acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(r1 + i), q, acc1);
+            acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(r2 + i), q, acc2);
+            acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(r3 + i), q, acc3);
+        }
+        float s0 = hsum256(acc0), s1 = hsum256(acc1);
+        float s2 = hsum256(acc2), s3 = hsum256(acc3);
+        for (int i = vec_dim; i < dim; i++) {
+            s0 += r0[i] * query[i];
+            s1 += r1[i] * query[i];
+            s2 += r2[i] * query[i];
+            s3 += r3[i] * query[i];
+        }
+        out[r] = s0; out[r + 1] = s1; out[r + 2] = s2; out[r + 3] = s3;
+    }
+#endif
+    for (; r < count; r++) {
+        out[r] = feature_dot(query, rows + r * stride, dim);
+    }
+}
+
+void feature_dot_rows_multi(const float* queries, size_t q_stride, int nq,
+                            const float* rows, size_t stride, int count, int dim, float* out) {
+    int q = 0;
+#if defined(FEATURE_KERNEL_NEON) || defined(FEATURE_KERNEL_AVX2)
+    for (; q + 2 <= nq; q += 2) {
+        const float* qa = queries + q * q_stride;
+        const float* qb = qa + q_stride;
+        float* out_a = out + q * count;
+        float* out_b = out_a + count;
+
+        int r = 0;
+        for (; r + 4 <= count; r += 4) {
+            const float* r0 = rows + r * stride;
+            const float* r1 = r0 + stride;
+            const float* r2 = r1 + stride;
+            const float* r3 = r2 + stride;
+            float sa[4], sb[4];
+#if defined(FEATURE_KERNEL_NEON)
+            int vec_dim = dim & ~3;
+            float32x4_t a0 = vdupq_n_f32(0.0f), a1 = vdupq_n_f32(0.0f), a2 = vdupq_n_f32(0.0f), a3 = vdupq_n_f32(0.0f);
+            float32x4_t b0 = vdupq_n_f32(0.0f), b1 = vdupq_n_f32(0.0f), b2 = vdupq_n_f32(0.0f), b3 = vdupq_n_f32(0.0f);
+            for (int i = 0; i < vec_dim; i += 4) {
+                float32x4_t va = vld1q_f32(qa + i);
+                float32x4_t vb = vld1q_f32(qb + i);
+                float32x4_t x0 = vld1q_f32(r0 + i);
+                float32x4_t x1 = vld1q_f32(r1 + i);
+                float32x4_t x2 = vld1q_f32(r2 + i);
+                float32x4_t x3 = vld1q_f32(r3 + i);
+                a0 = vfmaq_f32(a0, x0, va); b0 = vfmaq_f32(b0, x0, vb);
+                a1 = vfmaq_f32(a1, x1, va); b1 = vfmaq_f32(b1, x1, vb);
+                a2 = vfmaq_f32(a2, x2, va); b2 = vfmaq_f32(b2, x2, vb);
+                a3 = vfmaq_f32(a3, x3, va); b3 = vfmaq_f32(b3, x3, vb);
+            }
+            sa[0] = vaddvq_f32(a0); sa[1] = vaddvq_f32(a1); sa[2] = vaddvq_f32(a2); sa[3] = vaddvq_f32(a3);
+            sb[0] = vaddvq_f32(b0); sb[1] = vaddvq_f32(b1); sb[2] = vaddvq_f32(b2); sb[3] = vaddvq_f32(b3);
+#else
+            int vec_dim = dim & ~7;
+            __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+            __m256 b0 = _mm256_setzero_ps(), b1 = _mm256_setzero_ps(), b2 = _mm256_setzero_ps(), b3 = _mm256_setzero_ps();
+            for (int i = 0; i < vec_dim; i += 8) {
+                __m256 va = _mm256_loadu_ps(qa + i);
+                __m256 vb = _mm256_loadu_ps(qb + i);
+                __m256 x0 = _mm256_loadu_ps(r0 + i);
+                __m256 x1 = _mm256_loadu_ps(r1 + i);
+                a0 = _mm256_fmadd_ps(x0, va, a0); b0 = _mm256_fmadd_ps(x0, vb, b0);
+                a1 = _mm256_fmadd_ps(x1, va, a1); b1 = _mm256_fmadd_ps(x1, vb, b1);
+                __m256 x2 = _mm256_loadu_ps(r2 + i);
+                __m256 x3 = _mm256_loadu_ps(r3 + i);
+                a2 = _mm256_fmadd_ps(x2, va, a2); b2 = _mm256_fmadd_ps(x2, vb, b2);
+                a3 = _mm256_fmadd_ps(x3, va, a3); b3 = _mm256_fmadd_ps(x3, vb, b3);
+            }
+            sa[0] = hsum256(a0); sa[1] = hsum256(a1); sa[2] = hsum256(a2); sa[3] = hsum256(a3);
+            sb[0] = hsum256(b0); sb[1] = hsum256(b1); sb[2] = hsum256(b2); sb[3] = hsum256(b3);
+#endif
+            const float* rr[4] = {r0, r1, r2, r3};
+            for (int j = 0; j < 4; j++) {
+                for (int i = vec_dim; i < dim; i++) {
+                    sa[j] += rr[j][i] * qa[i];
+                    sb[j] += rr[j][i] * qb[i];
+                }
+                out_a[r + j] = sa[j];
+                out_b[r + j] = sb[j];
+            }
+        }
+        for (; r < count; r++) {
+            out_a[r] = feature_dot(qa, rows + r * stride, dim);
+            out_b[r] = feature_dot(qb, rows + r * stride, dim);
+        }
+    }
+#endif
+    for (; q < nq; q++) {
+        feature_dot_rows(queries + q * q_stride, rows, stride, count, dim, out + q * count);
+    }
+}
+
+// v 除以模长 norm (模长过小时不做处理)，返回 norm
+static float scale_to_unit(float* v, int dim, float norm) {
+    if (norm > 1e-6f) {
+        float inv = 1.0f / norm;
+        for (int i = 0; i < dim; i++) {
+            v[i] *= inv;
+        }
+    }
+    return norm;
+}
+
+float feature_normalize(float* v, int dim) {
+    return scale_to_unit(v, dim, std::sqrt(feature_dot(v, v, dim)));
+}
+
+// 标量半精度转换 (无 SIMD 转换指令时及向量化循环的尾部)
+static inline float half_to_float(uint16_t h) {
+    uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    uint32_t exp = (h >> 10) & 0x1fu;
+    uint32_t mant = h & 0x3ffu;
+    uint32_t bits;
+    if (exp == 0) {
+        float f = mant * (1.0f / 16777216.0f); // 零与非规格化数：mant × 2^-24
+        return sign ? -f : f;
+    } else if (exp == 31) {
+        bits = sign | 0x7f800000u | (mant << 13); // Inf / NaN
+    } else {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline uint16_t float_to_half(float f) {
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+    uint16_t sign = static_cast<uint16_t>((x >> 16) & 0x8000u);
+    uint32_t abs = x & 0x7fffffffu;
+    if (abs > 0x7f800000u) return sign | 0x7e00u;      // NaN
+    if (abs >= 0x477ff000u) return sign | 0x7c00u;     // 舍入后超出半精度范围 (>= 65520)
+    if (abs < 0x38800000u) {                           // 半精度的非规格化数 (< 2^-14)
+        float v;
+        memcpy(&v, &abs, sizeof(v));
+        return sign | static_cast<uint16_t>(std::nearbyint(v * 16777216.0f));
+    }
+    abs += 0xfffu + ((abs >> 13) & 1u);                // 就近舍入到偶数，进位可进入指数
+    return sign | static_cast<uint16_t>((abs - 0x38000000u) >> 13);
+}
+
+float feature_normalize_f16(const uint16_t* in, int dim, float* out) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(FEATURE_KERNEL_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= dim; i += 8) {
+        float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(in + i));
+        float32x4_t lo = vcvt_f32_f16(vget_low_f16(h));
+        float32x4_t hi = vcvt_high_f32_f16(h);
+        vst1q_f32(out + i, lo);
+        vst1q_f32(out + i + 4, hi);
+        acc0 = vfmaq_f32(acc0, lo, lo);
+        acc1 = vfmaq_f32(acc1, hi, hi);
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#elif defined(FEATURE_KERNEL_F16C)
+    // 两组累加器隐藏 FMA 延迟
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= dim; i += 16) {
+        __m256 v0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        __m256 v1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8)));
+        _mm256_storeu_ps(out + i, v0);
+        _mm256_storeu_ps(out + i + 8, v1);
+        acc0 = _mm256_fmadd_ps(v0, v0, acc0);
+        acc1 = _mm256_fmadd_ps(v1, v1, acc1);
+    }
+    sum = hsum256(_mm256_add_ps(acc0, acc1));
+#endif
+    for (; i < dim; i++) {
+        out[i] = half_to_float(in[i]);
+        sum += out[i] * out[i];
+    }
+    return scale_to_unit(out, dim, std::sqrt(sum));
+}
+
+float feature_normalize_i8(const int8_t* in, int32_t zp, int dim, float* out) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(FEATURE_KERNEL_NEON)
+    // (q - zp) 在 [-255, 255] 内，先在 int16 中相减
+    int16x8_t vzp = vdupq_n_s16(static_cast<int16_t>(zp));
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= dim; i += 8) {
+        int16x8_t d = vsubq_s16(vmovl_s8(vld1_s8(in + i)), vzp);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(d)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_high_s16(d));
+        vst1q_f32(out + i, lo);
+        vst1q_f32(out + i + 4, hi);
+        acc0 = vfmaq_f32(acc0, lo, lo);
+        acc1 = vfmaq_f32(acc1, hi, hi);
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#elif defined(FEATURE_KERNEL_AVX2)
+    __m256i vzp = _mm256_set1_epi32(zp);
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= dim; i += 16) {
+        __m256i q0 = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+        __m256i q1 = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i + 8)));
+        __m256 v0 = _mm256_cvtepi32_ps(_mm256_sub_epi32(q0, vzp));
+        __m256 v1 = _mm256_cvtepi32_ps(_mm256_sub_epi32(q1, vzp));
+        _mm256_storeu_ps(out + i, v0);
+        _mm256_storeu_ps(out + i + 8, v1);
+        acc0 = _mm256_fmadd_ps(v0, v0, acc0);
+        acc1 = _mm256_fmadd_ps(v1, v1, acc1);
+    }
+    sum = hsum256(_mm256_add_ps(acc0, acc1));
+#endif
+    for (; i < dim; i++) {
+        out[i] = static_cast<float>(in[i] - zp);
+        sum += out[i] * out[i];
+    }
+    return scale_to_unit(out, dim, std::sqrt(sum));
+}
+
+void feature_f32_to_f16(const float* in, int dim, uint16_t* out) {
+    int i = 0;
+#if defined(FEATURE_KERNEL_NEON)
+    for (; i + 4 <= dim; i += 4) {
+        vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+    }
+#elif defined(FEATURE_KERNEL_F16C)
+    for (; i + 8 <= dim; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), h);
+    }
+#endif
+    for (; i < dim; i++) {
+        out[i] = float_to_half(in[i]);
+    }
+}
+
+void feature_f16_to_f32(const uint16_t* in, int dim, float* out) {
+    int i = 0;
+#if defined(FEATURE_KERNEL_NEON)
+    for (; i + 4 <= dim; i += 4) {
+        vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i))));
+    }
+#elif defined(FEATURE_KERNEL_F16C)
+    for (; i + 8 <= dim; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+    }
+#endif
+    for (; i < dim; i++) {
+        out[i] = half_to_float(in[i]);
+    }
+}
+
+// float 查询与一行半精度向量的点积
+static float dot_f16(const float* query, const uint16_t* row, int dim) {
+    int i = 0;
+    float sum = 0.0f;
+#if defined(FEATURE_KERNEL_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= dim; i += 8) {
+        float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(row + i));
+        acc0 = vfmaq_f32(acc0, vcvt_f32_f16(vget_low_f16(h)), vld1q_f32(query + i));
+        acc1 = vfmaq_f32(acc1, vcvt_high_f32_f16(h), vld1q_f32(query + i + 4));
+    }
+    sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+#elif defined(FEATURE_KERNEL_F16C)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= dim; i += 16) {
+        __m256 v0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)));
+        __m256 v1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i + 8)));
+        acc0 = _mm256_fmadd_ps(v0, _mm256_loadu_ps(query + i), acc0);
+        acc1 = _mm256_fmadd_ps(v1, _mm256_loadu_ps(query + i + 8), acc1);
+    }
+    sum = hsum256(_mm256_add_ps(acc0, acc1));
+#endif
+    for (; i < dim; i++) {
+        sum += half_to_float(row[i]) * query[i];
+    }
+    return sum;
+}
+
+void feature_dot_rows_f16(const float* query, const uint16_t* rows, size_t stride, int count, int dim, float* out) {
+    int r = 0;
+#if defined(FEATURE_KERNEL_NEON) || defined(FEATURE_KERNEL_F16C)
+    int vec_dim = dim & ~7;
+    for (; r + 4 <= count; r += 4) {
+        const uint16_t* r0 = rows + r * stride;
+        const uint16_t* r1 = r0 + stride;
+        const uint16_t* r2 = r1 + stride;
+        const uint16_t* r3 = r2 + stride;
+        float s[4];
+#if defined(FEATURE_KERNEL_NEON)
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        float32x4_t acc2 = vdupq_n_f32(0.0f);
+        float32x4_t acc3 = vdupq_n_f32(0.0f);
+        for (int i = 0; i < vec_dim; i += 8) {
+            float32x4_t qlo = vld1q_f32(query + i);
+            float32x4_t qhi = vld1q_f32(query + i + 4);
+            float16x8_t h0 = vreinterpretq_f16_u16(vld1q_u16(r0 + i));
+            float16x8_t h1 = vreinterpretq_f16_u16(vld1q_u16(r1 + i));
+            float16x8_t h2 = vreinterpretq_f16_u16(vld1q_u16(r2 + i));
+            float16x8_t h3 = vreinterpretq_f16_u16(vld1q_u16(r3 + i));
+            acc0 = vfmaq_f32(vfmaq_f32(acc0, vcvt_f32_f16(vget_low_f16(h0)), qlo), vcvt_high_f32_f16(h0), qhi);
+            acc1 = vfmaq_f32(vfmaq_f32(acc1, vcvt_f32_f16(vget_low_f16(h1)), qlo), vcvt_high_f32_f16(h1), qhi);
+            acc2 = vfmaq_f32(vfmaq_f32(acc2, vcvt_f32_f16(vget_low_f16(h2)), qlo), vcvt_high_f32_f16(h2), qhi);
+            acc3 = vfmaq_f32(vfmaq_f32(acc3, vcvt_f32_f16(vget_low_f16(h3)), qlo), vcvt_high_f32_f16(h3), qhi);
+        }
+        s[0] = vaddvq_f32(acc0); s[1] = vaddvq_f32(acc1); s[2] = vaddvq_f32(acc2); s[3] = vaddvq_f32(acc3);
+#else
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        for (int i = 0; i < vec_dim; i += 8) {
+            __m256 q = _mm256_loadu_ps(query + i);
+            acc0 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r0 + i))), q, acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r1 + i))), q, acc1);
+            acc2 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r2 + i))), q, acc2);
+            acc3 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r3 + i))), q, acc3);
+        }
+        s[0] = hsum256(acc0); s[1] = hsum256(acc1); s[2] = hsum256(acc2); s[3] = hsum256(acc3);
+#endif
+        const uint16_t* rr[4] = {r0, r1, r2, r3};
+        for (int j = 0; j < 4; j++) {
+            for (int i = vec_dim; i < dim; i++) {
+                s[j] += half_to_float(rr[j][i]) * query[i];
+            }
+            out[r + j] = s[j];
+        }
+    }
+#endif
+    for (; r < count; r++) {
+        out[r] = dot_f16(query, rows + r * stride, dim);
+    }
+}
+
+float feature_quantize_i8(const float* v, int dim, int8_t* out) {
+    float max_abs = 0.0f;
+    for (int i = 0; i < dim; i++) {
+        max_abs = std::max(max_abs, std::fabs(v[i]));
+    }
+    if (max_abs < 1e-12f) {
+        std::fill(out, out + dim, 0);
+        return 0.0f;
+    }
+
+    float scale = max_abs / 127.0f;
+    float inv = 1.0f / scale;
+    for (int i = 0; i < dim; i++) {
+        int q = static_cast<int>(std::lround(v[i] * inv));
+        out[i] = static_cast<int8_t>(std::max(-127, std::min(127, q)));
+    }
+    return scale;
+}
+
+int32_t feature_dot_i8(const int8_t* a, const int8_t* b, int dim) {
+    int i = 0;
+    int32_t sum = 0;
+#if defined(FEATURE_KERNEL_NEON) && defined(__ARM_FEATURE_DOTPROD)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (; i + 16 <= dim; i += 16) {
+        acc = vdotq_s32(acc, vld1q_s8(a + i), vld1q_s8(b + i));
+    }
+    sum = vaddvq_s32(acc);
+#elif defined(FEATURE_KERNEL_NEON)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (; i + 16 <= dim; i += 16) {
+        int8x16_t va = vld1q_s8(a + i);
+        int8x16_t vb = vld1q_s8(b + i);
+        // 两个 int8 乘积之和不超过 int16 范围 (|q| <= 127)
+        int16x8_t p = vmull_s8(vget_low_s8(va), vget_low_s8(vb));
+        p = vmlal_s8(p, vget_high_s8(va), vget_high_s8(vb));
+        acc = vpadalq_s16(acc, p);
+    }
+    sum = vaddvq_s32(acc);
+#elif defined(FEATURE_KERNEL_AVX2)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 16 <= dim; i += 16) {
+        __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm_cvtsi128_si32(s);
+#endif
+    for (; i < dim; i++) {
+        sum += static_cast<int32_t>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+void feature_dot_rows_i8(const int8_t* query, const int8_t* rows, size_t stride, int count, int dim, int32_t* out) {
+    int r = 0;
+#if defined(FEATURE_KERNEL_NEON) && defined(__ARM_FEATURE_DOTPROD)
+    int vec_dim = dim & ~15;
+    for (; r + 4 <= count; r += 4) {
+        const int8_t* r0 = rows + r * stride;
+        const int8_t* r1 = r0 + stride;
+        const int8_t* r2 = r1 + stride;
+        const int8_t* r3 = r2 + stride;
+        int32x4_t acc0 = vdupq_n_s32(0);
+        int32x4_t acc1 = vdupq_n_s32(0);
+        int32x4_t acc2 = vdupq_n_s32(0);
+        int32x4_t acc3 = vdupq_n_s32(0);
+        for (int i = 0; i < vec_dim; i += 16) {
+            int8x16_t q = vld1q_s8(query + i);
+            acc0 = vdotq_s32(acc0, vld1q_s8(r0 + i), q);
+            acc1 = vdotq_s32(acc1, vld1q_s8(r1 + i), q);
+            acc2 = vdotq_s32(acc2, vld1q_s8(r2 + i), q);
+            acc3 = vdotq_s32(acc3, vld1q_s8(r3 + i), q);
+        }
+        int32_t s0 = vaddvq_s32(acc0), s1 = vaddvq_s32(acc1);
+        int32_t s2 = vaddvq_s32(acc2), s3 = vaddvq_s32(acc3);
+        for (int i = vec_dim; i < dim; i++) {
+            s0 += static_cast<int32_t>(r0[i]) * query[i];
+            s1 += static_cast<int32_t>(r1[i]) * query[i];
+            s2 += static_cast<int32_t>(r2[i]) * query[i];
+            s3 += static_cast<int32_t>(r3[i]) * query[i];
+        }
+        out[r] = s0; out[r + 1] = s1; out[r + 2] = s2; out[r + 3] = s3;
+    }
+#endif
+    for (; r < count; r++) {
+        out[r] = feature_dot_i8(query, rows + r * stride, dim);
+    }
+}
@@ -8,6 +8,7 @@
 #include "core/model_manager.h"
 #include "core/yolov8_face.h"
 #include "core/facenet.h"
+#include "config.h"
 #include <cstring>
 #include <iostream>
 
@@ -20,7 +21,6 @@ ModelManager::ModelManager()
     , facenet_height_(0)
     , facenet_channel_(0)
     , facenet_model_data_(nullptr)
-    , facenet_outputs_(nullptr)
     , face_detector_initialized_(false)
     , facenet_initialized_(false)
 {
@@ -107,11 +107,15 @@ int ModelManager::init_facenet(const char* model_path) {
     facenet_inputs_[0].fmt = RKNN_TENSOR_NHWC;
     facenet_inputs_[0].pass_through = 0;
 
-    // 配置输出 - FaceNet 模型原始输出为 FP16，这里设置 want_float=1 让 RKNN 转成 float32，便于后续相似度计算
-    facenet_outputs_ = new rknn_output[facenet_io_num_.n_output];
-    memset(facenet_outputs_, 0, sizeof(rknn_output) * facenet_io_num_.n_output);
-    for (int i = 0; i < facenet_io_num_.n_output; i++) {
-        facenet_outputs_[i].want_float = 1;
+    // 批量推理池: 复制上下文到多个 NPU 核心，并按模型 batch 维打包输入；
+    // 输出读入预分配缓冲 (FACENET_RAW_OUTPUT 时为原始 FP16)，转换与归一化融合在一次 SIMD 核中
+    if (facenet_pool_.init(&facenet_ctx_, facenet_width_, facenet_height_, facenet_channel_,
+                           facenet_io_num_, Config::Performance::FACENET_CONTEXT_NUM) != 0) {
+        // 识别与注册都经过推理池，池不可用时模型也无法使用
+        std::cerr << "Failed to init FaceNet pool" << std::endl;
+        release_facenet(&facenet_ctx_, facenet_model_data_);
+        facenet_model_data_ = nullptr;
+        return -1;
     }
 
     facenet_initialized_ = true;
@@ -128,11 +132,8 @@ void ModelManager::release() {
     }
 
     if (facenet_initialized_) {
+        facenet_pool_.release();
         release_facenet(&facenet_ctx_, facenet_model_data_);
-        if (facenet_outputs_) {
-            delete[] facenet_outputs_;
-            facenet_outputs_ = nullptr;
-        }
         facenet_initialized_ = false;
         std::cout << "FaceNet model released" << std::endl;
     }
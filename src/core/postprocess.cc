@@ -327,6 +327,9 @@ int post_process_yolov8_face(rknn_output* outputs, rknn_tensor_attr* output_attr
         group->results[last_count].point.point_5_y = (int)(clamp(kpts[4][1], 0, model_in_h) / scale_h);
 
         strncpy(group->results[last_count].name, "face", OBJ_NAME_MAX_SIZE);
+        group->results[last_count].track_id = -1;
+        group->results[last_count].track_state = TRACK_NEW;
+        group->results[last_count].quality = 0.0f;
     last_count++;
   }
 
@@ -335,101 +338,106 @@ int post_process_yolov8_face(rknn_output* outputs, rknn_tensor_attr* output_attr
 }
 
 // ============================================
-// 人脸对齐辅助函数
+// 人脸对齐
 // ============================================
 
-cv::Mat meanAxis0(const cv::Mat& src) {
-        int num = src.rows;
-        int dim = src.cols;
-    cv::Mat output(1, dim, CV_32F);
-    for (int i = 0; i < dim; i++) {
-        float sum = 0;
-        for (int j = 0; j < num; j++) {
-            sum += src.at<float>(j, i);
-            }
-        output.at<float>(0, i) = sum / num;
-        }
-        return output;
-}
+// ArcFace 112x112 模板关键点 (左眼、右眼、鼻子、左嘴角、右嘴角)
+static const float ARCFACE_TEMPLATE_112[10] = {
+    38.2946f, 51.6963f,
+    73.5318f, 51.5014f,
+    56.0252f, 71.7366f,
+    41.5493f, 92.3655f,
+    70.7299f, 92.2041f
+};
+
+void similar_transform_5pt(const float src[10], const float dst[10], float M[6]) {
+    // 1. 质心
+    float src_mx = 0.f, src_my = 0.f, dst_mx = 0.f, dst_my = 0.f;
+    for (int i = 0; i < 5; ++i) {
+        src_mx += src[2 * i];
+        src_my += src[2 * i + 1];
+        dst_mx += dst[2 * i];
+        dst_my += dst[2 * i + 1];
+    }
+    src_mx *= 0.2f;
+    src_my *= 0.2f;
+    dst_mx *= 0.2f;
+    dst_my *= 0.2f;
+
+    // 2. 去中心化后的协方差项
+    // 2D 情况下 Umeyama 的最优旋转 + 尺度可直接写成:
+    //   a = s*cos(theta) = sum(ax*bx + ay*by) / sum(|a|^2)
+    //   b = s*sin(theta) = sum(ax*by - ay*bx) / sum(|a|^2)
+    // 等价于 SVD 解 (含 det<0 时的符号修正)，无需迭代
+    float sxx = 0.f, sxy = 0.f, var = 0.f;
+    for (int i = 0; i < 5; ++i) {
+        float ax = src[2 * i] - src_mx;
+        float ay = src[2 * i + 1] - src_my;
+        float bx = dst[2 * i] - dst_mx;
+        float by = dst[2 * i + 1] - dst_my;
+        sxx += ax * bx + ay * by;
+        sxy += ax * by - ay * bx;
+        var += ax * ax + ay * ay;
+    }
 
-cv::Mat elementwiseMinus(const cv::Mat& A, const cv::Mat& B) {
-    cv::Mat output(A.rows, A.cols, A.type());
-        assert(B.cols == A.cols);
-    if (B.cols == A.cols) {
-        for (int i = 0; i < A.rows; i++) {
-            for (int j = 0; j < B.cols; j++) {
-                output.at<float>(i, j) = A.at<float>(i, j) - B.at<float>(0, j);
-                }
-            }
-        }
-        return output;
-}
+    float a = 1.f, b = 0.f;
+    if (var > 1e-6f) {
+        a = sxx / var;
+        b = sxy / var;
+    }
 
-cv::Mat varAxis0(const cv::Mat& src) {
-    cv::Mat temp_ = elementwiseMinus(src, meanAxis0(src));
-    cv::multiply(temp_, temp_, temp_);
-        return meanAxis0(temp_);
+    // 3. 平移: t = dst_mean - sR * src_mean
+    M[0] = a;
+    M[1] = -b;
+    M[2] = dst_mx - (a * src_mx - b * src_my);
+    M[3] = b;
+    M[4] = a;
+    M[5] = dst_my - (b * src_mx + a * src_my);
 }
 
-int MatrixRank(cv::Mat M) {
-	cv::Mat w, u, vt;
-	cv::SVD::compute(M, w, u, vt);
-	cv::Mat1b nonZeroSingularValues = w > 0.0001;
-    int rank = cv::countNonZero(nonZeroSingularValues);
-        return rank;
+cv::Mat similarTransform(cv::Mat src, cv::Mat dst) {
+    float s[10], d[10];
+    for (int i = 0; i < 5; ++i) {
+        s[2 * i] = src.at<float>(i, 0);
+        s[2 * i + 1] = src.at<float>(i, 1);
+        d[2 * i] = dst.at<float>(i, 0);
+        d[2 * i + 1] = dst.at<float>(i, 1);
+    }
+
+    float m[6];
+    similar_transform_5pt(s, d, m);
+
+    cv::Mat T = cv::Mat::eye(3, 3, CV_32F);
+    for (int i = 0; i < 6; ++i) {
+        T.at<float>(i / 3, i % 3) = m[i];
+    }
+    return T;
 }
 
-cv::Mat similarTransform(cv::Mat src, cv::Mat dst) {
-        int num = src.rows;
-        int dim = src.cols;
-        cv::Mat src_mean = meanAxis0(src);
-        cv::Mat dst_mean = meanAxis0(dst);
-        cv::Mat src_demean = elementwiseMinus(src, src_mean);
-        cv::Mat dst_demean = elementwiseMinus(dst, dst_mean);
-        cv::Mat A = (dst_demean.t() * src_demean) / static_cast<float>(num);
-        cv::Mat d(dim, 1, CV_32F);
-        d.setTo(1.0f);
-        if (cv::determinant(A) < 0) {
-            d.at<float>(dim - 1, 0) = -1;
-        }
-	cv::Mat T = cv::Mat::eye(dim + 1, dim + 1, CV_32F);
-        cv::Mat U, S, V;
-    cv::SVD::compute(A, S, U, V);
-
-        int rank = MatrixRank(A);
-        if (rank == 0) {
-            assert(rank == 0);
-        } else if (rank == dim - 1) {
-            if (cv::determinant(U) * cv::determinant(V) > 0) {
-                T.rowRange(0, dim).colRange(0, dim) = U * V;
-            } else {
-                int s = d.at<float>(dim - 1, 0) = -1;
-                d.at<float>(dim - 1, 0) = -1;
-                T.rowRange(0, dim).colRange(0, dim) = U * V;
-                cv::Mat diag_ = cv::Mat::diag(d);
-            cv::Mat twp = diag_ * V;
-            T.rowRange(0, dim).colRange(0, dim) = U * twp;
-                d.at<float>(dim - 1, 0) = s;
-        }
-    } else {
-            cv::Mat diag_ = cv::Mat::diag(d);
-        cv::Mat twp = diag_ * V.t();
-        cv::Mat res = U * twp;
-        T.rowRange(0, dim).colRange(0, dim) = -U.t() * twp;
-        }
-        cv::Mat var_ = varAxis0(src_demean);
-        float val = cv::sum(var_).val[0];
-        cv::Mat res;
-    cv::multiply(d, S, res);
-    float scale = 1.0 / val * cv::sum(res).val[0];
-    T.rowRange(0, dim).colRange(0, dim) = -T.rowRange(0, dim).colRange(0, dim).t();
-    cv::Mat temp1 = T.rowRange(0, dim).colRange(0, dim);
-    cv::Mat temp2 = src_mean.t();
-    cv::Mat temp3 = temp1 * temp2;
-    cv::Mat temp4 = scale * temp3;
-    T.rowRange(0, dim).colRange(dim, dim + 1) = -(temp4 - dst_mean.t());
-        T.rowRange(0, dim).colRange(0, dim) *= scale;
-        return T;
+void align_face(const cv::Mat& img, const KEY_POINT& point, cv::Mat& out) {
+    const float src[10] = {
+        (float)point.point_1_x, (float)point.point_1_y,
+        (float)point.point_2_x, (float)point.point_2_y,
+        (float)point.point_3_x, (float)point.point_3_y,
+        (float)point.point_4_x, (float)point.point_4_y,
+        (float)point.point_5_x, (float)point.point_5_y
+    };
+
+    // 模板按输出尺寸缩放 (FaceNet 输入一般即为 112x112)
+    float dst[10];
+    float sx = out.cols / 112.0f;
+    float sy = out.rows / 112.0f;
+    for (int i = 0; i < 5; ++i) {
+        dst[2 * i] = ARCFACE_TEMPLATE_112[2 * i] * sx;
+        dst[2 * i + 1] = ARCFACE_TEMPLATE_112[2 * i + 1] * sy;
+    }
+
+    float m[6];
+    similar_transform_5pt(src, dst, m);
+
+    // 包装栈上矩阵，直接从整帧采样写入 out (out 尺寸/类型匹配时不会重新分配)
+    cv::Mat M(2, 3, CV_32F, m);
+    cv::warpAffine(img, out, M, out.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
 }
 
 // ============================================
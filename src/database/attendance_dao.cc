@@ -14,9 +14,9 @@ int64_t AttendanceDao::add_record(const AttendanceRecord& record) {
     if (!db) return -1;
 
     const char* sql = "INSERT INTO attendance_records (user_id, check_time, check_type, status, similarity) VALUES (?, ?, ?, ?, ?)";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto write = DatabaseManager::instance().lock_writes();
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) {
         std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << std::endl;
         return -1;
     }
@@ -34,7 +34,6 @@ int64_t AttendanceDao::add_record(const AttendanceRecord& record) {
         std::cerr << "Insert record failed: " << sqlite3_errmsg(db) << std::endl;
     }
 
-    sqlite3_finalize(stmt);
     return new_id;
 }
 
@@ -44,9 +43,8 @@ std::optional<AttendanceRecord> AttendanceDao::get_last_record(int64_t user_id)
 
     // 按时间倒序取第一条
     const char* sql = "SELECT record_id, user_id, check_time, check_type, status, similarity FROM attendance_records WHERE user_id = ? ORDER BY check_time DESC LIMIT 1";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return std::nullopt;
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return std::nullopt;
 
     sqlite3_bind_int64(stmt, 1, user_id);
 
@@ -62,7 +60,6 @@ std::optional<AttendanceRecord> AttendanceDao::get_last_record(int64_t user_id)
         result = r;
     }
 
-    sqlite3_finalize(stmt);
     return result;
 }
 
@@ -72,9 +69,8 @@ std::vector<AttendanceRecord> AttendanceDao::get_records_by_user(int64_t user_id
     if (!db) return records;
 
     const char* sql = "SELECT record_id, user_id, check_time, check_type, status, similarity FROM attendance_records WHERE user_id = ? AND check_time BETWEEN ? AND ? ORDER BY check_time ASC";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return records;
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return records;
 
     sqlite3_bind_int64(stmt, 1, user_id);
     sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(start_time));
@@ -91,7 +87,32 @@ std::vector<AttendanceRecord> AttendanceDao::get_records_by_user(int64_t user_id
         records.push_back(r);
     }
 
-    sqlite3_finalize(stmt);
+    return records;
+}
+
+std::vector<AttendanceRecord> AttendanceDao::get_records_in_range(std::time_t start_time, std::time_t end_time) {
+    std::vector<AttendanceRecord> records;
+    sqlite3* db = DatabaseManager::instance().connection();
+    if (!db) return records;
+
+    const char* sql = "SELECT record_id, user_id, check_time, check_type, status, similarity FROM attendance_records WHERE check_time BETWEEN ? AND ? ORDER BY check_time ASC";
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return records;
+
+    sqlite3_bind_int64(stmt, 1, static_cast<int64_t>(start_time));
+    sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(end_time));
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        AttendanceRecord r;
+        r.record_id = sqlite3_column_int64(stmt, 0);
+        r.user_id = sqlite3_column_int64(stmt, 1);
+        r.check_time = static_cast<std::time_t>(sqlite3_column_int64(stmt, 2));
+        r.check_type = sqlite3_column_int(stmt, 3);
+        r.status = sqlite3_column_int(stmt, 4);
+        r.similarity = sqlite3_column_double(stmt, 5);
+        records.push_back(r);
+    }
+
     return records;
 }
 
@@ -2,6 +2,8 @@
  * @file database_manager.cc
  * @brief 数据库连接管理实现
  * @details 负责 SQLite 数据库的打开、关闭、事务处理以及基础表结构的自动创建。
+ *          DAO 的每条 SQL 只在首次使用时编译，之后从缓存借出 (reset + 重新绑定)，
+ *          省去每次调用的 sqlite3_prepare_v2 / sqlite3_finalize。
  */
 
 #include "database/database_manager.h"
@@ -9,6 +11,38 @@
 
 namespace db {
 
+Statement::Statement(Statement&& other) noexcept
+    : stmt_(other.stmt_)
+    , entry_(other.entry_)
+    , generation_(other.generation_)
+{
+    other.stmt_ = nullptr;
+    other.entry_ = nullptr;
+}
+
+Statement& Statement::operator=(Statement&& other) noexcept {
+    if (this != &other) {
+        release();
+        stmt_ = other.stmt_;
+        entry_ = other.entry_;
+        generation_ = other.generation_;
+        other.stmt_ = nullptr;
+        other.entry_ = nullptr;
+    }
+    return *this;
+}
+
+void Statement::release() {
+    if (!stmt_) return;
+    if (entry_) {
+        DatabaseManager::instance().release_statement(*this);
+    } else {
+        sqlite3_finalize(stmt_);
+    }
+    stmt_ = nullptr;
+    entry_ = nullptr;
+}
+
 DatabaseManager& DatabaseManager::instance() {
     static DatabaseManager instance;
     return instance;
@@ -47,11 +81,84 @@ bool DatabaseManager::open(const std::string& path) {
 void DatabaseManager::close() {
     std::lock_guard<std::mutex> lock(mutex_);
     if (db_) {
-        sqlite3_close(db_);
+        {
+            std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+            clear_statement_cache();
+        }
+        // 仍被借用的语句归还时才 finalize：sqlite3_close_v2 把连接的释放推迟到那时
+        sqlite3_close_v2(db_);
         db_ = nullptr;
     }
 }
 
+Statement DatabaseManager::prepare(const char* sql) {
+    Statement statement;
+    sqlite3* db = db_;
+    if (!db) return statement;
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        if (cache_enabled_) {
+            auto it = statements_.find(std::string_view(sql));
+            if (it == statements_.end()) {
+                sqlite3_stmt* stmt = nullptr;
+                if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return statement;
+                // 键指向语句保存的 SQL 文本，与语句同生命周期 (条目在 finalize 时一并移除)；
+                // 保存的文本只到第一条语句末尾，与 sql 不同 (尾部还有内容) 时不缓存，当作临时语句
+                std::string_view key(sqlite3_sql(stmt));
+                if (key != sql) {
+                    statement.stmt_ = stmt;
+                    return statement;
+                }
+                it = statements_.emplace(key, Statement::CacheEntry{stmt, false}).first;
+            }
+            if (!it->second.in_use) {
+                it->second.in_use = true;
+                statement.stmt_ = it->second.stmt;
+                statement.entry_ = &it->second;
+                statement.generation_ = cache_generation_;
+                return statement;
+            }
+        }
+    }
+
+    // 缓存关闭或同一条语句正被借用：临时编译，归还时 finalize
+    if (sqlite3_prepare_v2(db, sql, -1, &statement.stmt_, nullptr) != SQLITE_OK) {
+        statement.stmt_ = nullptr;
+    }
+    return statement;
+}
+
+void DatabaseManager::release_statement(Statement& statement) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (statement.generation_ != cache_generation_) {
+        sqlite3_finalize(statement.stmt_); // 借出后缓存已清空 (close / 关闭缓存)
+        return;
+    }
+    sqlite3_reset(statement.stmt_);
+    sqlite3_clear_bindings(statement.stmt_);
+    statement.entry_->in_use = false;
+}
+
+void DatabaseManager::clear_statement_cache() {
+    for (auto& kv : statements_) {
+        if (!kv.second.in_use) sqlite3_finalize(kv.second.stmt);
+    }
+    statements_.clear();
+    cache_generation_++;
+}
+
+void DatabaseManager::set_statement_cache(bool enable) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cache_enabled_ = enable;
+    if (!enable) clear_statement_cache();
+}
+
+size_t DatabaseManager::cached_statements() {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return statements_.size();
+}
+
 bool DatabaseManager::execute(const std::string& sql) {
     if (!db_) return false;
 
@@ -66,15 +173,36 @@ bool DatabaseManager::execute(const std::string& sql) {
 }
 
 bool DatabaseManager::begin_transaction() {
-    return execute("BEGIN TRANSACTION;");
+    write_mutex_.lock(); // 持有到事务结束，其他线程的写操作在此期间等待
+    if (!execute("BEGIN TRANSACTION;")) {
+        write_mutex_.unlock();
+        return false;
+    }
+    in_transaction_ = true;
+    return true;
 }
 
 bool DatabaseManager::commit_transaction() {
-    return execute("COMMIT;");
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
+    if (!in_transaction_) return false;
+
+    bool ok = execute("COMMIT;");
+    // 提交失败但事务仍未结束 (如 SQLITE_BUSY) 时继续持锁，由调用方 rollback
+    if (ok || !db_ || sqlite3_get_autocommit(db_)) {
+        in_transaction_ = false;
+        write_mutex_.unlock(); // 释放 begin_transaction 持有的一层
+    }
+    return ok;
 }
 
 bool DatabaseManager::rollback_transaction() {
-    return execute("ROLLBACK;");
+    std::lock_guard<std::recursive_mutex> lock(write_mutex_);
+    if (!in_transaction_) return false; // 事务已结束 (如提交失败时 SQLite 已自动回滚)
+
+    bool ok = execute("ROLLBACK;");
+    in_transaction_ = false;
+    write_mutex_.unlock();
+    return ok;
 }
 
 bool DatabaseManager::create_tables() {
@@ -107,6 +235,22 @@ bool DatabaseManager::create_tables() {
         "FOREIGN KEY(user_id) REFERENCES users(user_id) ON DELETE CASCADE"
         ");";
     
+    // 特征表修订号：任何途径 (本程序、db_tool、sqlite3 命令行) 修改 face_features 都会使其递增，
+    // 内存特征库的快照文件据此判断是否过期
+    const char* sql_meta =
+        "CREATE TABLE IF NOT EXISTS gallery_meta ("
+        "id INTEGER PRIMARY KEY CHECK (id = 1),"
+        "instance INTEGER NOT NULL,"
+        "revision INTEGER NOT NULL"
+        ");"
+        "INSERT OR IGNORE INTO gallery_meta (id, instance, revision) VALUES (1, abs(random()), 0);"
+        "CREATE TRIGGER IF NOT EXISTS face_features_revision_insert AFTER INSERT ON face_features "
+        "BEGIN UPDATE gallery_meta SET revision = revision + 1 WHERE id = 1; END;"
+        "CREATE TRIGGER IF NOT EXISTS face_features_revision_update AFTER UPDATE ON face_features "
+        "BEGIN UPDATE gallery_meta SET revision = revision + 1 WHERE id = 1; END;"
+        "CREATE TRIGGER IF NOT EXISTS face_features_revision_delete AFTER DELETE ON face_features "
+        "BEGIN UPDATE gallery_meta SET revision = revision + 1 WHERE id = 1; END;";
+
     // 索引
     const char* sql_idx_name = "CREATE INDEX IF NOT EXISTS idx_users_name ON users(user_name);";
     const char* sql_idx_time = "CREATE INDEX IF NOT EXISTS idx_records_time ON attendance_records(check_time);";
@@ -115,6 +259,7 @@ bool DatabaseManager::create_tables() {
     return execute(sql_users) && 
            execute(sql_features) && 
            execute(sql_records) &&
+           execute(sql_meta) &&
            execute(sql_idx_name) &&
            execute(sql_idx_time) &&
            execute(sql_idx_user);
@@ -10,23 +10,38 @@
 
 namespace db {
 
+// BLOB 复制到 Embedding 时归一化 (BLOB 不一定按 float 对齐)；长度不符时为空
+static void read_feature_blob(sqlite3_stmt* stmt, int column, Embedding& out) {
+    const void* blob_data = sqlite3_column_blob(stmt, column);
+    int blob_size = sqlite3_column_bytes(stmt, column);
+    if (!blob_data || blob_size != static_cast<int>(Embedding::size() * sizeof(float))) {
+        out.clear();
+        return;
+    }
+    alignas(CACHE_LINE_SIZE) float raw[Embedding::DIM];
+    std::memcpy(raw, blob_data, sizeof(raw));
+    out.assign(raw);
+}
+
 int64_t FaceFeatureDao::add_feature(const FaceFeature& feature) {
     sqlite3* db = DatabaseManager::instance().connection();
     if (!db) return -1;
 
     const char* sql = "INSERT INTO face_features (user_id, feature_vector, feature_quality) VALUES (?, ?, ?)";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto write = DatabaseManager::instance().lock_writes();
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) {
         std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << std::endl;
         return -1;
     }
 
     sqlite3_bind_int64(stmt, 1, feature.user_id);
     
-    // Bind BLOB
-    // feature.feature_vector is std::vector<float>
-    // size in bytes = size() * sizeof(float)
+    // Bind BLOB (FEATURE_DIM 个 float)
+    if (feature.feature_vector.empty()) {
+        std::cerr << "Insert feature failed: empty feature vector" << std::endl;
+        return -1;
+    }
     sqlite3_bind_blob(stmt, 2, feature.feature_vector.data(), 
                       feature.feature_vector.size() * sizeof(float), SQLITE_STATIC);
     
@@ -39,7 +54,6 @@ int64_t FaceFeatureDao::add_feature(const FaceFeature& feature) {
         std::cerr << "Insert feature failed: " << sqlite3_errmsg(db) << std::endl;
     }
 
-    sqlite3_finalize(stmt);
     return new_id;
 }
 
@@ -49,9 +63,8 @@ std::vector<FaceFeature> FaceFeatureDao::get_features_by_user_id(int64_t user_id
     if (!db) return features;
 
     const char* sql = "SELECT feature_id, user_id, feature_vector, feature_quality FROM face_features WHERE user_id = ?";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return features;
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return features;
 
     sqlite3_bind_int64(stmt, 1, user_id);
 
@@ -61,20 +74,12 @@ std::vector<FaceFeature> FaceFeatureDao::get_features_by_user_id(int64_t user_id
         f.user_id = sqlite3_column_int64(stmt, 1);
         
         // Read BLOB
-        const void* blob_data = sqlite3_column_blob(stmt, 2);
-        int blob_size = sqlite3_column_bytes(stmt, 2);
-        
-        int float_count = blob_size / sizeof(float);
-        f.feature_vector.resize(float_count);
-        if (blob_data && blob_size > 0) {
-            std::memcpy(f.feature_vector.data(), blob_data, blob_size);
-        }
+        read_feature_blob(stmt, 2, f.feature_vector);
         
         f.feature_quality = sqlite3_column_double(stmt, 3);
         features.push_back(f);
     }
 
-    sqlite3_finalize(stmt);
     return features;
 }
 
@@ -84,45 +89,52 @@ std::vector<FaceFeature> FaceFeatureDao::get_all_features() {
     if (!db) return features;
 
     const char* sql = "SELECT feature_id, user_id, feature_vector, feature_quality FROM face_features";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return features;
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return features;
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         FaceFeature f;
         f.feature_id = sqlite3_column_int64(stmt, 0);
         f.user_id = sqlite3_column_int64(stmt, 1);
         
-        const void* blob_data = sqlite3_column_blob(stmt, 2);
-        int blob_size = sqlite3_column_bytes(stmt, 2);
-        
-        int float_count = blob_size / sizeof(float);
-        f.feature_vector.resize(float_count);
-        if (blob_data && blob_size > 0) {
-            std::memcpy(f.feature_vector.data(), blob_data, blob_size);
-        }
+        read_feature_blob(stmt, 2, f.feature_vector);
         
         f.feature_quality = sqlite3_column_double(stmt, 3);
         features.push_back(f);
     }
 
-    sqlite3_finalize(stmt);
     return features;
 }
 
+bool FaceFeatureDao::get_revision(FeatureRevision& out) {
+    sqlite3* db = DatabaseManager::instance().connection();
+    if (!db) return false;
+
+    const char* sql = "SELECT instance, revision FROM gallery_meta WHERE id = 1";
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return false;
+
+    bool found = (sqlite3_step(stmt) == SQLITE_ROW);
+    if (found) {
+        out.instance = sqlite3_column_int64(stmt, 0);
+        out.revision = sqlite3_column_int64(stmt, 1);
+    }
+
+    return found;
+}
+
 bool FaceFeatureDao::delete_feature(int64_t feature_id) {
     sqlite3* db = DatabaseManager::instance().connection();
     if (!db) return false;
 
     const char* sql = "DELETE FROM face_features WHERE feature_id = ?";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+    auto write = DatabaseManager::instance().lock_writes();
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return false;
 
     sqlite3_bind_int64(stmt, 1, feature_id);
 
     bool success = (sqlite3_step(stmt) == SQLITE_DONE);
-    sqlite3_finalize(stmt);
     return success;
 }
 
@@ -131,14 +143,13 @@ bool FaceFeatureDao::delete_features_by_user_id(int64_t user_id) {
     if (!db) return false;
 
     const char* sql = "DELETE FROM face_features WHERE user_id = ?";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+    auto write = DatabaseManager::instance().lock_writes();
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return false;
 
     sqlite3_bind_int64(stmt, 1, user_id);
 
     bool success = (sqlite3_step(stmt) == SQLITE_DONE);
-    sqlite3_finalize(stmt);
     return success;
 }
 
@@ -14,9 +14,9 @@ int64_t UserDao::add_user(const User& user) {
     if (!db) return -1;
 
     const char* sql = "INSERT INTO users (user_name, employee_id, department, status) VALUES (?, ?, ?, ?)";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    auto write = DatabaseManager::instance().lock_writes();
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) {
         std::cerr << "Prepare failed: " << sqlite3_errmsg(db) << std::endl;
         return -1;
     }
@@ -33,7 +33,6 @@ int64_t UserDao::add_user(const User& user) {
         std::cerr << "Insert user failed: " << sqlite3_errmsg(db) << std::endl;
     }
 
-    sqlite3_finalize(stmt);
     return new_id;
 }
 
@@ -42,9 +41,8 @@ std::optional<User> UserDao::get_user_by_id(int64_t user_id) {
     if (!db) return std::nullopt;
 
     const char* sql = "SELECT user_id, user_name, employee_id, department, status FROM users WHERE user_id = ?";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return std::nullopt;
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return std::nullopt;
 
     sqlite3_bind_int64(stmt, 1, user_id);
 
@@ -61,7 +59,6 @@ std::optional<User> UserDao::get_user_by_id(int64_t user_id) {
         result = u;
     }
 
-    sqlite3_finalize(stmt);
     return result;
 }
 
@@ -70,9 +67,8 @@ std::optional<User> UserDao::get_user_by_name(const std::string& name) {
     if (!db) return std::nullopt;
 
     const char* sql = "SELECT user_id, user_name, employee_id, department, status FROM users WHERE user_name = ?";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return std::nullopt;
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return std::nullopt;
 
     sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
 
@@ -89,7 +85,6 @@ std::optional<User> UserDao::get_user_by_name(const std::string& name) {
         result = u;
     }
 
-    sqlite3_finalize(stmt);
     return result;
 }
 
@@ -99,9 +94,8 @@ std::vector<User> UserDao::get_all_active_users() {
     if (!db) return users;
 
     const char* sql = "SELECT user_id, user_name, employee_id, department, status FROM users WHERE status = 1";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return users;
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return users;
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         User u;
@@ -115,7 +109,6 @@ std::vector<User> UserDao::get_all_active_users() {
         users.push_back(u);
     }
 
-    sqlite3_finalize(stmt);
     return users;
 }
 
@@ -124,9 +117,9 @@ bool UserDao::update_user(const User& user) {
     if (!db) return false;
 
     const char* sql = "UPDATE users SET user_name=?, employee_id=?, department=?, status=? WHERE user_id=?";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+    auto write = DatabaseManager::instance().lock_writes();
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return false;
 
     sqlite3_bind_text(stmt, 1, user.user_name.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 2, user.employee_id.c_str(), -1, SQLITE_STATIC);
@@ -135,7 +128,6 @@ bool UserDao::update_user(const User& user) {
     sqlite3_bind_int64(stmt, 5, user.user_id);
 
     bool success = (sqlite3_step(stmt) == SQLITE_DONE);
-    sqlite3_finalize(stmt);
     return success;
 }
 
@@ -144,14 +136,13 @@ bool UserDao::delete_user(int64_t user_id) {
     if (!db) return false;
 
     const char* sql = "DELETE FROM users WHERE user_id = ?";
-    sqlite3_stmt* stmt;
-
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return false;
+    auto write = DatabaseManager::instance().lock_writes();
+    Statement stmt = DatabaseManager::instance().prepare(sql);
+    if (!stmt) return false;
 
     sqlite3_bind_int64(stmt, 1, user_id);
 
     bool success = (sqlite3_step(stmt) == SQLITE_DONE);
-    sqlite3_finalize(stmt);
     return success;
 }
 
@@ -0,0 +1,159 @@
+/**
+ * @file attendance_recorder.cc
+ * @brief 异步考勤写入器实现
+ * @details 写线程等待首个事件后，最多再等待 WRITE_FLUSH_INTERVAL_MS 或攒满
+ *          WRITE_BATCH_SIZE 个事件，然后在一个显式事务中逐条执行考勤判定与插入。
+ *          判定所用的内存考勤状态按事件顺序逐条更新，结果与逐条写入一致。
+ *          提交失败时回滚并重新加载考勤状态，稍后整批重试 (事件带原始时间，重试结果不变)，
+ *          WRITE_COMMIT_ATTEMPTS 次都失败才丢弃。
+ */
+
+#include "service/attendance_recorder.h"
+#include "service/attendance_service.h"
+#include "service/attendance_state_cache.h"
+#include "database/database_manager.h"
+#include "config.h"
+#include <chrono>
+#include <iostream>
+#include <algorithm>
+
+namespace service {
+
+AttendanceRecorder& AttendanceRecorder::instance() {
+    static AttendanceRecorder instance;
+    return instance;
+}
+
+AttendanceRecorder::~AttendanceRecorder() {
+    stop();
+}
+
+void AttendanceRecorder::start() {
+    if (running_) return;
+    running_ = true;
+    thread_ = std::thread(&AttendanceRecorder::writer_loop, this);
+}
+
+void AttendanceRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool AttendanceRecorder::submit(int64_t user_id, float similarity) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return false;
+        if (queue_.size() >= static_cast<size_t>(Config::Attendance::WRITE_QUEUE_CAPACITY)) {
+            metrics_.dropped++;
+            std::cerr << "[AttendanceRecorder] queue full, event dropped (user " << user_id << ")" << std::endl;
+            return false;
+        }
+        queue_.push_back({user_id, similarity, std::time(nullptr)});
+        metrics_.peak_depth = std::max(metrics_.peak_depth, queue_.size());
+    }
+    cv_.notify_one();
+    return true;
+}
+
+AttendanceRecorderMetrics AttendanceRecorder::metrics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AttendanceRecorderMetrics m = metrics_;
+    m.queue_depth = queue_.size();
+    return m;
+}
+
+void AttendanceRecorder::writer_loop() {
+    const size_t batch_size = Config::Attendance::WRITE_BATCH_SIZE;
+    std::vector<AttendanceEvent> batch;
+    batch.reserve(batch_size);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return !queue_.empty() || !running_; });
+        if (queue_.empty()) break; // 已停止且队列清空
+
+        // 攒批：未攒满时最多等待 WRITE_FLUSH_INTERVAL_MS (停止时立即提交)
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(Config::Attendance::WRITE_FLUSH_INTERVAL_MS);
+        cv_.wait_until(lock, deadline, [this, batch_size] { return queue_.size() >= batch_size || !running_; });
+
+        size_t n = std::min(batch_size, queue_.size());
+        batch.assign(queue_.begin(), queue_.begin() + n);
+        queue_.erase(queue_.begin(), queue_.begin() + n);
+
+        lock.unlock();
+        flush(batch);
+        lock.lock();
+    }
+}
+
+bool AttendanceRecorder::write_batch(const std::vector<AttendanceEvent>& batch) {
+    db::DatabaseManager& dbm = db::DatabaseManager::instance();
+    if (!dbm.begin_transaction()) return false;
+
+    AttendanceService service;
+    for (const auto& e : batch) {
+        service.record_attendance(e.user_id, e.similarity, e.check_time);
+    }
+    if (dbm.commit_transaction()) return true;
+
+    dbm.rollback_transaction();
+    // 内存考勤状态已按本批次更新，回滚后重新与数据库对齐
+    AttendanceStateCache::instance().warm_up();
+    return false;
+}
+
+void AttendanceRecorder::flush(const std::vector<AttendanceEvent>& batch) {
+    auto t0 = std::chrono::steady_clock::now();
+
+    bool ok = false;
+    for (int attempt = 1; attempt <= Config::Attendance::WRITE_COMMIT_ATTEMPTS; attempt++) {
+        ok = write_batch(batch);
+        if (ok) break;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            metrics_.commit_failures++;
+        }
+        std::cerr << "[AttendanceRecorder] commit failed (attempt " << attempt << "/"
+                  << Config::Attendance::WRITE_COMMIT_ATTEMPTS << "), batch of " << batch.size() << " rolled back" << std::endl;
+        if (attempt < Config::Attendance::WRITE_COMMIT_ATTEMPTS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(Config::Attendance::WRITE_RETRY_DELAY_MS));
+        }
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / 1000.0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ok) {
+        metrics_.discarded += batch.size();
+        std::cerr << "[AttendanceRecorder] " << batch.size() << " event(s) discarded after "
+                  << Config::Attendance::WRITE_COMMIT_ATTEMPTS << " failed commit(s)" << std::endl;
+        return;
+    }
+
+    metrics_.events += batch.size();
+    metrics_.commits++;
+    total_commit_ms_ += ms;
+    metrics_.avg_commit_ms = total_commit_ms_ / metrics_.commits;
+    metrics_.max_commit_ms = std::max(metrics_.max_commit_ms, ms);
+
+    if (metrics_.commits % Config::Attendance::METRICS_REPORT_INTERVAL == 0) {
+        std::cout << "[AttendanceRecorder] commits: " << metrics_.commits
+                  << ", events: " << metrics_.events
+                  << ", queue: " << queue_.size() << " (peak " << metrics_.peak_depth << ")"
+                  << ", commit ms avg/max: " << metrics_.avg_commit_ms << "/" << metrics_.max_commit_ms
+                  << ", dropped: " << metrics_.dropped
+                  << ", commit failures: " << metrics_.commit_failures
+                  << ", discarded: " << metrics_.discarded << std::endl;
+    }
+}
+
+} // namespace service
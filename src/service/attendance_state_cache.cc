@@ -0,0 +1,125 @@
+/**
+ * @file attendance_state_cache.cc
+ * @brief 考勤状态内存缓存实现
+ */
+
+#include "service/attendance_state_cache.h"
+#include "database/attendance_dao.h"
+#include "config.h"
+#include <iostream>
+
+namespace service {
+
+// t 的本地时间 (localtime_r：识别线程与写线程都会调用，不能共用 std::localtime 的静态缓冲)
+static std::tm local_tm(std::time_t t) {
+    std::tm tm_out;
+    localtime_r(&t, &tm_out);
+    return tm_out;
+}
+
+// 计算 t 所在本地日期的零点
+static std::time_t local_day_start(std::time_t t) {
+    std::tm tm_day = local_tm(t);
+    tm_day.tm_hour = 0;
+    tm_day.tm_min = 0;
+    tm_day.tm_sec = 0;
+    return std::mktime(&tm_day);
+}
+
+// 当天 hour:minute 对应的时间点
+static std::time_t local_time_of_day(std::time_t day_start, int hour, int minute) {
+    std::tm tm_day = local_tm(day_start);
+    tm_day.tm_hour = hour;
+    tm_day.tm_min = minute;
+    tm_day.tm_sec = 0;
+    return std::mktime(&tm_day);
+}
+
+AttendanceStateCache& AttendanceStateCache::instance() {
+    static AttendanceStateCache instance;
+    return instance;
+}
+
+void AttendanceStateCache::roll_over(std::time_t t) {
+    // 只向前切换：零点前产生、零点后才写入的事件仍按当前日处理
+    if (day_end_ != 0 && t < day_end_) return;
+
+    states_.clear();
+    day_start_ = local_day_start(t);
+    // 下一日零点 (按日历计算，兼容夏令时)
+    std::tm tm_next = local_tm(day_start_);
+    tm_next.tm_mday += 1;
+    day_end_ = std::mktime(&tm_next);
+}
+
+void AttendanceStateCache::warm_up() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    load_today();
+}
+
+void AttendanceStateCache::load_today() {
+    std::time_t now = std::time(nullptr);
+    day_start_ = day_end_ = 0;
+    roll_over(now);
+
+    db::AttendanceDao dao;
+    auto records = dao.get_records_in_range(day_start_, day_end_ - 1);
+    for (const auto& r : records) {
+        UserAttendanceState& state = states_[r.user_id];
+        if (r.check_type == 1 && state.first_check_in == 0) {
+            state.first_check_in = r.check_time;
+        }
+        state.last_check_time = r.check_time;
+        state.last_type = r.check_type;
+    }
+
+    std::cout << "Attendance state warmed up: " << states_.size() << " user(s), "
+              << records.size() << " record(s) today." << std::endl;
+}
+
+bool AttendanceStateCache::decide(int64_t user_id, std::time_t check_time, db::AttendanceRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (day_end_ == 0) {
+        load_today(); // 未显式预热时首次使用再加载
+    }
+    roll_over(check_time);
+
+    record.user_id = user_id;
+    record.check_time = check_time;
+
+    auto it = states_.find(user_id);
+    if (it == states_.end() || it->second.last_check_time == 0) {
+        // 今日首次打卡 -> 签到
+        record.check_type = 1;
+        std::time_t work_start = local_time_of_day(day_start_, Config::Default::WORK_START_HOUR,
+                                                   Config::Default::WORK_START_MINUTE);
+        record.status = (check_time < work_start) ? 1 : 2; // 正常 / 迟到
+        return true;
+    }
+
+    // 防重复打卡
+    if (check_time - it->second.last_check_time < Config::Default::DUPLICATE_CHECK_INTERVAL) {
+        return false;
+    }
+
+    // 已有打卡 -> 签退 (之后的都算签退，以最后一次为准)
+    record.check_type = 2;
+    std::time_t work_end = local_time_of_day(day_start_, Config::Default::WORK_END_HOUR,
+                                             Config::Default::WORK_END_MINUTE);
+    record.status = (check_time >= work_end) ? 1 : 3; // 正常 / 早退
+    return true;
+}
+
+void AttendanceStateCache::apply(const db::AttendanceRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    roll_over(record.check_time);
+
+    UserAttendanceState& state = states_[record.user_id];
+    if (record.check_type == 1 && state.first_check_in == 0) {
+        state.first_check_in = record.check_time;
+    }
+    state.last_check_time = record.check_time;
+    state.last_type = record.check_type;
+}
+
+} // namespace service
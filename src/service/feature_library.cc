@@ -2,84 +2,1003 @@
  * @file feature_library.cc
  * @brief 人脸特征库管理实现
  * @details 负责从数据库加载已注册的人脸特征，并提供基于向量相似度的 1:N 检索功能。
+ *          模板归一化后存放在连续对齐的 FeatureMatrix 中，检索由 SIMD 多行点积核完成。
+ *          可选 int8 存储：常驻内存的只有量化模板，扫描得到的候选再用映射文件中的
+ *          精确 float 向量重排，结果与 float 检索基本一致；也可选半精度存储，内存减半且不需要重排。
+ *          float 模板数达到 ANN_MIN_TEMPLATES 时模板移入 IVF 索引，只扫描最接近的 nprobe 个倒排表；
+ *          模板较少时保持精确扫描。
+ *          检索只在入口处原子地取一次当前快照，之后不持有任何锁；写者 (加载/注册/删除/切换存储)
+ *          由 update_mutex_ 串行化，在快照副本上修改后原子发布。
+ *          启动时若快照文件的修订号与 face_features 一致，直接从文件恢复模板矩阵 (一次拷贝，无需
+ *          解析与归一化)，否则从数据库重建；之后每次更新由后台线程把最新快照写回文件。
+ *          模板数达到 PARALLEL_SCAN_MIN_TEMPLATES 时，精确扫描切成 SCAN_SHARD_ROWS 行的分片，
+ *          由 ScanPool 的常驻线程与调用线程一起动态领取，每个线程保留自己的前 k 名，最后合并。
+ *          用户按部门与启用状态分配检索标签，float / int8 / 半精度基础存储在构建与合并时按标签稳定排序，
+ *          过滤检索只扫描位图中标签的行区间；IVF 倒排表与增量区逐行按用户标签过滤。
  */
 
 #include "service/feature_library.h"
+#include "service/gallery_file.h"
+#include "service/scan_pool.h"
 #include "database/face_feature_dao.h"
+#include "database/user_dao.h"
+#include "core/feature_kernels.h"
+#include "config.h"
+#include <cstring>
 #include <cmath>
+#include <chrono>
+#include <algorithm>
 #include <iostream>
+#include <utility>
 
 namespace service {
 
+// 基础存储中需要扫描的行区间
+struct RowRange {
+    size_t begin;
+    size_t end;
+};
+
+// 大特征库分片并行扫描：ranges 切成不跨区间的分片，shard(worker, begin, end) 在各扫描线程上对领取到的分片执行。
+// 待扫描的行较少或线程池正被其他查询使用时返回 false，由调用方串行扫描
+template <typename ShardFn>
+static bool run_sharded(const std::vector<RowRange>& ranges, ShardFn&& shard) {
+    ScanPool& pool = ScanPool::instance();
+    size_t rows = 0;
+    for (const auto& r : ranges) rows += r.end - r.begin;
+    if (rows < Config::Gallery::PARALLEL_SCAN_MIN_TEMPLATES || pool.threads() <= 1) return false;
+
+    const size_t step = Config::Gallery::SCAN_SHARD_ROWS;
+    std::vector<RowRange> shards;
+    shards.reserve(rows / step + ranges.size());
+    for (const auto& r : ranges) {
+        for (size_t begin = r.begin; begin < r.end; begin += step) {
+            shards.push_back({begin, std::min(begin + step, r.end)});
+        }
+    }
+
+    std::atomic<size_t> next(0);
+    return pool.run([&](int worker) {
+        for (size_t i = next.fetch_add(1); i < shards.size(); i = next.fetch_add(1)) {
+            shard(worker, shards[i].begin, shards[i].end);
+        }
+    });
+}
+
+// 分片扫描时各扫描线程的前 k 名：缓冲按调用线程复用 (识别线程常驻，稳态下不再分配)，每次检索前复位。
+// 工作线程只通过调用方取得的引用写入自己的一项
+static std::vector<TopKUsers>& shard_tops(int k) {
+    static thread_local std::vector<TopKUsers> tops;
+    if (tops.size() < static_cast<size_t>(Config::Gallery::SCAN_THREADS)) {
+        tops.resize(Config::Gallery::SCAN_THREADS, TopKUsers(k));
+    }
+    for (auto& t : tops) t.reset(k);
+    return tops;
+}
+
+// 批量检索时各扫描线程、各查询的前 k 名 (复用方式同上，只复位前 queries 项)
+static std::vector<std::vector<TopKUsers>>& shard_batch_tops(size_t queries, int k) {
+    static thread_local std::vector<std::vector<TopKUsers>> tops(Config::Gallery::SCAN_THREADS);
+    for (auto& worker : tops) {
+        if (worker.size() < queries) worker.resize(queries, TopKUsers(k));
+        for (size_t q = 0; q < queries; q++) worker[q].reset(k);
+    }
+    return tops;
+}
+
+// int8 分片扫描时各扫描线程的候选 (复用方式同上)
+static std::vector<std::vector<ScoredRow>>& shard_candidates() {
+    static thread_local std::vector<std::vector<ScoredRow>> rows(Config::Gallery::SCAN_THREADS);
+    for (auto& r : rows) r.clear();
+    return rows;
+}
+
+// 用户的检索标签 (用户表中不存在的模板按禁用处理)
+static int user_tag(const GallerySnapshot& snap, int64_t user_id) {
+    auto it = snap.users->find(user_id);
+    return it == snap.users->end() ? TAG_DISABLED : it->second.tag;
+}
+
+static bool tag_allowed(const GallerySnapshot& snap, int64_t user_id, TagMask tags) {
+    return (tags >> user_tag(snap, user_id)) & 1;
+}
+
+// 过滤条件对应的位图：TAGS_DEFAULT 取快照中本机站点的位图
+static TagMask resolve_tags(const GallerySnapshot& snap, const TagFilter& tags) {
+    return tags ? *tags : snap.default_tags;
+}
+
+// 禁用用户归入 TAG_DISABLED；部门首次出现时分配新标签，标签用完后共用 TAG_OVERFLOW
+static int assign_tag(const db::User& user, std::unordered_map<std::string, int>& departments) {
+    if (user.status != 1) return TAG_DISABLED;
+    auto it = departments.find(user.department);
+    if (it != departments.end()) return it->second;
+    int tag = (departments.size() + 1 < static_cast<size_t>(TAG_OVERFLOW)) ? static_cast<int>(departments.size()) + 1
+                                                                            : TAG_OVERFLOW;
+    departments[user.department] = tag;
+    return tag;
+}
+
+// 部门名对应的标签位 (未知部门不贡献任何位)。共用 TAG_OVERFLOW 的部门按位过滤会混入其它溢出部门的用户，
+// 不计入位图而记入 overflow，由调用方报错
+static TagMask department_bits(const GallerySnapshot& snap, const std::vector<std::string>& departments,
+                               std::vector<std::string>& overflow) {
+    TagMask tags = 0;
+    for (const auto& department : departments) {
+        auto it = snap.department_tags->find(department);
+        if (it == snap.department_tags->end()) continue;
+        if (it->second == TAG_OVERFLOW) {
+            overflow.push_back(department);
+        } else {
+            tags |= TagMask(1) << it->second;
+        }
+    }
+    return tags;
+}
+
+// 按标签稳定排序后的行顺序 (计数排序)
+static std::vector<size_t> partition_order(const GallerySnapshot& snap, const std::vector<int64_t>& ids) {
+    std::vector<uint8_t> tags(ids.size());
+    std::vector<size_t> cursor(TAG_COUNT + 1, 0);
+    for (size_t i = 0; i < ids.size(); i++) {
+        tags[i] = static_cast<uint8_t>(user_tag(snap, ids[i]));
+        cursor[tags[i] + 1]++;
+    }
+    for (int t = 0; t < TAG_COUNT; t++) cursor[t + 1] += cursor[t];
+
+    std::vector<size_t> order(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) order[cursor[tags[i]]++] = i;
+    return order;
+}
+
+// 已按标签排列的 rows 行的各标签区间起点 (TAG_COUNT + 1 项)
+template <typename IdFn>
+static std::vector<size_t> count_partitions(const GallerySnapshot& snap, size_t rows, IdFn&& id) {
+    std::vector<size_t> partitions(TAG_COUNT + 1, 0);
+    for (size_t i = 0; i < rows; i++) partitions[user_tag(snap, id(i)) + 1]++;
+    for (int t = 0; t < TAG_COUNT; t++) partitions[t + 1] += partitions[t];
+    return partitions;
+}
+
+// rows 按标签稳定排序，写出分区 (已有序时不复制)
+static FeatureMatrix partition_rows(const GallerySnapshot& snap, FeatureMatrix&& rows, std::vector<size_t>& partitions) {
+    std::vector<size_t> order = partition_order(snap, rows.ids());
+    bool sorted = true;
+    for (size_t i = 0; i < order.size() && sorted; i++) sorted = order[i] == i;
+
+    FeatureMatrix out(rows.dim());
+    if (sorted) {
+        out = std::move(rows);
+    } else {
+        out.reserve(rows.size());
+        for (size_t i : order) out.append(rows.id(i), rows.row(i));
+    }
+    partitions = count_partitions(snap, out.size(), [&](size_t i) { return out.id(i); });
+    return out;
+}
+
+// rows 按标签排列后转为半精度矩阵
+static std::shared_ptr<const HalfFeatureMatrix> partition_half(const GallerySnapshot& snap, FeatureMatrix&& rows,
+                                                               std::vector<size_t>& partitions) {
+    FeatureMatrix sorted = partition_rows(snap, std::move(rows), partitions);
+    auto half = std::make_shared<HalfFeatureMatrix>(sorted.dim());
+    half->reserve(sorted.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        half->append(sorted.id(i), sorted.row(i));
+    }
+    return half;
+}
+
+// 过滤条件对应的行区间：分区存储时只取位图中的标签 (相邻区间合并)，否则为全部行
+static std::vector<RowRange> select_ranges(const GallerySnapshot& snap, size_t rows, TagMask tags) {
+    std::vector<RowRange> ranges;
+    if (snap.partitions.empty()) {
+        if (rows > 0) ranges.push_back({0, rows});
+        return ranges;
+    }
+    for (int t = 0; t < TAG_COUNT; t++) {
+        size_t begin = snap.partitions[t], end = snap.partitions[t + 1];
+        if (!((tags >> t) & 1) || begin == end) continue;
+        if (!ranges.empty() && ranges.back().end == begin) {
+            ranges.back().end = end;
+        } else {
+            ranges.push_back({begin, end});
+        }
+    }
+    return ranges;
+}
+
 FeatureLibrary& FeatureLibrary::instance() {
     static FeatureLibrary instance;
     return instance;
 }
 
+// 配置的存储格式在首次整库加载时生效，工具与测试可先设置映射文件路径
+FeatureLibrary::FeatureLibrary()
+    : storage_(Config::Gallery::INT8_STORAGE   ? Storage::INT8
+               : Config::Gallery::FP16_STORAGE ? Storage::FLOAT16
+                                               : Storage::FLOAT32)
+    , ann_enabled_(Config::Gallery::ANN_ENABLED)
+    , ann_min_templates_(Config::Gallery::ANN_MIN_TEMPLATES)
+    , snapshot_path_(Config::Path::GALLERY_SNAPSHOT)
+    , index_path_(Config::Path::GALLERY_IVF_CENTROIDS)
+    , float_store_path_(Config::Path::GALLERY_FLOAT_STORE)
+    , saving_(false)
+    , save_stop_(false)
+{
+    // 站点部门 (逗号分隔)
+    std::string site = Config::Gallery::SITE_DEPARTMENTS;
+    for (size_t begin = 0; begin < site.size();) {
+        size_t end = std::min(site.find(',', begin), site.size());
+        if (end > begin) site_departments_.push_back(site.substr(begin, end - begin));
+        begin = end + 1;
+    }
+
+    auto empty = std::make_shared<GallerySnapshot>(Config::Model::FEATURE_DIM);
+    empty->base = std::make_shared<FeatureMatrix>(Config::Model::FEATURE_DIM);
+    empty->users = std::make_shared<std::unordered_map<int64_t, UserInfo>>();
+    empty->department_tags = std::make_shared<std::unordered_map<std::string, int>>();
+    std::atomic_store(&snapshot_, Snapshot(std::move(empty)));
+}
+
+FeatureLibrary::~FeatureLibrary() {
+    {
+        std::lock_guard<std::mutex> lock(save_mutex_);
+        save_stop_ = true;
+    }
+    save_cv_.notify_all();
+    if (save_thread_.joinable()) {
+        save_thread_.join();
+    }
+}
+
+void FeatureLibrary::schedule_save(Snapshot snap) {
+    db::FaceFeatureDao dao;
+    db::FeatureRevision revision;
+    if (!dao.get_revision(revision)) return; // 未打开数据库 (工具/测试)：不写快照文件
+
+    {
+        std::lock_guard<std::mutex> lock(save_mutex_);
+        pending_save_ = std::move(snap);
+        pending_revision_ = revision;
+        pending_path_ = snapshot_path_;
+        if (!save_thread_.joinable()) {
+            save_thread_ = std::thread(&FeatureLibrary::save_loop, this);
+        }
+    }
+    save_cv_.notify_all();
+}
+
+void FeatureLibrary::flush_snapshot_file() {
+    std::unique_lock<std::mutex> lock(save_mutex_);
+    save_cv_.wait(lock, [this] { return !pending_save_ && !saving_; });
+}
+
+void FeatureLibrary::set_snapshot_path(const std::string& path) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    snapshot_path_ = path;
+}
+
+void FeatureLibrary::set_index_path(const std::string& path) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    index_path_ = path;
+}
+
+void FeatureLibrary::set_float_store_path(const std::string& path) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    float_store_path_ = path;
+}
+
+void FeatureLibrary::save_loop() {
+    std::unique_lock<std::mutex> lock(save_mutex_);
+    while (true) {
+        save_cv_.wait(lock, [this] { return pending_save_ || save_stop_; });
+        if (!pending_save_) break; // 已停止且没有待写快照
+
+        Snapshot snap = std::move(pending_save_);
+        pending_save_.reset();
+        db::FeatureRevision revision = pending_revision_;
+        std::string path = pending_path_;
+        saving_ = true;
+        lock.unlock();
+
+        // 快照不可变，导出与写文件都不需要任何锁；半精度舍入过的模板在文件头中标明，
+        // 之后以 float / int8 存储启动时拒绝该文件并从数据库重建
+        auto t0 = std::chrono::steady_clock::now();
+        FeatureMatrix rows = export_rows(*snap);
+        bool ok = save_gallery_file(path, rows, revision,
+                                    snap->rounded ? GalleryPrecision::FP16 : GalleryPrecision::EXACT);
+        auto t1 = std::chrono::steady_clock::now();
+        if (ok) {
+            std::cout << "[FeatureLibrary] gallery snapshot saved: " << rows.size() << " templates, revision "
+                      << revision.revision << ", "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms" << std::endl;
+        }
+
+        lock.lock();
+        saving_ = false;
+        save_cv_.notify_all();
+    }
+}
+
+void FeatureLibrary::publish(std::shared_ptr<GallerySnapshot> next) {
+    // 站点部门可能先于其用户出现：没有标签的部门不贡献任何位
+    std::vector<std::string> overflow;
+    TagMask tags = site_departments_.empty() ? TAGS_ACTIVE : department_bits(*next, site_departments_, overflow);
+    if (!overflow.empty() && !site_overflow_reported_) {
+        std::cerr << "[FeatureLibrary] site department \"" << overflow[0] << "\" shares the overflow tag (more than "
+                  << TAG_OVERFLOW - 1 << " departments), its users are not searched by default" << std::endl;
+        site_overflow_reported_ = true;
+    }
+    next->default_tags = tags;
+
+    std::atomic_store(&snapshot_, Snapshot(std::move(next)));
+    version_++;
+}
+
+void FeatureLibrary::set_site_departments(const std::vector<std::string>& departments) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    site_departments_ = departments;
+    site_overflow_reported_ = false;
+    publish(std::make_shared<GallerySnapshot>(*snapshot()));
+}
+
+TagMask FeatureLibrary::department_tags(const std::vector<std::string>& departments) {
+    std::vector<std::string> overflow;
+    TagMask tags = department_bits(*snapshot(), departments, overflow);
+    for (const auto& department : overflow) {
+        std::cerr << "[FeatureLibrary] department \"" << department << "\" shares the overflow tag (more than "
+                  << TAG_OVERFLOW - 1 << " departments) and cannot be filtered" << std::endl;
+    }
+    return tags;
+}
+
+bool FeatureLibrary::set_storage(Storage storage) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    Snapshot current = snapshot();
+    if (storage == storage_of(*current)) {
+        storage_ = storage;
+        return true;
+    }
+
+    auto next = std::make_shared<GallerySnapshot>(*current);
+    compact(*next);
+    if (!build_base(*next, export_rows(*next), storage)) return false;
+    storage_ = storage;
+    publish(std::move(next));
+    return true;
+}
+
+void FeatureLibrary::set_ann(bool enable, size_t min_templates) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    ann_enabled_ = enable;
+    ann_min_templates_ = min_templates;
+
+    auto next = std::make_shared<GallerySnapshot>(*snapshot());
+    compact(*next);
+    publish(std::move(next));
+}
+
+void FeatureLibrary::update_index(GallerySnapshot& next) {
+    if (next.quantized || next.half) return;
+
+    size_t count = next.index ? next.index->size() : next.base->size();
+    bool want = ann_enabled_ && count > 0 && count >= ann_min_templates_;
+    if (want == (next.index != nullptr)) return;
+
+    if (want) {
+        next.index = build_index(*next.base);
+        next.base = std::make_shared<FeatureMatrix>(next.base->dim()); // 模板已移入索引
+        next.partitions.clear();
+    } else {
+        FeatureMatrix rows(next.delta.dim());
+        next.index->export_to(rows);
+        next.base = std::make_shared<FeatureMatrix>(partition_rows(next, std::move(rows), next.partitions));
+        next.index.reset();
+    }
+}
+
+std::shared_ptr<const IvfIndex> FeatureLibrary::build_index(const FeatureMatrix& rows) {
+    auto t0 = std::chrono::steady_clock::now();
+    auto index = std::make_shared<IvfIndex>(rows.dim());
+    int nlist = std::max(1, static_cast<int>(std::lround(std::sqrt(static_cast<double>(rows.size())))));
+
+    // 同一数据库训练的聚类中心与当前规模相差不大时直接复用 (免去 k-means)，否则重新训练并保存；
+    // 未打开数据库 (工具/测试) 时无法确认来源，总是重新训练且不写文件
+    db::FaceFeatureDao dao;
+    db::FeatureRevision revision;
+    bool have_gallery = dao.get_revision(revision);
+    bool restored = have_gallery && index->load_centroids(index_path_, revision.instance) &&
+                    index->nlist() * 2 >= nlist && index->nlist() <= nlist * 2;
+    if (!restored) {
+        index->train(rows, nlist, Config::Gallery::IVF_TRAIN_ITERATIONS);
+        if (have_gallery) index->save_centroids(index_path_, revision.instance);
+    }
+
+    index->clear();
+    for (size_t i = 0; i < rows.size(); i++) {
+        index->add(rows.id(i), rows.row(i));
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << "[FeatureLibrary] IVF index " << (restored ? "restored" : "trained")
+              << ": " << index->size() << " templates, " << index->nlist() << " lists, "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms" << std::endl;
+    return index;
+}
+
+size_t FeatureLibrary::template_count() {
+    Snapshot snap = snapshot();
+    size_t count = snap->delta.size();
+    if (snap->quantized) return count + snap->quantized->size();
+    if (snap->half) return count + snap->half->size();
+    return count + (snap->index ? snap->index->size() : snap->base->size());
+}
+
+size_t FeatureLibrary::memory_bytes() {
+    Snapshot snap = snapshot();
+    auto matrix_bytes = [](const FeatureMatrix& m) {
+        return m.size() * m.stride() * sizeof(float) + m.size() * sizeof(int64_t);
+    };
+    size_t bytes = matrix_bytes(snap->delta);
+    if (snap->quantized) return bytes + snap->quantized->memory_bytes();
+    if (snap->half) return bytes + snap->half->memory_bytes();
+    if (snap->index) return bytes + snap->index->memory_bytes();
+    return bytes + matrix_bytes(*snap->base);
+}
+
 void FeatureLibrary::load_from_database() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(update_mutex_);
+    const int dim = Config::Model::FEATURE_DIM;
+    auto t0 = std::chrono::steady_clock::now();
+
+    // 读库与构建期间检索继续使用旧快照
     db::FaceFeatureDao dao;
-    auto db_features = dao.get_all_features();
-    
-    features_.clear();
-    for (const auto& df : db_features) {
-        LoadedFeature lf;
-        lf.user_id = df.user_id;
-        lf.feature = df.feature_vector;
-        normalize(lf.feature);
-        features_.push_back(lf);
-    }
-    
-    std::cout << "Loaded " << features_.size() << " face features from database." << std::endl;
-}
-
-int64_t FeatureLibrary::search(const std::vector<float>& feature, float threshold, float& out_similarity) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // 输入特征也需要归一化
-    std::vector<float> input_norm = feature;
-    normalize(input_norm);
-    
-    int64_t best_user_id = -1;
-    float max_sim = -1.0f;
-    
-    for (const auto& lf : features_) {
-        float sim = cosine_similarity(input_norm, lf.feature);
-        if (sim > max_sim) {
-            max_sim = sim;
-            best_user_id = lf.user_id;
-        }
-    }
-    
-    out_similarity = max_sim;
-    if (max_sim >= threshold) {
-        return best_user_id;
-    }
-    
+    db::FeatureRevision revision;
+    bool have_revision = dao.get_revision(revision);
+
+    // 半精度存储无论如何都会舍入模板，可以接受半精度舍入过的快照文件；其他存储只接受精确模板
+    FeatureMatrix rows(dim);
+    GalleryPrecision precision = GalleryPrecision::EXACT;
+    GalleryPrecision accept = storage_ == Storage::FLOAT16 ? GalleryPrecision::FP16 : GalleryPrecision::EXACT;
+    bool from_file = have_revision && load_gallery_file(snapshot_path_, revision, rows, accept, &precision);
+    if (!from_file) {
+        auto db_features = dao.get_all_features();
+        rows.reserve(db_features.size());
+        for (const auto& df : db_features) {
+            if (df.feature_vector.empty()) {
+                std::cerr << "[FeatureLibrary] invalid feature of user " << df.user_id << ", skipped" << std::endl;
+                continue;
+            }
+            rows.append(df.user_id, df.feature_vector.data()); // DAO 读取时已归一化
+        }
+    }
+
+    db::UserDao user_dao;
+    auto db_users = user_dao.get_all_active_users();
+
+    auto users = std::make_shared<std::unordered_map<int64_t, UserInfo>>();
+    auto departments = std::make_shared<std::unordered_map<std::string, int>>();
+    users->reserve(db_users.size());
+    for (const auto& u : db_users) {
+        UserInfo info;
+        info.user_id = u.user_id;
+        info.name = u.user_name;
+        info.department = u.department;
+        info.status = u.status;
+        info.tag = assign_tag(u, *departments);
+        (*users)[u.user_id] = info;
+    }
+
+    auto next = std::make_shared<GallerySnapshot>(dim);
+    next->users = std::move(users);
+    next->department_tags = std::move(departments);
+    next->rounded = from_file && precision != GalleryPrecision::EXACT;
+    size_t count = rows.size();
+    if (!build_base(*next, std::move(rows), storage_)) {
+        // 映射文件不可用：本次加载退回 float 存储 (失败时 rows 未被移走)
+        build_base(*next, std::move(rows), Storage::FLOAT32);
+        storage_ = Storage::FLOAT32;
+    }
+    const char* format = next->quantized ? " int8" : next->half ? " fp16" : "";
+    size_t user_count = next->users->size();
+    publish(next);
+    if (have_revision && !from_file) {
+        schedule_save(std::move(next)); // 快照文件缺失或过期，按数据库内容重写
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout << "Loaded " << count << format << " face features"
+              << (from_file ? " (snapshot file)" : "") << ", "
+              << user_count << " users from database in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms." << std::endl;
+}
+
+void FeatureLibrary::add_user(const db::User& user, const Embedding& feature) {
+    add_user_templates(user, {feature});
+}
+
+void FeatureLibrary::add_user_templates(const db::User& user, const std::vector<Embedding>& features) {
+    add_users({{user, features}});
+}
+
+void FeatureLibrary::add_users(const std::vector<UserTemplates>& entries) {
+    if (entries.empty()) return;
+    std::lock_guard<std::mutex> lock(update_mutex_);
+
+    Snapshot current = snapshot();
+    auto next = std::make_shared<GallerySnapshot>(*current);
+    auto users = std::make_shared<std::unordered_map<int64_t, UserInfo>>(*current->users);
+    auto departments = std::make_shared<std::unordered_map<std::string, int>>(*current->department_tags);
+    for (const auto& entry : entries) {
+        stage_user(*next, *users, *departments, entry.user, entry.features);
+    }
+    next->users = std::move(users);
+    next->department_tags = std::move(departments);
+
+    maybe_compact(*next);
+    publish(next);
+    schedule_save(std::move(next));
+}
+
+void FeatureLibrary::stage_user(GallerySnapshot& next, std::unordered_map<int64_t, UserInfo>& users,
+                                std::unordered_map<std::string, int>& departments,
+                                const db::User& user, const std::vector<Embedding>& features) {
+    for (const auto& feature : features) {
+        if (feature.empty()) {
+            std::cerr << "[FeatureLibrary] empty feature of user " << user.user_id << ", skipped" << std::endl;
+            continue;
+        }
+        next.delta.append(user.user_id, feature.data());
+    }
+
+    UserInfo info;
+    info.user_id = user.user_id;
+    info.name = user.user_name;
+    info.department = user.department;
+    info.status = user.status;
+    info.tag = assign_tag(user, departments);
+    users[user.user_id] = info;
+}
+
+void FeatureLibrary::remove_user(int64_t user_id) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+
+    Snapshot current = snapshot();
+    auto next = std::make_shared<GallerySnapshot>(*current);
+    next->delta.remove(user_id);
+    next->removed.insert(user_id);
+    auto users = std::make_shared<std::unordered_map<int64_t, UserInfo>>(*current->users);
+    users->erase(user_id);
+    next->users = std::move(users);
+
+    maybe_compact(*next);
+    publish(next);
+    schedule_save(std::move(next));
+}
+
+void FeatureLibrary::update_user(const db::User& user) {
+    std::lock_guard<std::mutex> lock(update_mutex_);
+
+    // 用户的模板可能在某个标签分区中：与重新注册相同，基础存储中的旧行按删除处理，模板重新放入增量区
+    FeatureMatrix rows(Config::Model::FEATURE_DIM);
+    export_users({user.user_id}, rows);
+
+    Snapshot current = snapshot();
+    auto next = std::make_shared<GallerySnapshot>(*current);
+    auto users = std::make_shared<std::unordered_map<int64_t, UserInfo>>(*current->users);
+    auto departments = std::make_shared<std::unordered_map<std::string, int>>(*current->department_tags);
+    next->delta.remove(user.user_id);
+    next->removed.insert(user.user_id);
+    for (size_t i = 0; i < rows.size(); i++) {
+        next->delta.append(user.user_id, rows.row(i)); // 已归一化的行原样放回
+    }
+    stage_user(*next, *users, *departments, user, {});
+    next->users = std::move(users);
+    next->department_tags = std::move(departments);
+
+    maybe_compact(*next);
+    publish(std::move(next)); // 模板未变，快照文件无需重写
+}
+
+void FeatureLibrary::maybe_compact(GallerySnapshot& next) {
+    if (next.delta.size() > Config::Gallery::DELTA_MAX_TEMPLATES ||
+        next.removed.size() > Config::Gallery::DELTA_MAX_REMOVED) {
+        compact(next);
+    }
+}
+
+void FeatureLibrary::compact(GallerySnapshot& next) {
+    if (!next.delta.empty() || !next.removed.empty()) {
+        // 在基础存储的副本上修改，旧快照的读者不受影响
+        if (next.quantized) {
+            // 有效行 (ID, float 行号)：删除用户的 float 行保留到下次整库加载，增量模板追加到 float 存储
+            const QuantizedFeatureMatrix& old = *next.quantized;
+            std::vector<int64_t> ids;
+            std::vector<uint32_t> float_rows;
+            ids.reserve(old.size() + next.delta.size());
+            float_rows.reserve(ids.capacity());
+            for (size_t i = 0; i < old.size(); i++) {
+                if (next.removed.count(old.id(i))) continue;
+                ids.push_back(old.id(i));
+                float_rows.push_back(old.float_row(i));
+            }
+            for (size_t i = 0; i < next.delta.size(); i++) {
+                long r = next.float_store->append(next.delta.row(i));
+                if (r < 0) {
+                    std::cerr << "[FeatureLibrary] float store full, feature of user " << next.delta.id(i)
+                              << " skipped" << std::endl;
+                    continue;
+                }
+                ids.push_back(next.delta.id(i));
+                float_rows.push_back(static_cast<uint32_t>(r));
+            }
+
+            // 按标签重排后从精确 float 向量重新量化 (量化是确定的，旧行结果不变)
+            auto quantized = std::make_shared<QuantizedFeatureMatrix>(old.dim());
+            quantized->reserve(ids.size());
+            for (size_t i : partition_order(next, ids)) {
+                quantized->append(ids[i], next.float_store->row(float_rows[i]), float_rows[i]);
+            }
+            next.partitions = count_partitions(next, quantized->size(), [&](size_t i) { return quantized->id(i); });
+            next.quantized = std::move(quantized);
+        } else if (next.half) {
+            // 半精度转回 float 再转换是精确的，旧行不受影响
+            next.half = partition_half(next, export_rows(next), next.partitions);
+        } else if (next.index) {
+            auto index = std::make_shared<IvfIndex>(*next.index);
+            for (int64_t id : next.removed) index->remove(id);
+            for (size_t i = 0; i < next.delta.size(); i++) {
+                index->add(next.delta.id(i), next.delta.row(i));
+            }
+            next.index = std::move(index);
+        } else {
+            next.base = std::make_shared<FeatureMatrix>(partition_rows(next, export_rows(next), next.partitions));
+        }
+        next.delta = FeatureMatrix(next.delta.dim());
+        next.removed.clear();
+    }
+    update_index(next);
+}
+
+FeatureMatrix FeatureLibrary::export_rows(const GallerySnapshot& snap) {
+    FeatureMatrix rows(snap.delta.dim());
+    if (snap.quantized) {
+        const QuantizedFeatureMatrix& q = *snap.quantized;
+        rows.reserve(q.size() + snap.delta.size());
+        for (size_t i = 0; i < q.size(); i++) {
+            rows.append(q.id(i), snap.float_store->row(q.float_row(i)));
+        }
+    } else if (snap.half) {
+        const HalfFeatureMatrix& h = *snap.half;
+        std::vector<float> row(h.dim());
+        rows.reserve(h.size() + snap.delta.size());
+        for (size_t i = 0; i < h.size(); i++) {
+            h.decode(i, row.data());
+            rows.append(h.id(i), row.data());
+        }
+    } else if (snap.index) {
+        snap.index->export_to(rows);
+    } else if (snap.base) {
+        rows = *snap.base;
+    }
+
+    for (int64_t id : snap.removed) rows.remove(id);
+    rows.reserve(rows.size() + snap.delta.size());
+    for (size_t i = 0; i < snap.delta.size(); i++) {
+        rows.append(snap.delta.id(i), snap.delta.row(i));
+    }
+    return rows;
+}
+
+uint64_t FeatureLibrary::export_users(const std::unordered_set<int64_t>& user_ids, FeatureMatrix& out, TagFilter filter) {
+    // 先读版本号再取快照：期间有新快照发布时返回的版本号偏旧，调用方只会多读一次
+    uint64_t version = version_.load();
+    Snapshot snap = snapshot();
+    if (user_ids.empty()) return version;
+    TagMask tags = resolve_tags(*snap, filter);
+
+    auto selected = [&](int64_t id) { return user_ids.count(id) && tag_allowed(*snap, id, tags); };
+    auto wanted = [&](int64_t id) { return selected(id) && !snap->removed.count(id); };
+    if (snap->quantized) {
+        const QuantizedFeatureMatrix& q = *snap->quantized;
+        for (size_t i = 0; i < q.size(); i++) {
+            if (wanted(q.id(i))) out.append(q.id(i), snap->float_store->row(q.float_row(i)));
+        }
+    } else if (snap->half) {
+        const HalfFeatureMatrix& h = *snap->half;
+        std::vector<float> row(h.dim());
+        for (size_t i = 0; i < h.size(); i++) {
+            if (!wanted(h.id(i))) continue;
+            h.decode(i, row.data());
+            out.append(h.id(i), row.data());
+        }
+    } else if (snap->index) {
+        snap->index->for_each([&](int64_t id, const float* row) {
+            if (wanted(id)) out.append(id, row);
+        });
+    } else {
+        const FeatureMatrix& base = *snap->base;
+        for (size_t i = 0; i < base.size(); i++) {
+            if (wanted(base.id(i))) out.append(base.id(i), base.row(i));
+        }
+    }
+    for (size_t i = 0; i < snap->delta.size(); i++) {
+        if (selected(snap->delta.id(i))) out.append(snap->delta.id(i), snap->delta.row(i));
+    }
+    return version;
+}
+
+bool FeatureLibrary::build_base(GallerySnapshot& next, FeatureMatrix&& rows, Storage storage) {
+    if (storage == Storage::INT8) {
+        auto store = std::make_shared<MappedFeatureFile>();
+        if (!store->open(float_store_path_, rows.dim(), Config::Gallery::FLOAT_STORE_MAX_TEMPLATES)) {
+            return false;
+        }
+        auto matrix = std::make_shared<QuantizedFeatureMatrix>(rows.dim());
+        matrix->reserve(rows.size());
+        for (size_t i : partition_order(next, rows.ids())) {
+            long r = store->append(rows.row(i));
+            if (r >= 0) matrix->append(rows.id(i), rows.row(i), static_cast<uint32_t>(r));
+        }
+        if (matrix->size() < rows.size()) {
+            std::cerr << "[FeatureLibrary] float store full (" << Config::Gallery::FLOAT_STORE_MAX_TEMPLATES
+                      << " templates), " << rows.size() - matrix->size() << " features skipped" << std::endl;
+        }
+        next.partitions = count_partitions(next, matrix->size(), [&](size_t i) { return matrix->id(i); });
+        next.quantized = std::move(matrix);
+        next.float_store = std::move(store);
+        next.half.reset();
+        next.base.reset();
+        next.index.reset();
+        return true;
+    }
+    if (storage == Storage::FLOAT16) {
+        next.half = partition_half(next, std::move(rows), next.partitions);
+        next.rounded = true; // 切回其他存储后模板仍是舍入后的值，直到从数据库重新加载
+        next.base.reset();
+        next.quantized.reset();
+        next.float_store.reset();
+        next.index.reset();
+        return true;
+    }
+
+    next.base = std::make_shared<FeatureMatrix>(partition_rows(next, std::move(rows), next.partitions));
+    next.quantized.reset();
+    next.float_store.reset();
+    next.half.reset();
+    next.index.reset();
+    update_index(next);
+    return true;
+}
+
+bool FeatureLibrary::get_user(int64_t user_id, UserInfo& out) {
+    Snapshot snap = snapshot();
+    auto it = snap->users->find(user_id);
+    if (it == snap->users->end() || it->second.status != 1) return false;
+    out = it->second;
+    return true;
+}
+
+int64_t FeatureLibrary::search(const Embedding& feature, float threshold, float& out_similarity, TagFilter tags) {
+    if (feature.empty()) {
+        out_similarity = 0.0f;
+        return -1;
+    }
+
+    Snapshot snap = snapshot();
+    TopKUsers top(1);
+    collect(*snap, feature.data(), 1, resolve_tags(*snap, tags), top);
+
+    std::vector<SearchMatch> best = top.sorted();
+    if (best.empty()) {
+        out_similarity = -1.0f;
+        return -1;
+    }
+
+    out_similarity = best[0].similarity;
+    if (best[0].similarity >= threshold) {
+        return best[0].user_id;
+    }
+
     return -1;
 }
 
-float FeatureLibrary::cosine_similarity(const std::vector<float>& f1, const std::vector<float>& f2) {
-    if (f1.size() != f2.size() || f1.empty()) return 0.0f;
-    
-    // 假设都已经归一化了，dot product 就是 cosine similarity
-    float dot = 0.0f;
-    for (size_t i = 0; i < f1.size(); ++i) {
-        dot += f1[i] * f2[i];
+std::vector<SearchMatch> FeatureLibrary::search_topk(const Embedding& feature, int k, float* out_margin,
+                                                     TagFilter tags) {
+    if (out_margin) *out_margin = 0.0f;
+    if (k <= 0 || feature.empty()) return {};
+
+    Snapshot snap = snapshot();
+    TopKUsers top(k);
+    collect(*snap, feature.data(), k, resolve_tags(*snap, tags), top);
+    return finish(top, out_margin);
+}
+
+std::vector<std::vector<SearchMatch>> FeatureLibrary::search_batch(const std::vector<Embedding>& queries, int k,
+                                                                   std::vector<float>* out_margins, TagFilter filter) {
+    const int dim = Config::Model::FEATURE_DIM;
+    size_t nq = queries.size();
+    std::vector<std::vector<SearchMatch>> results(nq);
+    if (out_margins) out_margins->assign(nq, 0.0f);
+    if (k <= 0 || nq == 0) return results;
+
+    // 查询已归一化且在 vector 中按 EMBEDDING_STRIDE 连续排列，全部有效时直接作为 nq × dim 的小矩阵扫描；
+    // 有空查询时才把有效查询复制到一起
+    std::vector<size_t> valid;
+    valid.reserve(nq);
+    for (size_t q = 0; q < nq; q++) {
+        if (!queries[q].empty()) valid.push_back(q);
+    }
+    if (valid.empty()) return results;
+
+    const float* matrix = queries[0].data();
+    size_t q_stride = EMBEDDING_STRIDE;
+    std::vector<float, AlignedAllocator<float>> packed;
+    if (valid.size() < nq) {
+        packed.resize(valid.size() * dim);
+        for (size_t i = 0; i < valid.size(); i++) {
+            memcpy(packed.data() + i * dim, queries[valid[i]].data(), dim * sizeof(float));
+        }
+        matrix = packed.data();
+        q_stride = dim;
+    }
+
+    Snapshot snap = snapshot();
+    TagMask tags = resolve_tags(*snap, filter);
+    if (tags == 0) return results;
+    std::vector<TopKUsers> tops(valid.size(), TopKUsers(k));
+    if (snap->quantized || snap->half || snap->index) {
+        // int8 / 半精度扫描带宽已降为 1/4 / 1/2、IVF 只扫描少量倒排表，逐个查询执行
+        for (size_t i = 0; i < valid.size(); i++) {
+            collect(*snap, queries[valid[i]].data(), k, tags, tops[i]);
+        }
+    } else {
+        const FeatureMatrix& base = *snap->base;
+        const auto& removed = snap->removed;
+        int nv = static_cast<int>(valid.size());
+        std::vector<RowRange> ranges = select_ranges(*snap, base.size(), tags);
+        auto scan = [&](std::vector<TopKUsers>& out, size_t begin, size_t end) {
+            base.scan_batch_range(matrix, q_stride, nv, begin, end, [&](int q, size_t index, float score) {
+                if (!out[q].accepts(score)) return;
+                if (!removed.empty() && removed.count(base.id(index))) return;
+                out[q].offer(base.id(index), score);
+            });
+        };
+
+        std::vector<std::vector<TopKUsers>>& partial = shard_batch_tops(valid.size(), k);
+        if (run_sharded(ranges, [&](int worker, size_t begin, size_t end) { scan(partial[worker], begin, end); })) {
+            for (const auto& p : partial) {
+                for (int q = 0; q < nv; q++) tops[q].merge(p[q]);
+            }
+        } else {
+            for (const auto& r : ranges) scan(tops, r.begin, r.end);
+        }
+        snap->delta.scan_batch(matrix, q_stride, nv, [&](int q, size_t index, float score) {
+            if (!tops[q].accepts(score) || !tag_allowed(*snap, snap->delta.id(index), tags)) return;
+            tops[q].offer(snap->delta.id(index), score);
+        });
+    }
+
+    for (size_t i = 0; i < valid.size(); i++) {
+        results[valid[i]] = finish(tops[i], out_margins ? &(*out_margins)[valid[i]] : nullptr);
+    }
+    return results;
+}
+
+std::vector<SearchMatch> FeatureLibrary::finish(const TopKUsers& top, float* out_margin) {
+    std::vector<SearchMatch> matches = top.sorted();
+    if (out_margin && !matches.empty()) {
+        float runner_up = (matches.size() > 1) ? matches[1].similarity : 0.0f;
+        *out_margin = matches[0].similarity - runner_up;
     }
-    return dot;
+    return matches;
 }
 
-void FeatureLibrary::normalize(std::vector<float>& feature) {
-    float sq_sum = 0.0f;
-    for (float v : feature) {
-        sq_sum += v * v;
+void FeatureLibrary::collect(const GallerySnapshot& snap, const float* query, int k, TagMask tags, TopKUsers& top) {
+    if (tags == 0) return;
+    if (snap.quantized) {
+        collect_quantized(snap, query, k, tags, top);
+    } else {
+        collect_float(snap, query, k, tags, top);
     }
-    float norm = std::sqrt(sq_sum);
-    if (norm > 1e-6) {
-        for (float& v : feature) {
-            v /= norm;
+
+    // 增量区的模板总是精确扫描 (不分区，只对能进入前 k 的行查标签)
+    snap.delta.scan(query, [&](size_t index, float score) {
+        if (!top.accepts(score) || !tag_allowed(snap, snap.delta.id(index), tags)) return;
+        top.offer(snap.delta.id(index), score);
+    });
+}
+
+// 已删除用户的模板在合并前仍在基础存储中：只对能进入前 k 的行查删除表
+static void offer_unless_removed(const GallerySnapshot& snap, TopKUsers& out, int64_t user_id, float score) {
+    if (!out.accepts(score)) return;
+    if (!snap.removed.empty() && snap.removed.count(user_id)) return;
+    out.offer(user_id, score);
+}
+
+// 精确扫描按标签分区的基础存储 (float 或半精度矩阵)，只扫描位图中标签的分区
+template <typename Matrix>
+static void scan_partitions(const GallerySnapshot& snap, const Matrix& base, const float* query, int k, TagMask tags,
+                            TopKUsers& top) {
+    std::vector<RowRange> ranges = select_ranges(snap, base.size(), tags);
+    auto scan = [&](TopKUsers& out, size_t begin, size_t end) {
+        base.scan_range(query, begin, end, [&](size_t index, float score) {
+            offer_unless_removed(snap, out, base.id(index), score);
+        });
+    };
+
+    std::vector<TopKUsers>& partial = shard_tops(k);
+    if (run_sharded(ranges, [&](int worker, size_t begin, size_t end) { scan(partial[worker], begin, end); })) {
+        for (const auto& p : partial) top.merge(p);
+    } else {
+        for (const auto& r : ranges) scan(top, r.begin, r.end);
+    }
+}
+
+void FeatureLibrary::collect_float(const GallerySnapshot& snap, const float* query, int k, TagMask tags,
+                                   TopKUsers& top) {
+    if (snap.index) {
+        // 倒排表不分区：能进入前 k 的行再查用户标签
+        snap.index->search(query, Config::Gallery::IVF_NPROBE, [&](int64_t user_id, float score) {
+            if (!top.accepts(score) || !tag_allowed(snap, user_id, tags)) return;
+            offer_unless_removed(snap, top, user_id, score);
+        });
+    } else if (snap.half) {
+        scan_partitions(snap, *snap.half, query, k, tags, top);
+    } else {
+        scan_partitions(snap, *snap.base, query, k, tags, top);
+    }
+}
+
+void FeatureLibrary::collect_quantized(const GallerySnapshot& snap, const float* query, int k, TagMask tags,
+                                       TopKUsers& top) {
+    const int dim = Config::Model::FEATURE_DIM;
+    alignas(CACHE_LINE_SIZE) int8_t query_i8[dim];
+    float query_scale = feature_quantize_i8(query, dim, query_i8);
+
+    // 同一用户可能占用多个候选，k 较大时按比例多取
+    const QuantizedFeatureMatrix& gallery = *snap.quantized;
+    int num_candidates = std::max(Config::Gallery::RERANK_CANDIDATES, k * 4);
+    std::vector<ScoredRow> candidates;
+
+    // 并行时每个线程取各自分片中的前 num_candidates 个，合并后再取全局前 num_candidates 个
+    auto better = [](const ScoredRow& a, const ScoredRow& b) { return a.score > b.score; };
+    auto keep_best = [&](std::vector<ScoredRow>& rows) {
+        size_t keep = std::min(rows.size(), static_cast<size_t>(num_candidates));
+        std::partial_sort(rows.begin(), rows.begin() + keep, rows.end(), better);
+        rows.resize(keep);
+    };
+
+    std::vector<RowRange> ranges = select_ranges(snap, gallery.size(), tags);
+    std::vector<std::vector<ScoredRow>>& partial = shard_candidates();
+    bool sharded = run_sharded(ranges, [&](int worker, size_t begin, size_t end) {
+        static thread_local std::vector<ScoredRow> shard; // 属于执行该分片的线程
+        gallery.top_candidates(query_i8, query_scale, num_candidates, shard, begin, end);
+        std::vector<ScoredRow>& mine = partial[worker];
+        mine.insert(mine.end(), shard.begin(), shard.end());
+        if (mine.size() >= static_cast<size_t>(num_candidates) * 4) keep_best(mine);
+    });
+    if (sharded) {
+        for (const auto& p : partial) candidates.insert(candidates.end(), p.begin(), p.end());
+        keep_best(candidates);
+    } else if (ranges.size() == 1) {
+        gallery.top_candidates(query_i8, query_scale, num_candidates, candidates, ranges[0].begin, ranges[0].end);
+    } else {
+        std::vector<ScoredRow> part;
+        for (const auto& r : ranges) {
+            gallery.top_candidates(query_i8, query_scale, num_candidates, part, r.begin, r.end);
+            candidates.insert(candidates.end(), part.begin(), part.end());
         }
+        keep_best(candidates);
+    }
+
+    // 候选用精确 float 向量重排
+    for (const auto& c : candidates) {
+        int64_t user_id = gallery.id(c.index);
+        if (!snap.removed.empty() && snap.removed.count(user_id)) continue;
+        float sim = feature_dot(query, snap.float_store->row(gallery.float_row(c.index)), dim);
+        top.offer(user_id, sim);
     }
 }
 
@@ -0,0 +1,70 @@
+/**
+ * @file feature_matrix.cc
+ * @brief 特征库连续矩阵存储实现
+ */
+
+#include "service/feature_matrix.h"
+#include <cstring>
+
+namespace service {
+
+FeatureMatrix::FeatureMatrix(int dim)
+    : dim_(dim)
+    , stride_((dim * sizeof(float) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE / sizeof(float))
+{
+}
+
+void FeatureMatrix::clear() {
+    data_.clear();
+    ids_.clear();
+}
+
+void FeatureMatrix::reserve(size_t rows) {
+    data_.reserve(rows * stride_);
+    ids_.reserve(rows);
+}
+
+void FeatureMatrix::append(int64_t id, const float* feature) {
+    size_t offset = data_.size();
+    data_.resize(offset + stride_, 0.0f); // 行尾补齐部分保持为 0
+    memcpy(data_.data() + offset, feature, dim_ * sizeof(float));
+    ids_.push_back(id);
+}
+
+void FeatureMatrix::assign(const int64_t* ids, const float* rows, size_t count) {
+    ids_.assign(ids, ids + count);
+    data_.assign(rows, rows + count * stride_);
+}
+
+size_t FeatureMatrix::remove(int64_t id) {
+    size_t kept = 0;
+    for (size_t i = 0; i < ids_.size(); i++) {
+        if (ids_[i] == id) continue;
+        if (kept != i) {
+            ids_[kept] = ids_[i];
+            memcpy(data_.data() + kept * stride_, data_.data() + i * stride_, stride_ * sizeof(float));
+        }
+        kept++;
+    }
+
+    size_t removed = ids_.size() - kept;
+    ids_.resize(kept);
+    data_.resize(kept * stride_);
+    return removed;
+}
+
+long FeatureMatrix::best_match(const float* query, float& out_score) const {
+    long best = -1;
+    float best_score = -1.0f;
+    scan(query, [&](size_t index, float score) {
+        if (score > best_score) {
+            best_score = score;
+            best = static_cast<long>(index);
+        }
+    });
+
+    out_score = best_score;
+    return best;
+}
+
+} // namespace service
@@ -0,0 +1,167 @@
+/**
+ * @file gallery_file.cc
+ * @brief 特征库快照文件实现
+ */
+
+#include "service/gallery_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+
+namespace service {
+
+static const uint32_t GALLERY_FILE_MAGIC = 0x59524c47; // "GLRY"
+static const uint32_t GALLERY_FILE_VERSION = 2; // 2: 文件头增加模板精度
+
+struct GalleryFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dim;
+    uint32_t stride;            // 每行 float 个数 (补齐到缓存行)
+    uint64_t count;             // 模板数
+    int64_t db_instance;        // 对应的数据库 (FeatureRevision)
+    int64_t db_revision;
+    uint64_t checksum;          // ID 数组与矩阵的校验和
+    uint32_t precision;         // GalleryPrecision
+    uint8_t reserved[12];
+};
+static_assert(sizeof(GalleryFileHeader) == CACHE_LINE_SIZE, "header must fill one cache line");
+
+// ID 数组补齐到缓存行，矩阵在文件中同样 64 字节对齐
+static size_t ids_bytes(size_t count) {
+    return (count * sizeof(int64_t) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+// 按 8 字节字计算的 FNV-1a 变体 (所有数据块都是 8 字节的整数倍)
+static uint64_t checksum(const void* data, size_t bytes, uint64_t h) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i + sizeof(uint64_t) <= bytes; i += sizeof(uint64_t)) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        h = (h ^ w) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+static const uint64_t CHECKSUM_SEED = 0xcbf29ce484222325ULL;
+
+static bool write_all(int fd, const void* data, size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t n = ::write(fd, p, bytes);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        bytes -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// rename 只修改目录项：目录本身也要 fsync，掉电后才不会丢失 rename (ext4 / SD 卡)
+static bool fsync_parent_dir(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+bool save_gallery_file(const std::string& path, const FeatureMatrix& rows, const db::FeatureRevision& revision,
+                       GalleryPrecision precision) {
+    size_t count = rows.size();
+    size_t matrix_bytes = count * rows.stride() * sizeof(float);
+    std::vector<unsigned char> ids(ids_bytes(count), 0);
+    if (count > 0) memcpy(ids.data(), rows.ids().data(), count * sizeof(int64_t));
+
+    GalleryFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = GALLERY_FILE_MAGIC;
+    header.version = GALLERY_FILE_VERSION;
+    header.dim = static_cast<uint32_t>(rows.dim());
+    header.stride = static_cast<uint32_t>(rows.stride());
+    header.count = count;
+    header.db_instance = revision.instance;
+    header.db_revision = revision.revision;
+    header.precision = static_cast<uint32_t>(precision);
+    header.checksum = checksum(ids.data(), ids.size(), CHECKSUM_SEED);
+    if (count > 0) header.checksum = checksum(rows.row(0), matrix_bytes, header.checksum);
+
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "[GalleryFile] cannot write " << tmp << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    bool ok = write_all(fd, &header, sizeof(header)) && write_all(fd, ids.data(), ids.size()) &&
+              (count == 0 || write_all(fd, rows.row(0), matrix_bytes)) && fsync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        std::cerr << "[GalleryFile] cannot write " << path << ": " << strerror(errno) << std::endl;
+        unlink(tmp.c_str());
+        return false;
+    }
+    if (!fsync_parent_dir(path)) {
+        std::cerr << "[GalleryFile] cannot sync directory of " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool load_gallery_file(const std::string& path, const db::FeatureRevision& revision, FeatureMatrix& out,
+                       GalleryPrecision accept, GalleryPrecision* out_precision) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(GalleryFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t file_bytes = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, file_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    madvise(p, file_bytes, MADV_SEQUENTIAL);
+
+    const unsigned char* base = static_cast<const unsigned char*>(p);
+    GalleryFileHeader header;
+    memcpy(&header, base, sizeof(header));
+
+    bool ok = header.magic == GALLERY_FILE_MAGIC && header.version == GALLERY_FILE_VERSION &&
+              header.dim == static_cast<uint32_t>(out.dim()) && header.stride == out.stride() &&
+              header.db_instance == revision.instance && header.db_revision == revision.revision &&
+              header.precision <= static_cast<uint32_t>(accept);
+
+    size_t count = static_cast<size_t>(header.count);
+    size_t ids_size = ids_bytes(count);
+    size_t matrix_bytes = count * out.stride() * sizeof(float);
+    ok = ok && file_bytes == sizeof(header) + ids_size + matrix_bytes;
+
+    if (ok) {
+        const unsigned char* ids = base + sizeof(header);
+        const unsigned char* matrix = ids + ids_size;
+        uint64_t sum = checksum(matrix, matrix_bytes, checksum(ids, ids_size, CHECKSUM_SEED));
+        if (sum != header.checksum) {
+            std::cerr << "[GalleryFile] checksum mismatch in " << path << std::endl;
+            ok = false;
+        } else {
+            out.assign(reinterpret_cast<const int64_t*>(ids), reinterpret_cast<const float*>(matrix), count);
+            if (out_precision) *out_precision = static_cast<GalleryPrecision>(header.precision);
+        }
+    }
+
+    munmap(p, file_bytes);
+    return ok;
+}
+
+} // namespace service
@@ -0,0 +1,37 @@
+/**
+ * @file half_matrix.cc
+ * @brief 半精度特征库矩阵实现
+ */
+
+#include "service/half_matrix.h"
+
+namespace service {
+
+HalfFeatureMatrix::HalfFeatureMatrix(int dim)
+    : dim_(dim)
+    , stride_((dim * sizeof(uint16_t) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE / sizeof(uint16_t))
+{
+}
+
+void HalfFeatureMatrix::clear() {
+    data_.clear();
+    ids_.clear();
+}
+
+void HalfFeatureMatrix::reserve(size_t rows) {
+    data_.reserve(rows * stride_);
+    ids_.reserve(rows);
+}
+
+void HalfFeatureMatrix::append(int64_t id, const float* feature) {
+    size_t offset = data_.size();
+    data_.resize(offset + stride_, 0); // 行尾补齐部分保持为 0
+    feature_f32_to_f16(feature, dim_, data_.data() + offset);
+    ids_.push_back(id);
+}
+
+size_t HalfFeatureMatrix::memory_bytes() const {
+    return data_.capacity() * sizeof(uint16_t) + ids_.capacity() * sizeof(int64_t);
+}
+
+} // namespace service
@@ -0,0 +1,149 @@
+/**
+ * @file hot_gallery.cc
+ * @brief 最近匹配用户的热层实现
+ */
+
+#include "service/hot_gallery.h"
+#include "service/feature_library.h"
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace service {
+
+static double elapsed_ms(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count() / 1000.0;
+}
+
+HotGallery::HotGallery(size_t max_templates)
+    : max_templates_(max_templates)
+    , rows_(Config::Model::FEATURE_DIM)
+    , version_(0)
+    , dirty_(false)
+{
+}
+
+void HotGallery::touch(int64_t user_id) {
+    if (max_templates_ == 0) return;
+
+    auto it = std::find(lru_.begin(), lru_.end(), user_id);
+    if (it != lru_.end()) {
+        std::rotate(lru_.begin(), it, it + 1); // 已在热层：只调整顺序
+        return;
+    }
+    lru_.insert(lru_.begin(), user_id);
+    dirty_ = true;
+}
+
+void HotGallery::clear() {
+    lru_.clear();
+    rows_.clear();
+    dirty_ = false;
+}
+
+HotGallery::Stats HotGallery::take_stats() {
+    Stats stats = stats_;
+    stats_ = Stats();
+    return stats;
+}
+
+void HotGallery::refresh() {
+    FeatureLibrary& library = FeatureLibrary::instance();
+    if (!dirty_ && version_ == library.version()) return;
+    dirty_ = false;
+
+    // 只取本机默认过滤范围内的用户 (与全库检索一致)：热层提前返回时不再检查标签
+    FeatureMatrix rows(Config::Model::FEATURE_DIM);
+    version_ = library.export_users(std::unordered_set<int64_t>(lru_.begin(), lru_.end()), rows, TAGS_DEFAULT);
+
+    // 已删除、被禁用或移出站点部门的用户移出热层，其余从最久未匹配的开始淘汰到模板数不超过上限
+    std::unordered_map<int64_t, size_t> per_user;
+    for (int64_t id : rows.ids()) per_user[id]++;
+    lru_.erase(std::remove_if(lru_.begin(), lru_.end(), [&](int64_t id) { return !per_user.count(id); }), lru_.end());
+
+    size_t total = rows.size();
+    std::unordered_set<int64_t> evicted;
+    while (total > max_templates_ && !lru_.empty()) {
+        total -= per_user[lru_.back()];
+        evicted.insert(lru_.back());
+        lru_.pop_back();
+    }
+
+    if (evicted.empty()) {
+        rows_ = std::move(rows);
+        return;
+    }
+    rows_.clear();
+    rows_.reserve(total);
+    for (size_t i = 0; i < rows.size(); i++) {
+        if (!evicted.count(rows.id(i))) rows_.append(rows.id(i), rows.row(i));
+    }
+}
+
+std::vector<std::vector<SearchMatch>> HotGallery::search_batch(const std::vector<Embedding>& queries, int k,
+                                                               float threshold, std::vector<float>* out_margins,
+                                                               std::vector<bool>* out_hot) {
+    size_t nq = queries.size();
+    std::vector<std::vector<SearchMatch>> results(nq);
+    if (out_margins) out_margins->assign(nq, 0.0f);
+    if (out_hot) out_hot->assign(nq, false);
+    if (k <= 0 || nq == 0) return results;
+
+    auto t0 = std::chrono::steady_clock::now();
+    if (max_templates_ > 0) refresh();
+
+    // 1. 热层：查询已归一化且连续排列，原地整批扫描一次 (热层很小，总在缓存中；空查询照常扫描但不参与判定)
+    std::vector<bool> hot(nq, false);
+    if (!rows_.empty()) {
+        std::vector<TopKUsers> tops(nq, TopKUsers(std::max(k, 2)));
+        rows_.scan_batch(queries[0].data(), EMBEDDING_STRIDE, static_cast<int>(nq), [&](int q, size_t index, float score) {
+            tops[q].offer(rows_.id(index), score);
+        });
+
+        // 热层外可能有更接近的用户：只有第一名足够高且明显领先热层其他用户时才提前返回
+        for (size_t q = 0; q < nq; q++) {
+            if (queries[q].empty()) continue;
+            std::vector<SearchMatch> matches = tops[q].sorted();
+            if (matches.empty() || matches[0].similarity < threshold + Config::Gallery::HOT_EXIT_MARGIN) continue;
+            float margin = matches[0].similarity - (matches.size() > 1 ? matches[1].similarity : 0.0f);
+            if (margin < Config::Recognition::MATCH_MARGIN) continue;
+
+            if (static_cast<int>(matches.size()) > k) matches.resize(k);
+            results[q] = std::move(matches);
+            if (out_margins) (*out_margins)[q] = margin;
+            hot[q] = true;
+            stats_.hot_hits++;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    // 2. 未命中的查询整批检索全库 (全部未命中时不复制查询)
+    int hits = static_cast<int>(std::count(hot.begin(), hot.end(), true));
+    if (hits == 0) {
+        results = FeatureLibrary::instance().search_batch(queries, k, out_margins);
+    } else if (hits < static_cast<int>(nq)) {
+        rest_.clear();
+        std::vector<size_t> rest_index;
+        for (size_t q = 0; q < nq; q++) {
+            if (hot[q]) continue;
+            rest_.push_back(queries[q]);
+            rest_index.push_back(q);
+        }
+        std::vector<float> margins;
+        auto matches = FeatureLibrary::instance().search_batch(rest_, k, &margins);
+        for (size_t i = 0; i < rest_.size(); i++) {
+            results[rest_index[i]] = std::move(matches[i]);
+            if (out_margins) (*out_margins)[rest_index[i]] = margins[i];
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    stats_.queries += static_cast<int>(nq);
+    stats_.hot_ms += elapsed_ms(t0, t1);
+    stats_.full_ms += elapsed_ms(t1, t2);
+    if (out_hot) *out_hot = std::move(hot);
+    return results;
+}
+
+} // namespace service
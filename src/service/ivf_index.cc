@@ -0,0 +1,177 @@
+/**
+ * @file ivf_index.cc
+ * @brief IVF-Flat 近似最近邻索引实现
+ */
+
+#include "service/ivf_index.h"
+#include "core/feature_kernels.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace service {
+
+static const uint32_t CENTROID_FILE_MAGIC = 0x43465649; // "IVFC"
+static const uint32_t CENTROID_FILE_VERSION = 2;    // v2: 头部之后记录特征库实例号
+
+// 每个中心参与训练的样本数上限 (训练耗时与 N 无关)
+static const size_t TRAIN_SAMPLES_PER_LIST = 32;
+
+IvfIndex::IvfIndex(int dim)
+    : dim_(dim)
+    , centroids_(dim)
+    , size_(0)
+{
+}
+
+void IvfIndex::train(const FeatureMatrix& data, int nlist, int iterations) {
+    centroids_.clear();
+    lists_.clear();
+    size_ = 0;
+    if (data.empty() || nlist <= 0) return;
+    nlist = static_cast<int>(std::min<size_t>(nlist, data.size()));
+
+    // 训练样本：随机抽取，固定种子保证同一数据得到同一索引
+    std::vector<size_t> samples(data.size());
+    for (size_t i = 0; i < samples.size(); i++) samples[i] = i;
+    std::mt19937 rng(42);
+    std::shuffle(samples.begin(), samples.end(), rng);
+    samples.resize(std::min(samples.size(), static_cast<size_t>(nlist) * TRAIN_SAMPLES_PER_LIST));
+
+    for (int c = 0; c < nlist; c++) {
+        centroids_.append(c, data.row(samples[c]));
+    }
+
+    std::vector<float> sums(static_cast<size_t>(nlist) * dim_);
+    std::vector<int> counts(nlist);
+    std::vector<int> probe;
+    for (int it = 0; it < iterations; it++) {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(counts.begin(), counts.end(), 0);
+
+        for (size_t s : samples) {
+            const float* v = data.row(s);
+            nearest_lists(v, 1, probe);
+            float* sum = sums.data() + static_cast<size_t>(probe[0]) * dim_;
+            for (int d = 0; d < dim_; d++) sum[d] += v[d];
+            counts[probe[0]]++;
+        }
+
+        // 球面 k-means：新中心为成员之和的方向；空簇保留原中心
+        FeatureMatrix next(dim_);
+        next.reserve(nlist);
+        for (int c = 0; c < nlist; c++) {
+            float* sum = sums.data() + static_cast<size_t>(c) * dim_;
+            if (counts[c] == 0) {
+                next.append(c, centroids_.row(c));
+            } else {
+                feature_normalize(sum, dim_);
+                next.append(c, sum);
+            }
+        }
+        centroids_ = std::move(next);
+    }
+
+    lists_.assign(nlist, FeatureMatrix(dim_));
+}
+
+bool IvfIndex::save_centroids(const std::string& path, int64_t gallery) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "[IvfIndex] cannot write " << path << std::endl;
+        return false;
+    }
+
+    uint32_t header[4] = {CENTROID_FILE_MAGIC, CENTROID_FILE_VERSION,
+                          static_cast<uint32_t>(dim_), static_cast<uint32_t>(nlist())};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&gallery), sizeof(gallery));
+    for (size_t c = 0; c < centroids_.size(); c++) {
+        out.write(reinterpret_cast<const char*>(centroids_.row(c)), dim_ * sizeof(float));
+    }
+    return static_cast<bool>(out);
+}
+
+bool IvfIndex::load_centroids(const std::string& path, int64_t gallery) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    uint32_t header[4];
+    int64_t trained_on = 0;
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != CENTROID_FILE_MAGIC || header[1] != CENTROID_FILE_VERSION ||
+        header[2] != static_cast<uint32_t>(dim_) || header[3] == 0 ||
+        !in.read(reinterpret_cast<char*>(&trained_on), sizeof(trained_on)) || trained_on != gallery) {
+        return false;
+    }
+
+    FeatureMatrix centroids(dim_);
+    centroids.reserve(header[3]);
+    std::vector<float> row(dim_);
+    for (uint32_t c = 0; c < header[3]; c++) {
+        if (!in.read(reinterpret_cast<char*>(row.data()), dim_ * sizeof(float))) return false;
+        centroids.append(c, row.data());
+    }
+
+    centroids_ = std::move(centroids);
+    lists_.assign(header[3], FeatureMatrix(dim_));
+    size_ = 0;
+    return true;
+}
+
+void IvfIndex::clear() {
+    for (auto& list : lists_) list.clear();
+    size_ = 0;
+}
+
+void IvfIndex::add(int64_t id, const float* feature) {
+    if (!trained()) return;
+    std::vector<int> probe;
+    nearest_lists(feature, 1, probe);
+    lists_[probe[0]].append(id, feature);
+    size_++;
+}
+
+size_t IvfIndex::remove(int64_t id) {
+    size_t removed = 0;
+    for (auto& list : lists_) removed += list.remove(id);
+    size_ -= removed;
+    return removed;
+}
+
+void IvfIndex::export_to(FeatureMatrix& out) const {
+    out.reserve(out.size() + size_);
+    for (const auto& list : lists_) {
+        for (size_t i = 0; i < list.size(); i++) out.append(list.id(i), list.row(i));
+    }
+}
+
+size_t IvfIndex::memory_bytes() const {
+    size_t bytes = centroids_.size() * centroids_.stride() * sizeof(float);
+    for (const auto& list : lists_) {
+        bytes += list.size() * (list.stride() * sizeof(float) + sizeof(int64_t));
+    }
+    return bytes;
+}
+
+void IvfIndex::nearest_lists(const float* v, int n, std::vector<int>& out) const {
+    out.clear();
+    n = std::min(n, nlist());
+    if (n <= 0) return;
+
+    std::vector<ScoredRow> best;
+    best.reserve(n + 1);
+    centroids_.scan(v, [&](size_t index, float score) {
+        if (static_cast<int>(best.size()) == n && score <= best.back().score) return;
+        ScoredRow r = {score, index};
+        best.insert(std::upper_bound(best.begin(), best.end(), r,
+                                     [](const ScoredRow& a, const ScoredRow& b) { return a.score > b.score; }),
+                    r);
+        if (static_cast<int>(best.size()) > n) best.pop_back();
+    });
+    for (const auto& r : best) out.push_back(static_cast<int>(r.index));
+}
+
+} // namespace service
@@ -0,0 +1,83 @@
+/**
+ * @file mapped_feature_file.cc
+ * @brief 内存映射的 float 特征文件实现
+ */
+
+#include "service/mapped_feature_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+
+namespace service {
+
+MappedFeatureFile::MappedFeatureFile()
+    : fd_(-1)
+    , data_(nullptr)
+    , rows_(0)
+    , capacity_(0)
+    , dim_(0)
+{
+}
+
+MappedFeatureFile::~MappedFeatureFile() {
+    close();
+}
+
+bool MappedFeatureFile::open(const std::string& path, int dim, size_t max_rows) {
+    close();
+
+    // 不截断同名文件：旧快照可能仍映射着它，unlink 后其内容保留到映射解除
+    ::unlink(path.c_str());
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd_ < 0) {
+        std::cerr << "[MappedFeatureFile] cannot open " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    path_ = path;
+    dim_ = dim;
+
+    // 稀疏文件：只有写入过的页占用磁盘
+    size_t bytes = max_rows * dim_ * sizeof(float);
+    if (ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+        std::cerr << "[MappedFeatureFile] cannot size " << path_ << ": " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        std::cerr << "[MappedFeatureFile] mmap failed: " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    // 重排只随机访问少量行，关闭预读
+    madvise(p, bytes, MADV_RANDOM);
+    data_ = static_cast<float*>(p);
+    capacity_ = max_rows;
+    return true;
+}
+
+void MappedFeatureFile::close() {
+    if (data_) {
+        munmap(data_, capacity_ * dim_ * sizeof(float));
+        data_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    rows_ = 0;
+    capacity_ = 0;
+}
+
+long MappedFeatureFile::append(const float* feature) {
+    if (!is_open() || rows_ == capacity_) return -1;
+
+    memcpy(data_ + rows_ * dim_, feature, dim_ * sizeof(float));
+    return static_cast<long>(rows_++);
+}
+
+} // namespace service
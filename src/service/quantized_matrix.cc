@@ -0,0 +1,99 @@
+/**
+ * @file quantized_matrix.cc
+ * @brief int8 量化特征库矩阵实现
+ */
+
+#include "service/quantized_matrix.h"
+#include "core/feature_kernels.h"
+#include <algorithm>
+#include <cstring>
+
+namespace service {
+
+// 每次交给 feature_dot_rows_i8 的行数 (得分缓冲放在栈上)
+static const int SCAN_BLOCK_ROWS = 64;
+
+QuantizedFeatureMatrix::QuantizedFeatureMatrix(int dim)
+    : dim_(dim)
+    , stride_((dim + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE)
+{
+}
+
+void QuantizedFeatureMatrix::clear() {
+    data_.clear();
+    scales_.clear();
+    ids_.clear();
+    float_rows_.clear();
+}
+
+void QuantizedFeatureMatrix::reserve(size_t rows) {
+    data_.reserve(rows * stride_);
+    scales_.reserve(rows);
+    ids_.reserve(rows);
+    float_rows_.reserve(rows);
+}
+
+void QuantizedFeatureMatrix::append(int64_t id, const float* feature, uint32_t float_row) {
+    size_t offset = data_.size();
+    data_.resize(offset + stride_, 0); // 行尾补齐部分保持为 0
+    scales_.push_back(feature_quantize_i8(feature, dim_, data_.data() + offset));
+    ids_.push_back(id);
+    float_rows_.push_back(float_row);
+}
+
+size_t QuantizedFeatureMatrix::remove(int64_t id) {
+    size_t kept = 0;
+    for (size_t i = 0; i < ids_.size(); i++) {
+        if (ids_[i] == id) continue;
+        if (kept != i) {
+            ids_[kept] = ids_[i];
+            scales_[kept] = scales_[i];
+            float_rows_[kept] = float_rows_[i];
+            memcpy(data_.data() + kept * stride_, data_.data() + i * stride_, stride_);
+        }
+        kept++;
+    }
+
+    size_t removed = ids_.size() - kept;
+    ids_.resize(kept);
+    scales_.resize(kept);
+    float_rows_.resize(kept);
+    data_.resize(kept * stride_);
+    return removed;
+}
+
+void QuantizedFeatureMatrix::top_candidates(const int8_t* query, float query_scale, int k,
+                                            std::vector<ScoredRow>& out, size_t begin, size_t end) const {
+    out.clear();
+    if (k <= 0) return;
+
+    // 小顶堆保存当前最好的 k 个候选，堆顶为其中最差者
+    auto worse = [](const ScoredRow& a, const ScoredRow& b) { return a.score > b.score; };
+    int32_t dots[SCAN_BLOCK_ROWS];
+
+    size_t rows = std::min(end, size());
+    for (size_t start = begin; start < rows; start += SCAN_BLOCK_ROWS) {
+        int count = static_cast<int>(std::min<size_t>(SCAN_BLOCK_ROWS, rows - start));
+        feature_dot_rows_i8(query, data_.data() + start * stride_, stride_, count, dim_, dots);
+        for (int i = 0; i < count; i++) {
+            float score = dots[i] * query_scale * scales_[start + i];
+            if (static_cast<int>(out.size()) < k) {
+                out.push_back({score, start + i});
+                std::push_heap(out.begin(), out.end(), worse);
+            } else if (score > out.front().score) {
+                std::pop_heap(out.begin(), out.end(), worse);
+                out.back() = {score, start + i};
+                std::push_heap(out.begin(), out.end(), worse);
+            }
+        }
+    }
+
+    std::sort_heap(out.begin(), out.end(), worse);
+}
+
+size_t QuantizedFeatureMatrix::memory_bytes() const {
+    return data_.capacity() + scales_.capacity() * sizeof(float) +
+           ids_.capacity() * sizeof(int64_t) + float_rows_.capacity() * sizeof(uint32_t);
+}
+
+} // namespace service
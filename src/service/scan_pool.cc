@@ -0,0 +1,115 @@
+/**
+ * @file scan_pool.cc
+ * @brief 特征库并行扫描线程池实现
+ */
+
+#include "service/scan_pool.h"
+#include "config.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace service {
+
+ScanPool& ScanPool::instance() {
+    static ScanPool instance;
+    return instance;
+}
+
+ScanPool::ScanPool()
+    : task_(nullptr)
+    , generation_(0)
+    , pending_(0)
+    , stop_(false)
+    , threads_(1)
+{
+    // CPU 数少于 SCAN_THREADS 时 (如 PC 虚拟机) 不超额分配
+    int cpus = static_cast<int>(std::thread::hardware_concurrency());
+    start(cpus > 0 ? std::min(cpus, Config::Gallery::SCAN_THREADS) : 1);
+}
+
+ScanPool::~ScanPool() {
+    stop();
+}
+
+void ScanPool::resize(int threads) {
+    std::lock_guard<std::mutex> busy(run_mutex_);
+    stop();
+    start(threads);
+}
+
+void ScanPool::start(int threads) {
+    threads_ = std::max(1, std::min(threads, Config::Gallery::SCAN_THREADS));
+    stop_ = false;
+    for (int w = 1; w < threads_; w++) {
+        workers_.emplace_back(&ScanPool::worker_loop, this, w, generation_);
+    }
+}
+
+void ScanPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& t : workers_) {
+        t.join();
+    }
+    workers_.clear();
+    threads_ = 1;
+}
+
+bool ScanPool::run(const std::function<void(int)>& task) {
+    std::unique_lock<std::mutex> busy(run_mutex_, std::try_to_lock);
+    if (!busy.owns_lock()) return false;
+
+    if (workers_.empty()) {
+        task(0);
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        pending_ = static_cast<int>(workers_.size());
+        generation_++;
+    }
+    start_cv_.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+    task_ = nullptr;
+    return true;
+}
+
+void ScanPool::worker_loop(int worker, uint64_t generation) {
+    // 绑定到大核 (SCAN_FIRST_CPU 起)；核数不足 (如 PC 上) 时不绑定
+    int cpu = Config::Gallery::SCAN_FIRST_CPU + worker;
+    if (cpu < sysconf(_SC_NPROCESSORS_CONF)) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        start_cv_.wait(lock, [this, generation] { return stop_ || generation_ != generation; });
+        if (stop_) break;
+        generation = generation_;
+
+        const std::function<void(int)>* task = task_;
+        lock.unlock();
+        (*task)(worker);
+        lock.lock();
+
+        if (--pending_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+} // namespace service
@@ -1,9 +1,17 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include "config.h"
 #include "database/database_manager.h"
 #include "database/user_dao.h"
 #include "database/attendance_dao.h"
+#include "database/face_feature_dao.h"
+#include "service/feature_library.h"
 
 void print_usage() {
     std::cout << "Usage:" << std::endl;
@@ -11,6 +19,168 @@ void print_usage() {
     std::cout << "  db_tool add_user <db_path> <name> <dept>" << std::endl;
     std::cout << "  db_tool list_users <db_path>" << std::endl;
     std::cout << "  db_tool stats <db_path>" << std::endl;
+    std::cout << "  db_tool seed_users <db_path> <count>" << std::endl;
+    std::cout << "  db_tool bench_lookup <db_path>" << std::endl;
+    std::cout << "  db_tool bench_db <db_path>" << std::endl;
+}
+
+// 生成随机归一化特征
+static Embedding random_feature(std::mt19937& rng) {
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    float f[Embedding::DIM];
+    for (auto& v : f) v = dist(rng);
+    Embedding e;
+    e.assign(f);
+    return e;
+}
+
+// 批量写入带随机特征的测试用户 (单个事务)
+static int seed_users(int count) {
+    std::mt19937 rng(42);
+    db::UserDao udao;
+    db::FaceFeatureDao fdao;
+
+    db::DatabaseManager::instance().begin_transaction();
+    for (int i = 0; i < count; ++i) {
+        db::User user;
+        user.user_name = "seed_" + std::to_string(i);
+        user.department = "bench";
+        user.status = 1;
+        int64_t uid = udao.add_user(user);
+        if (uid == -1) {
+            db::DatabaseManager::instance().rollback_transaction();
+            std::cerr << "Failed to add user " << user.user_name << std::endl;
+            return 1;
+        }
+
+        db::FaceFeature ff;
+        ff.user_id = uid;
+        ff.feature_vector = random_feature(rng);
+        ff.feature_quality = 1.0f;
+        if (fdao.add_feature(ff) == -1) {
+            db::DatabaseManager::instance().rollback_transaction();
+            std::cerr << "Failed to add feature for " << user.user_name << std::endl;
+            return 1;
+        }
+    }
+    db::DatabaseManager::instance().commit_transaction();
+    std::cout << "Seeded " << count << " users with random features." << std::endl;
+    return 0;
+}
+
+// 后处理识别阶段 (检索 + 取显示名) 每帧耗时：
+// 数据库查名 (UserDao::get_user_by_id) 与内存用户表 (FeatureLibrary::get_user) 对比
+static int bench_lookup() {
+    const int FRAMES = 300;
+    const int FACE_COUNTS[] = {1, 10};
+
+    service::FeatureLibrary& library = service::FeatureLibrary::instance();
+    library.load_from_database();
+
+    // 以库中已有特征加噪声作为查询，保证每个人脸都能识别成功
+    db::FaceFeatureDao fdao;
+    auto stored = fdao.get_all_features();
+    if (stored.empty()) {
+        std::cerr << "No face features in database, run seed_users first." << std::endl;
+        return 1;
+    }
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+
+    for (int faces : FACE_COUNTS) {
+        std::vector<Embedding> queries;
+        for (int i = 0; i < faces; ++i) {
+            std::vector<float> q = stored[i % stored.size()].feature_vector.to_vector();
+            for (auto& v : q) v += noise(rng);
+            queries.emplace_back(q);
+        }
+
+        for (int mode = 0; mode < 2; ++mode) {
+            int recognized = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < FRAMES; ++frame) {
+                for (const auto& q : queries) {
+                    float similarity = 0.0f;
+                    int64_t uid = library.search(q, Config::Default::RECOGNITION_THRESHOLD, similarity);
+                    if (uid == -1) continue;
+                    if (mode == 0) {
+                        db::UserDao udao;
+                        if (udao.get_user_by_id(uid)) recognized++;
+                    } else {
+                        service::UserInfo info;
+                        if (library.get_user(uid, info)) recognized++;
+                    }
+                }
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            double us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / (double)FRAMES;
+            std::cout << (mode == 0 ? "sqlite lookup  " : "memory lookup  ")
+                      << "faces=" << faces
+                      << "\tus/frame=" << us
+                      << "\trecognized=" << recognized / FRAMES << std::endl;
+        }
+    }
+    return 0;
+}
+
+// DAO 单次操作耗时：每次调用都编译语句 (关闭语句缓存，即原实现) 与从缓存借出语句对比
+static int bench_db() {
+    db::DatabaseManager& manager = db::DatabaseManager::instance();
+    db::UserDao udao;
+    db::AttendanceDao adao;
+    db::FaceFeatureDao fdao;
+
+    auto users = udao.get_all_active_users();
+    if (users.empty()) {
+        std::cerr << "No users in database, run seed_users first." << std::endl;
+        return 1;
+    }
+    auto pick = [&](int i) -> const db::User& { return users[i % users.size()]; };
+
+    db::AttendanceRecord record;
+    record.check_type = 0;
+    record.status = 0;
+    record.similarity = 0.8f;
+
+    struct Op {
+        const char* name;
+        int iterations;
+        std::function<void(int)> run;
+    };
+    const std::vector<Op> ops = {
+        {"UserDao::get_user_by_id", 5000, [&](int i) { udao.get_user_by_id(pick(i).user_id); }},
+        {"UserDao::get_user_by_name", 5000, [&](int i) { udao.get_user_by_name(pick(i).user_name); }},
+        {"FaceFeatureDao::get_revision", 5000, [&](int) { db::FeatureRevision r; fdao.get_revision(r); }},
+        {"FaceFeatureDao::get_features_by_user_id", 5000, [&](int i) { fdao.get_features_by_user_id(pick(i).user_id); }},
+        {"AttendanceDao::get_last_record", 5000, [&](int i) { adao.get_last_record(pick(i).user_id); }},
+        {"AttendanceDao::add_record", 5000, [&](int i) {
+            record.user_id = pick(i).user_id;
+            record.check_time = 1700000000 + i;
+            adao.add_record(record);
+        }},
+        {"FaceFeatureDao::get_all_features", 20, [&](int) { fdao.get_all_features(); }},
+    };
+
+    // 写操作在事务内执行并最终回滚：不改变数据库内容，也排除每次提交的 fsync
+    manager.begin_transaction();
+    std::cout << "users=" << users.size() << std::endl;
+    std::cout << std::left << std::setw(42) << "operation" << "prepare/call(us)\tcached(us)\tspeedup" << std::endl;
+    for (const auto& op : ops) {
+        double us[2];
+        for (int cached = 0; cached < 2; ++cached) {
+            manager.set_statement_cache(cached == 1);
+            op.run(0); // 预热 (缓存模式下首次编译语句)
+            auto t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < op.iterations; ++i) op.run(i);
+            auto t1 = std::chrono::steady_clock::now();
+            us[cached] = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count() / 1000.0 / op.iterations;
+        }
+        std::cout << std::left << std::setw(42) << op.name << std::fixed << std::setprecision(2)
+                  << us[0] << "\t\t" << us[1] << "\t\t" << us[0] / us[1] << "x" << std::endl;
+    }
+    manager.rollback_transaction();
+    manager.set_statement_cache(true);
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
@@ -64,6 +234,19 @@ int main(int argc, char* argv[]) {
         auto users = udao.get_all_active_users();
         std::cout << "Total Active Users: " << users.size() << std::endl;
     }
+    else if (command == "seed_users") {
+        if (argc < 4) {
+            std::cout << "Usage: db_tool seed_users <db_path> <count>" << std::endl;
+            return 1;
+        }
+        return seed_users(std::stoi(argv[3]));
+    }
+    else if (command == "bench_lookup") {
+        return bench_lookup();
+    }
+    else if (command == "bench_db") {
+        return bench_db();
+    }
     else {
         print_usage();
         return 1;
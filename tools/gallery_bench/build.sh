@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# 颜色定义
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+YELLOW='\033[1;33m'
+NC='\033[0m'
+
+echo -e "${YELLOW}>>> 正在编译 gallery_bench (本机编译)...${NC}"
+
+# 创建并进入构建目录
+mkdir -p build
+cd build
+
+# 执行 CMake (使用本机编译器，无需交叉编译与 librknnrt)
+cmake .. -DCMAKE_BUILD_TYPE=Release
+
+# 编译并运行测试
+if [ $? -eq 0 ]; then
+    make -j$(nproc) && ctest --output-on-failure
+    if [ $? -eq 0 ]; then
+        echo -e "${GREEN}=======================================${NC}"
+        echo -e "${GREEN}  gallery_bench 编译并测试通过!${NC}"
+        echo -e "${GREEN}  运行基准: ./build/gallery_bench bench${NC}"
+        echo -e "${GREEN}  负载测试: ./build/gallery_loadgen --identities 30000${NC}"
+        echo -e "${GREEN}=======================================${NC}"
+    else
+        echo -e "${RED}[错误] 编译或测试失败!${NC}"
+        exit 1
+    fi
+else
+    echo -e "${RED}[错误] CMake 配置失败!${NC}"
+    exit 1
+fi
@@ -0,0 +1,1627 @@
+/**
+ * @file gallery_bench.cc
+ * @brief 特征库检索核的正确性测试与基准
+ * @details 用随机归一化特征构造 1k / 10k / 100k 模板的特征库，对比原逐 std::vector
+ *          标量扫描、FeatureMatrix + SIMD 多行点积核，以及 FeatureLibrary 的 float / fp16 / int8
+ *          三种存储、IVF 近似索引的检索耗时、内存与相对精确扫描的召回率，以及增量更新期间的检索延迟。
+ *          在 PC (x86, AVX2) 或板端 (aarch64, NEON) 上运行，不需要 NPU；模板只加入内存，不写数据库。
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/feature_kernels.h"
+#include "core/embedding.h"
+#include "service/feature_matrix.h"
+#include "service/quantized_matrix.h"
+#include "service/feature_library.h"
+#include "service/gallery_file.h"
+#include "service/scan_pool.h"
+#include "service/hot_gallery.h"
+#include "database/database_manager.h"
+#include "database/user_dao.h"
+#include "database/face_feature_dao.h"
+#include "config.h"
+
+using service::FeatureMatrix;
+using service::QuantizedFeatureMatrix;
+using service::FeatureLibrary;
+
+static const int DIM = Config::Model::FEATURE_DIM;
+static const size_t DEFAULT_SIZES[] = {1000, 10000, 100000};
+
+void print_usage() {
+    printf("Usage:\n");
+    printf("  gallery_bench test                 校验 SIMD 核与 FeatureMatrix 的数值正确性\n");
+    printf("  gallery_bench bench [N ...]        检索基准 (默认 N = 1000 10000 100000)\n");
+}
+
+static void random_unit(std::mt19937& rng, float* v, int dim) {
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    for (int i = 0; i < dim; ++i) v[i] = dist(rng);
+    float norm = 0.0f;
+    for (int i = 0; i < dim; ++i) norm += v[i] * v[i];
+    norm = sqrtf(norm);
+    for (int i = 0; i < dim; ++i) v[i] /= norm;
+}
+
+static float scalar_dot(const float* a, const float* b, int dim) {
+    double sum = 0.0;
+    for (int i = 0; i < dim; ++i) sum += (double)a[i] * b[i];
+    return (float)sum;
+}
+
+// ============================================
+// test
+// ============================================
+
+static bool check_dot_rows() {
+    std::mt19937 rng(7);
+    // 覆盖向量化主体、尾部维度与不足 4 行的剩余行
+    const int dims[] = {512, 128, 37, 3};
+    const int counts[] = {1, 3, 4, 13, 64};
+    for (int dim : dims) {
+        for (int count : counts) {
+            size_t stride = dim + 5;
+            std::vector<float> rows(stride * count), query(dim), out(count);
+            for (int r = 0; r < count; ++r) random_unit(rng, rows.data() + r * stride, dim);
+            random_unit(rng, query.data(), dim);
+
+            feature_dot_rows(query.data(), rows.data(), stride, count, dim, out.data());
+            for (int r = 0; r < count; ++r) {
+                float ref = scalar_dot(query.data(), rows.data() + r * stride, dim);
+                if (fabsf(out[r] - ref) > 1e-5f ||
+                    fabsf(feature_dot(query.data(), rows.data() + r * stride, dim) - ref) > 1e-5f) {
+                    printf("[FAIL] feature_dot_rows(dim=%d, count=%d): row %d = %f, want %f\n",
+                           dim, count, r, out[r], ref);
+                    return false;
+                }
+            }
+        }
+    }
+
+    // 多查询核：奇数查询数覆盖单查询剩余路径
+    for (int dim : dims) {
+        const int nq = 5, count = 11;
+        size_t stride = dim + 5, q_stride = dim + 2;
+        std::vector<float> rows(stride * count), queries(q_stride * nq), out(nq * count);
+        for (int r = 0; r < count; ++r) random_unit(rng, rows.data() + r * stride, dim);
+        for (int q = 0; q < nq; ++q) random_unit(rng, queries.data() + q * q_stride, dim);
+
+        feature_dot_rows_multi(queries.data(), q_stride, nq, rows.data(), stride, count, dim, out.data());
+        for (int q = 0; q < nq; ++q) {
+            for (int r = 0; r < count; ++r) {
+                float ref = scalar_dot(queries.data() + q * q_stride, rows.data() + r * stride, dim);
+                if (fabsf(out[q * count + r] - ref) > 1e-5f) {
+                    printf("[FAIL] feature_dot_rows_multi(dim=%d): query %d row %d = %f, want %f\n",
+                           dim, q, r, out[q * count + r], ref);
+                    return false;
+                }
+            }
+        }
+    }
+
+    std::vector<float> v(DIM);
+    for (int i = 0; i < DIM; ++i) v[i] = (float)(i % 7) - 3.0f;
+    feature_normalize(v.data(), DIM);
+    if (fabsf(scalar_dot(v.data(), v.data(), DIM) - 1.0f) > 1e-5f) {
+        printf("[FAIL] feature_normalize: norm != 1\n");
+        return false;
+    }
+
+    printf("[ OK ] feature kernels (%s)\n", feature_kernel_isa());
+    return true;
+}
+
+static bool check_matrix() {
+    std::mt19937 rng(11);
+    FeatureMatrix matrix(DIM);
+    std::vector<float> f(DIM);
+    std::vector<std::vector<float>> kept;
+
+    for (int i = 0; i < 200; ++i) {
+        random_unit(rng, f.data(), DIM);
+        matrix.append(i % 50, f.data());
+        if (i % 50 != 7) kept.push_back(f);
+    }
+    if (matrix.size() != 200 || reinterpret_cast<uintptr_t>(matrix.row(1)) % CACHE_LINE_SIZE != 0) {
+        printf("[FAIL] FeatureMatrix: bad size or row alignment\n");
+        return false;
+    }
+    if (matrix.remove(7) != 4 || matrix.size() != 196) {
+        printf("[FAIL] FeatureMatrix: remove\n");
+        return false;
+    }
+
+    // 每个保留的模板都应检索到自身
+    for (size_t i = 0; i < kept.size(); ++i) {
+        float score = 0.0f;
+        long best = matrix.best_match(kept[i].data(), score);
+        if (best != (long)i || fabsf(score - 1.0f) > 1e-4f) {
+            printf("[FAIL] FeatureMatrix: template %zu matched row %ld (score %f)\n", i, best, score);
+            return false;
+        }
+    }
+
+    float score = 0.0f;
+    if (FeatureMatrix(DIM).best_match(f.data(), score) != -1) {
+        printf("[FAIL] FeatureMatrix: empty matrix returned a match\n");
+        return false;
+    }
+
+    printf("[ OK ] FeatureMatrix\n");
+    return true;
+}
+
+static bool check_int8() {
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<int> dist(-127, 127);
+    const int dims[] = {512, 100, 7};
+    const int counts[] = {1, 4, 9};
+    for (int dim : dims) {
+        for (int count : counts) {
+            size_t stride = dim + 3;
+            std::vector<int8_t> rows(stride * count), query(dim);
+            std::vector<int32_t> out(count);
+            for (auto& v : rows) v = (int8_t)dist(rng);
+            for (auto& v : query) v = (int8_t)dist(rng);
+
+            feature_dot_rows_i8(query.data(), rows.data(), stride, count, dim, out.data());
+            for (int r = 0; r < count; ++r) {
+                int32_t ref = 0;
+                for (int i = 0; i < dim; ++i) ref += (int32_t)query[i] * rows[r * stride + i];
+                if (out[r] != ref || feature_dot_i8(query.data(), rows.data() + r * stride, dim) != ref) {
+                    printf("[FAIL] feature_dot_rows_i8(dim=%d, count=%d): row %d = %d, want %d\n",
+                           dim, count, r, out[r], ref);
+                    return false;
+                }
+            }
+        }
+    }
+
+    // 量化误差不超过半个量化步长
+    std::vector<float> v(DIM);
+    std::vector<int8_t> q(DIM);
+    random_unit(rng, v.data(), DIM);
+    float scale = feature_quantize_i8(v.data(), DIM, q.data());
+    for (int i = 0; i < DIM; ++i) {
+        if (fabsf(q[i] * scale - v[i]) > scale * 0.5f + 1e-6f) {
+            printf("[FAIL] feature_quantize_i8: element %d = %f, want %f\n", i, q[i] * scale, v[i]);
+            return false;
+        }
+    }
+
+    // 每个模板都应出现在自身查询的候选首位
+    QuantizedFeatureMatrix matrix(DIM);
+    std::vector<std::vector<float>> templates(100, std::vector<float>(DIM));
+    for (size_t i = 0; i < templates.size(); ++i) {
+        random_unit(rng, templates[i].data(), DIM);
+        matrix.append((int64_t)i, templates[i].data(), (uint32_t)i);
+    }
+    std::vector<service::ScoredRow> candidates;
+    for (size_t i = 0; i < templates.size(); ++i) {
+        float qs = feature_quantize_i8(templates[i].data(), DIM, q.data());
+        matrix.top_candidates(q.data(), qs, 5, candidates);
+        if (candidates.size() != 5 || candidates[0].index != i || fabsf(candidates[0].score - 1.0f) > 0.02f ||
+            candidates[1].score > candidates[0].score) {
+            printf("[FAIL] QuantizedFeatureMatrix: template %zu not ranked first\n", i);
+            return false;
+        }
+    }
+
+    printf("[ OK ] int8 kernels / QuantizedFeatureMatrix\n");
+    return true;
+}
+
+// 测试数据按 float 向量生成，交给特征库前转换为 Embedding (转换时归一化)
+static Embedding embed(const std::vector<float>& v) {
+    return Embedding(v);
+}
+
+static std::vector<Embedding> embed_all(const std::vector<std::vector<float>>& vs) {
+    return std::vector<Embedding>(vs.begin(), vs.end());
+}
+
+static bool check_embedding() {
+    std::mt19937 rng(43);
+    std::vector<float> raw(DIM);
+    for (int i = 0; i < DIM; ++i) raw[i] = (float)(i % 5) - 1.5f;
+
+    // 构造时归一化一次；维度不符、全零向量为空
+    Embedding e(raw);
+    if (e.empty() || fabsf(e.dot(e) - 1.0f) > 1e-5f ||
+        fabsf(e.data()[3] * sqrtf(scalar_dot(raw.data(), raw.data(), DIM)) - raw[3]) > 1e-4f) {
+        printf("[FAIL] Embedding: not normalized on assign\n");
+        return false;
+    }
+    if (!Embedding(std::vector<float>(DIM - 1, 1.0f)).empty() || !Embedding(std::vector<float>(DIM, 0.0f)).empty() ||
+        !Embedding().empty()) {
+        printf("[FAIL] Embedding: invalid input not empty\n");
+        return false;
+    }
+
+    // vector 中相邻特征按 EMBEDDING_STRIDE 排列且起始地址对齐缓存行 (多查询扫描直接使用)
+    std::vector<std::vector<float>> rows(5, std::vector<float>(DIM));
+    for (auto& r : rows) random_unit(rng, r.data(), DIM);
+    std::vector<Embedding> batch = embed_all(rows);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (reinterpret_cast<uintptr_t>(batch[i].data()) % CACHE_LINE_SIZE != 0 ||
+            batch[i].data() != batch[0].data() + i * EMBEDDING_STRIDE ||
+            fabsf(batch[i].dot(batch[i]) - 1.0f) > 1e-5f) {
+            printf("[FAIL] Embedding: bad layout in std::vector\n");
+            return false;
+        }
+    }
+
+    printf("[ OK ] Embedding\n");
+    return true;
+}
+
+// 清空特征库 (未打开数据库时 load_from_database 只清空内存)
+static void reset_library() {
+    FeatureLibrary::instance().load_from_database();
+}
+
+static db::User make_user(int64_t user_id) {
+    db::User user;
+    user.user_id = user_id;
+    user.user_name = "user_" + std::to_string(user_id);
+    return user;
+}
+
+static void add_template(int64_t user_id, const std::vector<float>& feature) {
+    FeatureLibrary::instance().add_user(make_user(user_id), embed(feature));
+}
+
+// 每个模板一个用户，一次发布
+static void add_templates(const std::vector<std::vector<float>>& templates) {
+    std::vector<service::UserTemplates> entries(templates.size());
+    for (size_t i = 0; i < templates.size(); ++i) {
+        entries[i].user = make_user((int64_t)i);
+        entries[i].features.emplace_back(templates[i]);
+    }
+    FeatureLibrary::instance().add_users(entries);
+}
+
+static bool check_topk() {
+    std::mt19937 rng(17);
+    const int USERS = 40, TEMPLATES = 3, K = 5;
+    FeatureLibrary& library = FeatureLibrary::instance();
+    reset_library();
+
+    std::vector<std::vector<float>> templates;
+    std::vector<int64_t> owners;
+    std::vector<float> f(DIM);
+    for (int u = 0; u < USERS; ++u) {
+        for (int t = 0; t < TEMPLATES; ++t) {
+            random_unit(rng, f.data(), DIM);
+            add_template(u, f);
+            templates.push_back(f);
+            owners.push_back(u);
+        }
+    }
+
+    for (int q = 0; q < 20; ++q) {
+        // 查询靠近某个模板，使前几名拉开差距
+        std::vector<float> query(DIM);
+        random_unit(rng, query.data(), DIM);
+        const std::vector<float>& near = templates[q * 5 % templates.size()];
+        for (int i = 0; i < DIM; ++i) query[i] += near[i];
+        feature_normalize(query.data(), DIM);
+
+        // 暴力参考：每个用户取最高分后排序
+        std::vector<float> best(USERS, -2.0f);
+        for (size_t i = 0; i < templates.size(); ++i) {
+            best[owners[i]] = std::max(best[owners[i]], scalar_dot(query.data(), templates[i].data(), DIM));
+        }
+        std::vector<int> order(USERS);
+        for (int u = 0; u < USERS; ++u) order[u] = u;
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return best[a] > best[b]; });
+
+        float margin = 0.0f;
+        std::vector<service::SearchMatch> got = library.search_topk(embed(query), K, &margin);
+        if ((int)got.size() != K) {
+            printf("[FAIL] search_topk: got %zu results, want %d\n", got.size(), K);
+            return false;
+        }
+        for (int r = 0; r < K; ++r) {
+            if (got[r].user_id != order[r] || fabsf(got[r].similarity - best[order[r]]) > 1e-4f) {
+                printf("[FAIL] search_topk: rank %d = user %ld (%f), want user %d (%f)\n", r,
+                       (long)got[r].user_id, got[r].similarity, order[r], best[order[r]]);
+                return false;
+            }
+        }
+        if (fabsf(margin - (best[order[0]] - best[order[1]])) > 1e-4f) {
+            printf("[FAIL] search_topk: margin %f, want %f\n", margin, best[order[0]] - best[order[1]]);
+            return false;
+        }
+
+        float sim = 0.0f;
+        if (library.search(embed(query), -1.0f, sim) != order[0]) {
+            printf("[FAIL] search: disagrees with search_topk\n");
+            return false;
+        }
+    }
+
+    // 批量检索与逐个检索结果一致 (含一个维度不符而为空的查询)
+    std::vector<std::vector<float>> raw_batch(7, std::vector<float>(DIM));
+    for (auto& q : raw_batch) random_unit(rng, q.data(), DIM);
+    raw_batch[3].resize(DIM - 1);
+    std::vector<Embedding> batch = embed_all(raw_batch);
+    std::vector<float> margins;
+    auto batch_results = library.search_batch(batch, K, &margins);
+    for (size_t q = 0; q < batch.size(); ++q) {
+        float margin = 0.0f;
+        auto single = library.search_topk(batch[q], K, &margin);
+        bool same = single.size() == batch_results[q].size() && fabsf(margin - margins[q]) < 1e-5f;
+        for (size_t r = 0; same && r < single.size(); ++r) {
+            same = single[r].user_id == batch_results[q][r].user_id &&
+                   fabsf(single[r].similarity - batch_results[q][r].similarity) < 1e-5f;
+        }
+        if (!same) {
+            printf("[FAIL] search_batch: query %zu differs from search_topk\n", q);
+            return false;
+        }
+    }
+
+    reset_library();
+    printf("[ OK ] FeatureLibrary::search_topk / search_batch\n");
+    return true;
+}
+
+static bool check_fp16() {
+    std::mt19937 rng(47);
+
+    // 全部有限半精度值经 float 往返不变；典型值的位模式与舍入
+    std::vector<uint16_t> halves, back(65536);
+    for (uint32_t h = 0; h < 65536; ++h) {
+        if ((h & 0x7c00u) != 0x7c00u) halves.push_back((uint16_t)h);
+    }
+    std::vector<float> wide(halves.size());
+    feature_f16_to_f32(halves.data(), (int)halves.size(), wide.data());
+    feature_f32_to_f16(wide.data(), (int)wide.size(), back.data());
+    for (size_t i = 0; i < halves.size(); ++i) {
+        if (back[i] != halves[i]) {
+            printf("[FAIL] fp16 round trip: 0x%04x -> %g -> 0x%04x\n", halves[i], wide[i], back[i]);
+            return false;
+        }
+    }
+    const float values[] = {1.0f, -2.0f, 65504.0f, 1e6f, 0.1f, 5.96e-8f, 1.0f + 1.0f / 2048, 0.0f, -0.5f};
+    const uint16_t want[] = {0x3c00, 0xc000, 0x7bff, 0x7c00, 0x2e66, 0x0001, 0x3c00, 0x0000, 0xb800};
+    const int n = sizeof(values) / sizeof(values[0]);
+    uint16_t got[n];
+    feature_f32_to_f16(values, n, got);
+    for (int i = 0; i < n; ++i) {
+        if (got[i] != want[i]) {
+            printf("[FAIL] feature_f32_to_f16(%g) = 0x%04x, want 0x%04x\n", values[i], got[i], want[i]);
+            return false;
+        }
+    }
+
+    // 融合的转换 + 归一化与先转换再归一化一致；int8 原始输出按零点反量化
+    const int dims[] = {512, 100, 7};
+    const int counts[] = {1, 4, 9};
+    for (int dim : dims) {
+        std::vector<float> v(dim), ref(dim), out(dim);
+        std::vector<uint16_t> h(dim);
+        random_unit(rng, v.data(), dim);
+        for (auto& x : v) x *= 7.0f;
+        feature_f32_to_f16(v.data(), dim, h.data());
+        feature_f16_to_f32(h.data(), dim, ref.data());
+        float ref_norm = feature_normalize(ref.data(), dim);
+        float norm = feature_normalize_f16(h.data(), dim, out.data());
+        bool ok = fabsf(norm - ref_norm) < 1e-4f * ref_norm;
+        for (int i = 0; ok && i < dim; ++i) ok = fabsf(out[i] - ref[i]) < 1e-6f;
+
+        std::uniform_int_distribution<int> dist(-128, 127);
+        std::vector<int8_t> q(dim);
+        for (auto& x : q) x = (int8_t)dist(rng);
+        const int32_t zp = -5;
+        for (int i = 0; i < dim; ++i) ref[i] = (float)(q[i] - zp);
+        feature_normalize(ref.data(), dim);
+        feature_normalize_i8(q.data(), zp, dim, out.data());
+        for (int i = 0; ok && i < dim; ++i) ok = fabsf(out[i] - ref[i]) < 1e-6f;
+        if (!ok) {
+            printf("[FAIL] feature_normalize_f16 / feature_normalize_i8 (dim=%d)\n", dim);
+            return false;
+        }
+
+        for (int count : counts) {
+            size_t stride = dim + 5;
+            std::vector<uint16_t> rows(stride * count);
+            std::vector<float> row(dim), query(dim), dots(count);
+            random_unit(rng, query.data(), dim);
+            for (int r = 0; r < count; ++r) {
+                random_unit(rng, row.data(), dim);
+                feature_f32_to_f16(row.data(), dim, rows.data() + r * stride);
+            }
+            feature_dot_rows_f16(query.data(), rows.data(), stride, count, dim, dots.data());
+            for (int r = 0; r < count; ++r) {
+                feature_f16_to_f32(rows.data() + r * stride, dim, row.data());
+                float expect = scalar_dot(query.data(), row.data(), dim);
+                if (fabsf(dots[r] - expect) > 1e-5f) {
+                    printf("[FAIL] feature_dot_rows_f16(dim=%d, count=%d): row %d = %f, want %f\n",
+                           dim, count, r, dots[r], expect);
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Embedding 直接从半精度输出赋值
+    std::vector<float> raw(DIM);
+    std::vector<uint16_t> raw_h(DIM);
+    random_unit(rng, raw.data(), DIM);
+    feature_f32_to_f16(raw.data(), DIM, raw_h.data());
+    Embedding e;
+    if (!e.assign_f16(raw_h.data()) || fabsf(e.dot(e) - 1.0f) > 1e-5f || e.dot(embed(raw)) < 0.9999f) {
+        printf("[FAIL] Embedding::assign_f16\n");
+        return false;
+    }
+
+    // 半精度存储的检索结果与 float 存储一致 (得分误差在半精度舍入内)，含增量区与删除
+    FeatureLibrary& library = FeatureLibrary::instance();
+    reset_library();
+    std::vector<std::vector<float>> templates(300, std::vector<float>(DIM));
+    for (auto& t : templates) random_unit(rng, t.data(), DIM);
+    add_templates(templates);
+    std::vector<std::vector<float>> raw_queries(10, std::vector<float>(DIM));
+    for (size_t q = 0; q < raw_queries.size(); ++q) {
+        random_unit(rng, raw_queries[q].data(), DIM);
+        for (int i = 0; i < DIM; ++i) raw_queries[q][i] += templates[q * 29][i];
+    }
+    std::vector<Embedding> queries = embed_all(raw_queries);
+    size_t float_bytes = library.memory_bytes();
+    auto expected = library.search_batch(queries, 3);
+
+    bool ok = library.set_storage(FeatureLibrary::Storage::FLOAT16) &&
+              library.storage() == FeatureLibrary::Storage::FLOAT16 &&
+              library.template_count() == templates.size() && library.memory_bytes() < float_bytes * 3 / 4;
+    auto got_batch = library.search_batch(queries, 3);
+    for (size_t q = 0; ok && q < queries.size(); ++q) {
+        auto single = library.search_topk(queries[q], 3);
+        for (const auto* got : {&single, &got_batch[q]}) {
+            ok = ok && got->size() == expected[q].size();
+            for (size_t r = 0; ok && r < got->size(); ++r) {
+                ok = (*got)[r].user_id == expected[q][r].user_id &&
+                     fabsf((*got)[r].similarity - expected[q][r].similarity) < 2e-3f;
+            }
+        }
+    }
+    library.remove_user(0);
+    add_template(1000, templates[0]);
+    float sim = 0.0f;
+    ok = ok && library.search(embed(templates[0]), 0.9f, sim) == 1000;
+    library.set_storage(FeatureLibrary::Storage::FLOAT32);
+    ok = ok && library.search(embed(templates[29]), 0.9f, sim) == 29 && sim > 0.999f;
+    reset_library();
+    if (!ok) {
+        printf("[FAIL] FeatureLibrary fp16 storage: results differ from float storage\n");
+        return false;
+    }
+
+    printf("[ OK ] fp16 kernels / fp16 storage\n");
+    return true;
+}
+
+static bool check_ivf() {
+    std::mt19937 rng(19);
+    FeatureLibrary& library = FeatureLibrary::instance();
+    library.set_ann(false);
+    reset_library();
+
+    std::vector<std::vector<float>> templates(400, std::vector<float>(DIM));
+    for (size_t i = 0; i < templates.size(); ++i) {
+        random_unit(rng, templates[i].data(), DIM);
+        add_template((int64_t)i, templates[i]);
+    }
+    library.set_ann(true, 0);   // 400 个模板 → 20 个倒排表
+    if (!library.ann_active() || library.template_count() != templates.size()) {
+        printf("[FAIL] IVF: index not built\n");
+        return false;
+    }
+
+    // 模板自身总在其所属倒排表中，必须检索到自身
+    for (size_t i = 0; i < templates.size(); ++i) {
+        float sim = 0.0f;
+        if (library.search(embed(templates[i]), 0.99f, sim) != (int64_t)i) {
+            printf("[FAIL] IVF: template %zu not found (sim %f)\n", i, sim);
+            return false;
+        }
+    }
+
+    // 增量删除/插入
+    library.remove_user(5);
+    float sim = 0.0f;
+    if (library.search(embed(templates[5]), 0.99f, sim) != -1) {
+        printf("[FAIL] IVF: removed template still found\n");
+        return false;
+    }
+    add_template(1000, templates[5]);
+    if (library.search(embed(templates[5]), 0.99f, sim) != 1000) {
+        printf("[FAIL] IVF: inserted template not found\n");
+        return false;
+    }
+
+    library.set_ann(false);
+    if (library.ann_active() || library.template_count() != templates.size()) {
+        printf("[FAIL] IVF: templates lost when switching back to exact scan\n");
+        return false;
+    }
+
+    library.set_ann(Config::Gallery::ANN_ENABLED);
+    reset_library();
+    printf("[ OK ] IvfIndex\n");
+    return true;
+}
+
+// 分片并行扫描与串行扫描结果一致 (float / int8 / 批量，含待合并删除的用户)
+static bool check_parallel_scan() {
+    std::mt19937 rng(31);
+    FeatureLibrary& library = FeatureLibrary::instance();
+    service::ScanPool& pool = service::ScanPool::instance();
+    int default_threads = pool.threads();
+    library.set_ann(false);
+    reset_library();
+
+    std::vector<std::vector<float>> templates(Config::Gallery::PARALLEL_SCAN_MIN_TEMPLATES + 1000, std::vector<float>(DIM));
+    for (auto& t : templates) random_unit(rng, t.data(), DIM);
+    add_templates(templates);
+    library.remove_user(7);
+    library.remove_user(4000);
+
+    std::vector<std::vector<float>> raw_queries(16, std::vector<float>(DIM));
+    for (size_t q = 0; q < raw_queries.size(); ++q) {
+        random_unit(rng, raw_queries[q].data(), DIM);
+        const std::vector<float>& near = templates[q * 611 % templates.size()];
+        for (int i = 0; i < DIM; ++i) raw_queries[q][i] += near[i];
+    }
+    raw_queries[0] = templates[7];  // 已删除用户的模板不能出现在结果中
+    std::vector<Embedding> queries = embed_all(raw_queries);
+
+    const FeatureLibrary::Storage storages[] = {FeatureLibrary::Storage::FLOAT32, FeatureLibrary::Storage::INT8,
+                                                FeatureLibrary::Storage::FLOAT16};
+    const char* storage_names[] = {"float", "int8", "fp16"};
+    bool ok = true;
+    for (int s = 0; s < 3 && ok; ++s) {
+        if (!library.set_storage(storages[s])) continue;
+        pool.resize(1);
+        std::vector<std::vector<service::SearchMatch>> serial;
+        for (const auto& q : queries) serial.push_back(library.search_topk(q, 5));
+        auto serial_batch = library.search_batch(queries, 5);
+
+        pool.resize(Config::Gallery::SCAN_THREADS);
+        auto parallel_batch = library.search_batch(queries, 5);
+        for (size_t q = 0; q < queries.size() && ok; ++q) {
+            auto parallel = library.search_topk(queries[q], 5);
+            for (const auto* got : {&parallel, &parallel_batch[q]}) {
+                const auto& want = (got == &parallel) ? serial[q] : serial_batch[q];
+                ok = ok && got->size() == want.size();
+                for (size_t r = 0; ok && r < want.size(); ++r) {
+                    ok = (*got)[r].user_id == want[r].user_id && (*got)[r].user_id != 7 &&
+                         fabsf((*got)[r].similarity - want[r].similarity) < 1e-5f;
+                }
+            }
+            if (!ok) printf("[FAIL] parallel scan (%s): query %zu differs from serial scan\n", storage_names[s], q);
+        }
+    }
+
+    library.set_quantized(false);
+    pool.resize(default_threads);
+    library.set_ann(Config::Gallery::ANN_ENABLED);
+    reset_library();
+    if (ok) printf("[ OK ] parallel sharded scan (%d threads)\n", Config::Gallery::SCAN_THREADS);
+    return ok;
+}
+
+static bool check_hot_tier() {
+    std::mt19937 rng(37);
+    const int USERS = 500, TEMPLATES = 3;
+    FeatureLibrary& library = FeatureLibrary::instance();
+    reset_library();
+
+    std::vector<service::UserTemplates> entries(USERS);
+    for (int u = 0; u < USERS; ++u) {
+        entries[u].user = make_user(u);
+        std::vector<float> t(DIM);
+        for (int i = 0; i < TEMPLATES; ++i) {
+            random_unit(rng, t.data(), DIM);
+            entries[u].features.emplace_back(t);
+        }
+    }
+    library.add_users(entries);
+
+    // 查询 = 用户第一个模板 + 噪声 (余弦约 0.96)
+    auto probe = [&](int u) {
+        std::vector<float> q(DIM), noise(DIM);
+        random_unit(rng, noise.data(), DIM);
+        for (int i = 0; i < DIM; ++i) q[i] = entries[u].features[0].data()[i] + 0.3f * noise[i];
+        return embed(q);
+    };
+    std::vector<Embedding> queries;
+    for (int u = 0; u < 10; ++u) queries.push_back(probe(u));
+    std::vector<float> stranger(DIM);
+    random_unit(rng, stranger.data(), DIM);         // 未注册的人
+    queries.push_back(embed(stranger));
+
+    service::HotGallery hot(Config::Gallery::HOT_MAX_TEMPLATES);
+    const float threshold = Config::Default::RECOGNITION_THRESHOLD;
+    bool ok = true;
+    for (int pass = 0; pass < 2 && ok; ++pass) {
+        std::vector<float> margins, want_margins;
+        std::vector<bool> from_hot;
+        auto got = hot.search_batch(queries, 2, threshold, &margins, &from_hot);
+        auto want = library.search_batch(queries, 2, &want_margins);
+        for (size_t q = 0; q < queries.size() && ok; ++q) {
+            // 第一轮热层为空；第二轮已匹配的用户全部由热层返回，未注册的人仍检索全库
+            bool expect_hot = pass == 1 && q < 10;
+            ok = from_hot[q] == expect_hot && !got[q].empty() && got[q][0].user_id == want[q][0].user_id &&
+                 fabsf(got[q][0].similarity - want[q][0].similarity) < 1e-5f;
+            if (!expect_hot) ok = ok && fabsf(margins[q] - want_margins[q]) < 1e-5f;
+            if (!ok) printf("[FAIL] hot tier: pass %d query %zu\n", pass, q);
+            if (pass == 0 && q < 10) hot.touch(got[q][0].user_id);
+        }
+    }
+
+    // 删除的用户在特征库版本变化后移出热层
+    library.remove_user(0);
+    auto after_remove = hot.search_batch({queries[0]}, 2, threshold);
+    if (ok && (hot.user_count() != 9 || after_remove[0].empty() || after_remove[0][0].user_id == 0)) {
+        printf("[FAIL] hot tier: removed user still matched\n");
+        ok = false;
+    }
+
+    // 超出模板上限时保留最近匹配的用户
+    for (int u = 100; u < 200; ++u) hot.touch(u);
+    std::vector<bool> from_hot;
+    hot.search_batch({probe(199), probe(100)}, 2, threshold, nullptr, &from_hot);
+    size_t max_users = Config::Gallery::HOT_MAX_TEMPLATES / TEMPLATES;
+    if (ok && (hot.template_count() > Config::Gallery::HOT_MAX_TEMPLATES || hot.user_count() != max_users ||
+               !from_hot[0] || from_hot[1])) {
+        printf("[FAIL] hot tier: LRU eviction (%zu users, %zu templates)\n", hot.user_count(), hot.template_count());
+        ok = false;
+    }
+
+    service::HotGallery::Stats stats = hot.take_stats();
+    reset_library();
+    if (ok) printf("[ OK ] hot tier (hits %d / %d queries)\n", stats.hot_hits, stats.queries);
+    return ok;
+}
+
+// 过滤检索与暴力计算比较：只返回位图内标签 (部门) 的启用用户
+static bool check_filter() {
+    std::mt19937 rng(41);
+    FeatureLibrary& library = FeatureLibrary::instance();
+    service::ScanPool& pool = service::ScanPool::instance();
+    int default_threads = pool.threads();
+    pool.resize(Config::Gallery::SCAN_THREADS);
+    library.set_ann(false);
+    reset_library();
+
+    // 超过并行扫描阈值的用户数，5 个部门，每 7 个用户禁用 1 个
+    const int USERS = (int)Config::Gallery::PARALLEL_SCAN_MIN_TEMPLATES + 1000, DEPARTMENTS = 5;
+    std::vector<db::User> users(USERS);
+    std::vector<std::vector<float>> templates(USERS, std::vector<float>(DIM));
+    std::vector<service::UserTemplates> entries(USERS);
+    for (int u = 0; u < USERS; ++u) {
+        users[u] = make_user(u);
+        users[u].department = "d" + std::to_string(u % DEPARTMENTS);
+        users[u].status = (u % 7 == 3) ? 0 : 1;
+        random_unit(rng, templates[u].data(), DIM);
+        entries[u].user = users[u];
+        entries[u].features.emplace_back(templates[u]);
+    }
+    library.add_users(entries);
+    library.set_ann(false);    // 合并增量区，基础存储按部门分区
+
+    std::vector<std::vector<float>> queries(24, std::vector<float>(DIM));
+    for (size_t q = 0; q < queries.size(); ++q) {
+        random_unit(rng, queries[q].data(), DIM);
+        const std::vector<float>& near = templates[q * 397 % USERS];
+        for (int i = 0; i < DIM; ++i) queries[q][i] = near[i] + 0.5f * queries[q][i];
+    }
+
+    auto allowed = [&](int64_t u, service::TagMask tags) {
+        return users[u].status == 1 && (tags & library.department_tags({users[u].department})) != 0;
+    };
+    auto brute = [&](const std::vector<float>& query, service::TagMask tags, int k) {
+        std::vector<float> n(query);
+        feature_normalize(n.data(), DIM);
+        std::vector<service::SearchMatch> all;
+        for (size_t u = 0; u < users.size(); ++u) {
+            if (allowed(u, tags)) all.push_back({(int64_t)u, scalar_dot(n.data(), templates[u].data(), DIM)});
+        }
+        std::sort(all.begin(), all.end(), [](const service::SearchMatch& a, const service::SearchMatch& b) {
+            return a.similarity > b.similarity;
+        });
+        all.resize(std::min<size_t>(all.size(), k));
+        return all;
+    };
+
+    // search_topk 与 search_batch 的结果都须在过滤范围内；exact 时前 k 名与暴力计算一致，
+    // 否则第一名一致的比例不低于 min_agree% (int8 重排；IVF 在随机数据上召回率低，只校验过滤)
+    // request 为传给检索的位图 (TAGS_DEFAULT 时 tags 为其期望的含义)
+    auto verify_as = [&](const char* name, service::TagMask tags, bool exact, service::TagFilter request,
+                         int min_agree) {
+        std::vector<Embedding> embedded = embed_all(queries);
+        auto batch = library.search_batch(embedded, 5, nullptr, request);
+        int agree = 0, total = 0;
+        for (size_t q = 0; q < queries.size(); ++q) {
+            auto want = brute(queries[q], tags, 5);
+            auto single = library.search_topk(embedded[q], 5, nullptr, request);
+            for (const auto& got : {single, batch[q]}) {
+                for (const auto& m : got) {
+                    if (!allowed(m.user_id, tags)) {
+                        printf("[FAIL] filter (%s): user %lld outside the filter\n", name, (long long)m.user_id);
+                        return false;
+                    }
+                }
+                bool same = got.size() == want.size();
+                for (size_t r = 0; same && r < want.size(); ++r) {
+                    same = got[r].user_id == want[r].user_id && fabsf(got[r].similarity - want[r].similarity) < 1e-4f;
+                }
+                if (exact && !same) {
+                    printf("[FAIL] filter (%s): query %zu differs from brute force\n", name, q);
+                    return false;
+                }
+                total++;
+                if (!got.empty() && !want.empty() && got[0].user_id == want[0].user_id) agree++;
+            }
+        }
+        if (agree * 100 < total * min_agree) {
+            printf("[FAIL] filter (%s): top-1 agrees on %d / %d\n", name, agree, total);
+            return false;
+        }
+        return true;
+    };
+    auto verify = [&](const char* name, service::TagMask tags, bool exact) {
+        return verify_as(name, tags, exact, tags, 90);
+    };
+
+    service::TagMask d1 = library.department_tags({"d1"}), d13 = library.department_tags({"d1", "d3"});
+    bool ok = d1 != 0 && (d13 & d1) && d13 != d1;
+    ok = ok && verify("float all", service::TAGS_ACTIVE, true) && verify("float d1", d1, true) &&
+         verify("float d1+d3", d13, true);
+
+    // 站点部门作为默认过滤
+    library.set_site_departments({"d3"});
+    ok = ok && verify_as("site d3", library.department_tags({"d3"}), true, service::TAGS_DEFAULT, 100);
+    library.set_site_departments({});
+    ok = ok && verify_as("default", service::TAGS_ACTIVE, true, service::TAGS_DEFAULT, 100);
+
+    // 未知或空的部门列表得到位图 0，不匹配任何用户 (不能退回默认过滤)
+    service::TagMask unknown = library.department_tags({"nonexistent"});
+    float similarity = 0.0f;
+    Embedding first = embed(queries[0]);
+    if (ok && (unknown != 0 || library.department_tags({}) != 0 ||
+               library.search(first, -1.0f, similarity, unknown) != -1)) {
+        printf("[FAIL] filter (unknown department): mask %llx matched a user\n", (unsigned long long)unknown);
+        ok = false;
+    }
+    ok = ok && verify_as("unknown department", 0, true, unknown, 0);
+    library.set_site_departments({"nonexistent"});
+    ok = ok && verify_as("site unknown", 0, true, service::TAGS_DEFAULT, 0);
+    library.set_site_departments({});
+
+    // 修改部门/禁用/启用 (增量区) 与新部门的用户
+    const int moved = 11, disabled = 12, enabled = 3;
+    users[moved].department = "d3";
+    users[disabled].status = 0;
+    users[enabled].status = 1;
+    for (int u : {moved, disabled, enabled}) library.update_user(users[u]);
+    queries[0] = templates[moved];
+    queries[1] = templates[disabled];
+    queries[2] = templates[enabled];
+    service::TagMask d3 = library.department_tags({"d3"});
+    ok = ok && verify("update d3", d3, true) && verify("update all", service::TAGS_ACTIVE, true);
+
+    // 热层：被禁用或移出站点部门的用户在特征库版本变化后不再由热层返回
+    library.set_site_departments({"d3"});
+    const int hot_disabled = 13, hot_moved = 18;
+    service::HotGallery hot(Config::Gallery::HOT_MAX_TEMPLATES);
+    std::vector<Embedding> hot_queries = embed_all({templates[hot_disabled], templates[hot_moved]});
+    const float threshold = Config::Default::RECOGNITION_THRESHOLD;
+    hot.touch(hot_disabled);
+    hot.touch(hot_moved);
+    std::vector<bool> from_hot;
+    auto before = hot.search_batch(hot_queries, 2, threshold, nullptr, &from_hot);
+    bool hot_ok = from_hot[0] && from_hot[1] && before[0][0].user_id == hot_disabled &&
+                  before[1][0].user_id == hot_moved;
+    users[hot_disabled].status = 0;
+    users[hot_moved].department = "d1";
+    library.update_user(users[hot_disabled]);
+    library.update_user(users[hot_moved]);
+    auto after = hot.search_batch(hot_queries, 2, threshold, nullptr, &from_hot);
+    for (size_t q = 0; q < after.size(); ++q) {
+        hot_ok = hot_ok && !from_hot[q];
+        for (const auto& m : after[q]) hot_ok = hot_ok && allowed(m.user_id, d3);
+    }
+    if (ok && (!hot_ok || hot.user_count() != 0)) {
+        printf("[FAIL] filter (hot tier): disabled / moved user still matched from the hot tier\n");
+        ok = false;
+    }
+    library.set_site_departments({});
+
+    users.push_back(make_user(USERS));
+    users.back().department = "new";
+    templates.push_back(queries[3]);
+    feature_normalize(templates.back().data(), DIM);
+    library.add_user(users.back(), embed(templates.back()));
+    service::TagMask fresh = library.department_tags({"new"});
+    ok = ok && fresh != 0 && verify("new department", fresh, true);
+    users.pop_back();
+    templates.pop_back();
+
+    // 合并后的分区、int8 与 IVF 存储
+    library.set_ann(false);
+    ok = ok && verify("compacted", d13, true);
+    if (ok && library.set_quantized(true)) {
+        ok = verify("int8 d1+d3", d13, false) && verify("int8 all", service::TAGS_ACTIVE, false);
+        library.set_quantized(false);
+    }
+    library.set_ann(true, 0);
+    ok = ok && library.ann_active() && verify_as("ivf d1", d1, false, d1, 0);
+
+    library.set_ann(Config::Gallery::ANN_ENABLED);
+    pool.resize(default_threads);
+    reset_library();
+    if (ok) printf("[ OK ] filtered search (department / status tags)\n");
+    return ok;
+}
+
+// 第 63 个及以后的部门共用溢出标签：按其过滤时报错且不匹配，也不混入其他溢出部门的用户
+static bool check_overflow_departments() {
+    std::mt19937 rng(43);
+    FeatureLibrary& library = FeatureLibrary::instance();
+    reset_library();
+
+    const int DEPARTMENTS = service::TAG_OVERFLOW + 8;
+    std::vector<std::vector<float>> templates(DEPARTMENTS, std::vector<float>(DIM));
+    for (int u = 0; u < DEPARTMENTS; ++u) {
+        db::User user = make_user(u);
+        user.department = "o" + std::to_string(u);
+        random_unit(rng, templates[u].data(), DIM);
+        library.add_user(user, embed(templates[u]));
+    }
+
+    const int last = DEPARTMENTS - 1, other = DEPARTMENTS - 2;
+    std::string last_department = "o" + std::to_string(last), other_department = "o" + std::to_string(other);
+    printf("  (expect two overflow department errors)\n");
+    service::TagMask overflow = library.department_tags({last_department});
+    service::TagMask own = library.department_tags({"o0"});
+    Embedding query = embed(templates[last]), other_query = embed(templates[other]);
+    auto active = library.search_topk(query, 1, nullptr, service::TAGS_ACTIVE);
+    bool ok = overflow == 0 && own != 0 && library.search_topk(other_query, 1, nullptr, overflow).empty() &&
+              !active.empty() && active[0].user_id == last;
+    for (const auto& m : library.search_topk(other_query, DEPARTMENTS, nullptr, own)) ok = ok && m.user_id == 0;
+
+    library.set_site_departments({other_department});
+    ok = ok && library.search_topk(query, DEPARTMENTS, nullptr).empty();
+    library.set_site_departments({});
+
+    reset_library();
+    if (!ok) {
+        printf("[FAIL] overflow departments: filter leaked or lost users\n");
+        return false;
+    }
+    printf("[ OK ] overflow departments\n");
+    return true;
+}
+
+// 临时文件放在 $TMPDIR (默认 /tmp)，不使用工作目录与正式的快照文件名
+static std::string temp_path(const char* name) {
+    const char* dir = getenv("TMPDIR");
+    return std::string(dir && *dir ? dir : "/tmp") + "/gallery_bench_" + std::to_string(getpid()) + "_" + name;
+}
+
+static const std::string TEMP_DB = temp_path("features.db");
+static const std::string TEMP_SNAPSHOT = temp_path("snapshot.bin");
+static const std::string TEMP_IVF = temp_path("ivf.bin");
+static const std::string TEMP_FLOAT_STORE = temp_path("float.bin");
+
+// 临时数据库：每个模板一个用户，在一个事务中写入
+static bool open_temp_db(const std::vector<std::vector<float>>& templates) {
+    unlink(TEMP_DB.c_str());
+    unlink(TEMP_SNAPSHOT.c_str());
+    FeatureLibrary::instance().set_snapshot_path(TEMP_SNAPSHOT);
+    db::DatabaseManager& dbm = db::DatabaseManager::instance();
+    if (!dbm.open(TEMP_DB)) return false;
+
+    db::UserDao user_dao;
+    db::FaceFeatureDao feature_dao;
+    dbm.begin_transaction();
+    for (size_t i = 0; i < templates.size(); ++i) {
+        db::User user = make_user(0);
+        user.user_name = "user_" + std::to_string(i);
+        db::FaceFeature feature;
+        feature.user_id = user_dao.add_user(user);
+        feature.feature_vector = embed(templates[i]);
+        feature_dao.add_feature(feature);
+    }
+    return dbm.commit_transaction();
+}
+
+static void close_temp_db() {
+    FeatureLibrary::instance().flush_snapshot_file();
+    db::DatabaseManager::instance().close();
+    unlink(TEMP_DB.c_str());
+    unlink(TEMP_SNAPSHOT.c_str());
+}
+
+// IVF 聚类中心文件记录训练所用的数据库：同一数据库重启时复用，换成其他数据库后重新训练
+static bool check_ivf_centroids() {
+    std::mt19937 rng(47);
+    FeatureLibrary& library = FeatureLibrary::instance();
+    std::vector<std::vector<float>> templates(400, std::vector<float>(DIM));
+    for (auto& t : templates) random_unit(rng, t.data(), DIM);
+
+    db::FaceFeatureDao dao;
+    db::FeatureRevision first, second;
+    unlink(TEMP_IVF.c_str());
+    library.set_ann(true, 0);
+    bool ok = open_temp_db(templates) && dao.get_revision(first);
+    library.load_from_database();
+    ok = ok && library.ann_active();
+    close_temp_db();
+    ok = ok && open_temp_db(templates) && dao.get_revision(second) && first.instance != second.instance;
+    library.load_from_database();
+    ok = ok && library.ann_active();
+
+    service::IvfIndex probe(DIM);
+    bool retrained = ok && probe.load_centroids(TEMP_IVF, second.instance) &&
+                     !probe.load_centroids(TEMP_IVF, first.instance);
+    float sim = 0.0f;
+    ok = retrained && library.search(embed(templates[7]), 0.99f, sim) >= 0;
+    close_temp_db();
+    unlink(TEMP_IVF.c_str());
+    library.set_ann(Config::Gallery::ANN_ENABLED);
+    reset_library();
+    if (!ok) {
+        printf("[FAIL] IVF centroids: %s\n", retrained ? "template not found" : "not retrained for another database");
+        return false;
+    }
+    printf("[ OK ] IVF centroid file (per database)\n");
+    return true;
+}
+
+// 共享连接上的事务隔离：其他线程的写操作等到事务结束后才执行，不随事务回滚
+static bool check_transaction_isolation() {
+    if (!open_temp_db({})) {
+        printf("[FAIL] transaction isolation: cannot open %s\n", TEMP_DB.c_str());
+        return false;
+    }
+    db::DatabaseManager& dbm = db::DatabaseManager::instance();
+    db::UserDao user_dao;
+
+    dbm.begin_transaction();
+    db::User batch_user = make_user(0);
+    batch_user.user_name = "batch";
+    user_dao.add_user(batch_user);
+
+    std::atomic<bool> written{false};
+    std::thread writer([&] {
+        db::User user = make_user(0);
+        user.user_name = "registered";
+        user_dao.add_user(user);
+        written = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool waited = !written;
+    dbm.rollback_transaction();
+    writer.join();
+
+    bool ok = waited && user_dao.get_user_by_name("registered") && !user_dao.get_user_by_name("batch");
+    close_temp_db();
+    if (!ok) {
+        printf("[FAIL] transaction isolation: write from another thread %s\n",
+               waited ? "lost with the rolled-back transaction" : "joined the open transaction");
+        return false;
+    }
+    printf("[ OK ] transaction isolation\n");
+    return true;
+}
+
+// 快照文件：往返一致、修订号不符/数据损坏时拒绝，数据库被外部修改后自动重建
+static bool check_gallery_file() {
+    std::mt19937 rng(29);
+    FeatureLibrary& library = FeatureLibrary::instance();
+    library.set_ann(false);
+
+    std::vector<std::vector<float>> templates(100, std::vector<float>(DIM));
+    for (auto& t : templates) random_unit(rng, t.data(), DIM);
+    if (!open_temp_db(templates)) {
+        printf("[FAIL] gallery file: cannot create %s\n", TEMP_DB.c_str());
+        return false;
+    }
+
+    // 冷启动：从数据库重建，后台写出快照文件
+    library.load_from_database();
+    library.flush_snapshot_file();
+    db::FaceFeatureDao dao;
+    db::FeatureRevision revision;
+    FeatureMatrix restored(DIM);
+    if (!dao.get_revision(revision) || !service::load_gallery_file(TEMP_SNAPSHOT, revision, restored) ||
+        restored.size() != templates.size()) {
+        printf("[FAIL] gallery file: snapshot not written after rebuild\n");
+        close_temp_db();
+        return false;
+    }
+
+    // 热启动：从快照文件恢复，检索结果不变
+    library.load_from_database();
+    for (size_t i = 0; i < templates.size(); ++i) {
+        float sim = 0.0f;
+        int64_t id = library.search(embed(templates[i]), 0.99f, sim);
+        if (id < 0 || restored.id(i) != id) {
+            printf("[FAIL] gallery file: template %zu not found after restore\n", i);
+            close_temp_db();
+            return false;
+        }
+    }
+
+    // 修订号不符 / 数据损坏
+    db::FeatureRevision stale = revision;
+    stale.revision--;
+    FeatureMatrix scratch(DIM);
+    bool stale_rejected = !service::load_gallery_file(TEMP_SNAPSHOT, stale, scratch);
+    FILE* f = fopen(TEMP_SNAPSHOT.c_str(), "r+b");
+    if (f) {
+        fseek(f, -7, SEEK_END);
+        int c = fgetc(f);
+        fseek(f, -7, SEEK_END);
+        fputc(c ^ 0x5a, f);
+        fclose(f);
+    }
+    bool corrupt_rejected = !service::load_gallery_file(TEMP_SNAPSHOT, revision, scratch);
+    if (!stale_rejected || !corrupt_rejected || !scratch.empty()) {
+        printf("[FAIL] gallery file: stale/corrupt snapshot accepted\n");
+        close_temp_db();
+        return false;
+    }
+
+    // 数据库被直接修改 (绕过特征库)：修订号变化，下次加载从数据库重建
+    std::vector<float> extra(DIM);
+    random_unit(rng, extra.data(), DIM);
+    db::FaceFeature feature;
+    feature.user_id = 1;
+    feature.feature_vector = embed(extra);
+    dao.add_feature(feature);
+    library.load_from_database();
+    float sim = 0.0f;
+    bool rebuilt = library.template_count() == templates.size() + 1 && library.search(embed(extra), 0.99f, sim) == 1;
+    library.flush_snapshot_file();
+    db::FeatureRevision updated;
+    dao.get_revision(updated);
+    rebuilt = rebuilt && updated.revision != revision.revision &&
+              service::load_gallery_file(TEMP_SNAPSHOT, updated, scratch);
+
+    // 半精度存储写出的文件标明精度：float 存储启动时拒绝，从数据库重建精确模板后重写
+    library.set_storage(FeatureLibrary::Storage::FLOAT16);
+    random_unit(rng, extra.data(), DIM);
+    feature.feature_vector = embed(extra);
+    dao.add_feature(feature);
+    library.load_from_database();
+    library.flush_snapshot_file();
+    dao.get_revision(updated);
+    service::GalleryPrecision precision = service::GalleryPrecision::EXACT;
+    bool fp16_marked = !service::load_gallery_file(TEMP_SNAPSHOT, updated, scratch) &&
+                       service::load_gallery_file(TEMP_SNAPSHOT, updated, scratch, service::GalleryPrecision::FP16,
+                                                  &precision) &&
+                       precision == service::GalleryPrecision::FP16;
+    library.set_storage(FeatureLibrary::Storage::FLOAT32);
+    library.load_from_database();
+    library.flush_snapshot_file();
+    bool exact_restored = service::load_gallery_file(TEMP_SNAPSHOT, updated, scratch);
+
+    close_temp_db();
+    library.set_ann(Config::Gallery::ANN_ENABLED);
+    reset_library();
+    if (!rebuilt) {
+        printf("[FAIL] gallery file: stale snapshot not rebuilt from database\n");
+        return false;
+    }
+    if (!fp16_marked || !exact_restored) {
+        printf("[FAIL] gallery file: fp16-rounded snapshot %s\n",
+               fp16_marked ? "loaded by float storage" : "not marked as fp16");
+        return false;
+    }
+    printf("[ OK ] gallery snapshot file\n");
+    return true;
+}
+
+// 写线程持续增删用户 (触发多次合并与存储切换)，读线程同时检索固定用户，结果必须始终正确
+static bool check_snapshot() {
+    std::mt19937 rng(23);
+    const int STABLE = 200, CHURN = 2000;
+    FeatureLibrary& library = FeatureLibrary::instance();
+    library.set_ann(false);
+    reset_library();
+
+    std::vector<std::vector<float>> stable(STABLE, std::vector<float>(DIM));
+    for (auto& t : stable) random_unit(rng, t.data(), DIM);
+    add_templates(stable);
+    std::vector<Embedding> stable_queries = embed_all(stable);
+
+    std::atomic<bool> running(true);
+    std::atomic<long> searches(0), errors(0);
+    auto reader = [&](int seed) {
+        size_t i = seed;
+        while (running) {
+            float sim = 0.0f;
+            size_t u = (i++ * 7) % STABLE;
+            if (library.search(stable_queries[u], 0.99f, sim) != (int64_t)u) errors++;
+            searches++;
+        }
+    };
+    std::thread r1(reader, 0), r2(reader, 1);
+
+    std::vector<std::vector<float>> churn(CHURN, std::vector<float>(DIM));
+    for (int i = 0; i < CHURN; ++i) {
+        random_unit(rng, churn[i].data(), DIM);
+        add_template(10000 + i, churn[i]);
+        if (i % 2 == 1) library.remove_user(10000 + i - 1);
+        if (i == CHURN / 4) library.set_ann(true, 0);
+        if (i == CHURN / 2) library.set_ann(false);
+        if (i == CHURN * 3 / 4) library.set_quantized(true);
+    }
+    library.set_quantized(false);
+    running = false;
+    r1.join();
+    r2.join();
+
+    if (errors > 0) {
+        printf("[FAIL] snapshot: %ld of %ld concurrent searches wrong\n", errors.load(), searches.load());
+        return false;
+    }
+    for (int i = 0; i < CHURN; ++i) {
+        float sim = 0.0f;
+        int64_t want = (i % 2 == 1) ? 10000 + i : -1;
+        if (library.search(embed(churn[i]), 0.99f, sim) != want) {
+            printf("[FAIL] snapshot: churn user %d found=%d, want %s\n", i, i % 2, (i % 2) ? "present" : "removed");
+            return false;
+        }
+    }
+    if (library.template_count() != (size_t)(STABLE + CHURN / 2)) {
+        printf("[FAIL] snapshot: %zu templates, want %d\n", library.template_count(), STABLE + CHURN / 2);
+        return false;
+    }
+
+    // 删除后以同一 ID 重新注册：旧模板不可见，新模板可见
+    std::vector<float> renewed(DIM);
+    random_unit(rng, renewed.data(), DIM);
+    library.remove_user(3);
+    add_template(3, renewed);
+    float sim = 0.0f;
+    service::UserInfo info;
+    if (library.search(stable_queries[3], 0.99f, sim) != -1 || library.search(embed(renewed), 0.99f, sim) != 3 ||
+        !library.get_user(3, info)) {
+        printf("[FAIL] snapshot: re-registered user not resolved\n");
+        return false;
+    }
+
+    library.set_ann(Config::Gallery::ANN_ENABLED);
+    reset_library();
+    printf("[ OK ] FeatureLibrary snapshots (%ld concurrent searches)\n", searches.load());
+    return true;
+}
+
+static int cmd_test() {
+    int failed = 0;
+    if (!check_dot_rows()) failed++;
+    if (!check_matrix()) failed++;
+    if (!check_int8()) failed++;
+    if (!check_embedding()) failed++;
+    if (!check_topk()) failed++;
+    if (!check_fp16()) failed++;
+    if (!check_ivf()) failed++;
+    if (!check_snapshot()) failed++;
+    if (!check_gallery_file()) failed++;
+    if (!check_transaction_isolation()) failed++;
+    if (!check_ivf_centroids()) failed++;
+    if (!check_parallel_scan()) failed++;
+    if (!check_hot_tier()) failed++;
+    if (!check_filter()) failed++;
+    if (!check_overflow_departments()) failed++;
+    printf("%s: %d failure(s)\n", failed ? "FAILED" : "PASSED", failed);
+    return failed ? 1 : 0;
+}
+
+// ============================================
+// bench (输出格式参照 Google Benchmark)
+// ============================================
+
+static const double MIN_BENCH_TIME_S = 0.5;
+
+static void do_not_optimize(const void* p) {
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+static double now_s(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 返回每次迭代的墙钟耗时 (ns)
+template <typename Fn>
+static double run_benchmark(const std::string& name, Fn&& fn) {
+    fn();  // 预热
+    long iters = 1;
+    while (true) {
+        double w0 = now_s(CLOCK_MONOTONIC);
+        double c0 = now_s(CLOCK_THREAD_CPUTIME_ID);
+        for (long i = 0; i < iters; ++i) fn();
+        double wall = now_s(CLOCK_MONOTONIC) - w0;
+        double cpu = now_s(CLOCK_THREAD_CPUTIME_ID) - c0;
+        if (wall >= MIN_BENCH_TIME_S || iters >= (1L << 30)) {
+            printf("%-36s %12.0f ns %12.0f ns %12ld\n", name.c_str(),
+                   wall * 1e9 / iters, cpu * 1e9 / iters, iters);
+            return wall * 1e9 / iters;
+        }
+        iters *= (wall < MIN_BENCH_TIME_S / 10) ? 10 : 2;
+    }
+}
+
+// 召回率：int8 检索返回的用户与 float 精确检索一致的比例
+static const int RECALL_QUERIES = 500;
+static const float QUERY_NOISE = 0.04f;    // 有匹配查询：模板 + 噪声 (余弦约 0.7)
+static const int BATCH_SIZES[] = {1, 4, 16, 64};
+
+// 分片并行扫描：按扫描线程数 (含调用线程) 1..SCAN_THREADS 测量，输出相对单线程的加速比
+template <typename Fn>
+static void bench_scan_threads(const std::string& name, size_t templates, Fn&& fn) {
+    if (templates < Config::Gallery::PARALLEL_SCAN_MIN_TEMPLATES) return;
+    service::ScanPool& pool = service::ScanPool::instance();
+    int default_threads = pool.threads();
+    unsigned cpus = std::thread::hardware_concurrency();
+
+    double single_ns = 0.0;
+    for (int t = 1; t <= Config::Gallery::SCAN_THREADS; ++t) {
+        if (t > 1 && (unsigned)t > cpus) {
+            printf("  (only %u CPU(s), skipping %d+ threads)\n", cpus, t);
+            break;
+        }
+        pool.resize(t);
+        double ns = run_benchmark(name + "/T:" + std::to_string(t), fn);
+        if (t == 1) single_ns = ns;
+        printf("  speedup: %.2fx\n", single_ns / ns);
+    }
+    pool.resize(default_threads);
+}
+
+// 单次检索延迟的分位数 (微秒)
+static void search_latency(FeatureLibrary& library, const std::vector<Embedding>& queries,
+                           std::vector<double>& out_us) {
+    out_us.clear();
+    for (int round = 0; round < 4; ++round) {
+        for (const auto& q : queries) {
+            double t0 = now_s(CLOCK_MONOTONIC);
+            float sim;
+            int64_t id = library.search(q, Config::Default::RECOGNITION_THRESHOLD, sim);
+            do_not_optimize(&id);
+            out_us.push_back((now_s(CLOCK_MONOTONIC) - t0) * 1e6);
+        }
+    }
+    std::sort(out_us.begin(), out_us.end());
+}
+
+// 检索延迟：空闲时 vs 另一线程每 UPDATE_INTERVAL_MS 注册并删除一个用户 (每次发布新快照，检索不等待写者)
+static const int UPDATE_INTERVAL_MS = 20;
+
+static void bench_update_latency(FeatureLibrary& library, const std::vector<Embedding>& queries,
+                                 std::mt19937& rng) {
+    std::vector<double> idle, busy;
+    search_latency(library, queries, idle);
+
+    std::vector<float> f(DIM);
+    random_unit(rng, f.data(), DIM);
+    std::atomic<bool> running(true);
+    long updates = 0;
+    std::thread writer([&]() {
+        for (int64_t id = 1LL << 40; running; ++id) {
+            add_template(id, f);
+            library.remove_user(id);
+            updates += 2;
+            std::this_thread::sleep_for(std::chrono::milliseconds(UPDATE_INTERVAL_MS));
+        }
+    });
+    double t0 = now_s(CLOCK_MONOTONIC);
+    search_latency(library, queries, busy);
+    double elapsed = now_s(CLOCK_MONOTONIC) - t0;
+    running = false;
+    writer.join();
+
+    auto pct = [](const std::vector<double>& v, double p) { return v[(size_t)(p * (v.size() - 1))]; };
+    printf("  search latency us p50/p99/max idle: %.0f / %.0f / %.0f, during updates: %.0f / %.0f / %.0f"
+           " (%.0f updates/s)\n",
+           pct(idle, 0.5), pct(idle, 0.99), idle.back(), pct(busy, 0.5), pct(busy, 0.99), busy.back(),
+           updates / elapsed);
+}
+
+static void bench_library(const std::vector<std::vector<float>>& templates, std::mt19937& rng) {
+    FeatureLibrary& library = FeatureLibrary::instance();
+    library.set_quantized(false);
+    library.set_ann(false);     // 基线为精确扫描
+    reset_library();
+    add_templates(templates);
+
+    // 一半查询有对应模板，一半为随机向量 (最相近的模板之间得分接近，最容易被量化误差打乱)
+    std::normal_distribution<float> noise(0.0f, QUERY_NOISE);
+    std::uniform_int_distribution<size_t> pick(0, templates.size() - 1);
+    std::vector<std::vector<float>> raw_queries(RECALL_QUERIES, std::vector<float>(DIM));
+    for (int q = 0; q < RECALL_QUERIES; ++q) {
+        if (q % 2 == 0) {
+            const std::vector<float>& t = templates[pick(rng)];
+            for (int i = 0; i < DIM; ++i) raw_queries[q][i] = t[i] + noise(rng);
+        } else {
+            random_unit(rng, raw_queries[q].data(), DIM);
+        }
+    }
+    std::vector<Embedding> queries = embed_all(raw_queries);
+
+    std::vector<int64_t> exact(RECALL_QUERIES);
+    for (int q = 0; q < RECALL_QUERIES; ++q) {
+        float sim;
+        exact[q] = library.search(queries[q], -1.0f, sim);
+    }
+
+    std::string suffix = "/N:" + std::to_string(templates.size());
+    size_t qi = 0;
+    run_benchmark("BM_LibrarySearchFloat" + suffix, [&]() {
+        float sim;
+        int64_t id = library.search(queries[qi++ % RECALL_QUERIES], Config::Default::RECOGNITION_THRESHOLD, sim);
+        do_not_optimize(&id);
+    });
+    bench_scan_threads("BM_LibrarySearchFloat" + suffix, templates.size(), [&]() {
+        float sim;
+        int64_t id = library.search(queries[qi++ % RECALL_QUERIES], Config::Default::RECOGNITION_THRESHOLD, sim);
+        do_not_optimize(&id);
+    });
+    run_benchmark("BM_LibrarySearchTopK5" + suffix, [&]() {
+        float margin;
+        std::vector<service::SearchMatch> top = library.search_topk(queries[qi++ % RECALL_QUERIES], 5, &margin);
+        do_not_optimize(top.data());
+    });
+    // 批量检索：输出整批耗时，另给出折算到每个查询的耗时
+    for (int batch : BATCH_SIZES) {
+        std::vector<Embedding> batch_queries(queries.begin(), queries.begin() + batch);
+        std::vector<float> margins;
+        double t0 = now_s(CLOCK_MONOTONIC);
+        long calls = 0;
+        run_benchmark("BM_LibrarySearchBatch" + suffix + "/B:" + std::to_string(batch), [&]() {
+            auto results = library.search_batch(batch_queries, 5, &margins);
+            do_not_optimize(results.data());
+            calls++;
+        });
+        double per_query_ns = (now_s(CLOCK_MONOTONIC) - t0) * 1e9 / calls / batch;
+        printf("  per query: %.0f ns\n", per_query_ns);
+    }
+    size_t float_bytes = library.memory_bytes();
+    bench_update_latency(library, queries, rng);
+
+    // IVF 近似检索：延迟与相对精确扫描的召回率
+    library.set_ann(true, 0);
+    run_benchmark("BM_LibrarySearchIvf" + suffix, [&]() {
+        float sim;
+        int64_t id = library.search(queries[qi++ % RECALL_QUERIES], Config::Default::RECOGNITION_THRESHOLD, sim);
+        do_not_optimize(&id);
+    });
+    int ivf_hits[2] = {0, 0};
+    for (int q = 0; q < RECALL_QUERIES; ++q) {
+        float sim;
+        if (library.search(queries[q], -1.0f, sim) == exact[q]) ivf_hits[q % 2]++;
+    }
+    printf("  IVF recall@1 matched/random: %.1f%% / %.1f%% (nprobe %d)\n",
+           100.0 * ivf_hits[0] / (RECALL_QUERIES / 2), 100.0 * ivf_hits[1] / (RECALL_QUERIES / 2),
+           Config::Gallery::IVF_NPROBE);
+    library.set_ann(false);
+
+    // 半精度存储：扫描带宽减半，不重排
+    library.set_storage(FeatureLibrary::Storage::FLOAT16);
+    run_benchmark("BM_LibrarySearchFp16" + suffix, [&]() {
+        float sim;
+        int64_t id = library.search(queries[qi++ % RECALL_QUERIES], Config::Default::RECOGNITION_THRESHOLD, sim);
+        do_not_optimize(&id);
+    });
+    bench_scan_threads("BM_LibrarySearchFp16" + suffix, templates.size(), [&]() {
+        float sim;
+        int64_t id = library.search(queries[qi++ % RECALL_QUERIES], Config::Default::RECOGNITION_THRESHOLD, sim);
+        do_not_optimize(&id);
+    });
+    int fp16_hits[2] = {0, 0};
+    for (int q = 0; q < RECALL_QUERIES; ++q) {
+        float sim;
+        if (library.search(queries[q], -1.0f, sim) == exact[q]) fp16_hits[q % 2]++;
+    }
+    printf("  resident memory fp16: %.1f MB, fp16 recall@1 matched/random: %.1f%% / %.1f%%\n",
+           library.memory_bytes() / (1024.0 * 1024.0),
+           100.0 * fp16_hits[0] / (RECALL_QUERIES / 2), 100.0 * fp16_hits[1] / (RECALL_QUERIES / 2));
+    library.set_storage(FeatureLibrary::Storage::FLOAT32);
+
+    if (!library.set_quantized(true)) {
+        printf("  int8 storage unavailable (cannot create %s)\n", Config::Path::GALLERY_FLOAT_STORE);
+        return;
+    }
+    run_benchmark("BM_LibrarySearchInt8" + suffix, [&]() {
+        float sim;
+        int64_t id = library.search(queries[qi++ % RECALL_QUERIES], Config::Default::RECOGNITION_THRESHOLD, sim);
+        do_not_optimize(&id);
+    });
+    bench_scan_threads("BM_LibrarySearchInt8" + suffix, templates.size(), [&]() {
+        float sim;
+        int64_t id = library.search(queries[qi++ % RECALL_QUERIES], Config::Default::RECOGNITION_THRESHOLD, sim);
+        do_not_optimize(&id);
+    });
+    size_t int8_bytes = library.memory_bytes();
+
+    int hits[2] = {0, 0};
+    for (int q = 0; q < RECALL_QUERIES; ++q) {
+        float sim;
+        if (library.search(queries[q], -1.0f, sim) == exact[q]) hits[q % 2]++;
+    }
+    library.set_quantized(false);
+
+    printf("  resident memory float/int8: %.1f / %.1f MB, int8 recall@1 matched/random: %.1f%% / %.1f%% (rerank %d)\n",
+           float_bytes / (1024.0 * 1024.0), int8_bytes / (1024.0 * 1024.0),
+           100.0 * hits[0] / (RECALL_QUERIES / 2), 100.0 * hits[1] / (RECALL_QUERIES / 2),
+           Config::Gallery::RERANK_CANDIDATES);
+}
+
+// 启动加载耗时：从 SQLite 逐行读取 BLOB 重建 vs 从快照文件恢复
+static void bench_startup(const std::vector<std::vector<float>>& templates) {
+    FeatureLibrary& library = FeatureLibrary::instance();
+    library.set_quantized(false);
+    library.set_ann(false);
+    if (!open_temp_db(templates)) {
+        printf("  startup: cannot create %s\n", TEMP_DB.c_str());
+        return;
+    }
+
+    double t0 = now_s(CLOCK_MONOTONIC);
+    library.load_from_database();       // 无快照文件：从数据库重建
+    double from_db = now_s(CLOCK_MONOTONIC) - t0;
+    library.flush_snapshot_file();
+
+    t0 = now_s(CLOCK_MONOTONIC);
+    library.load_from_database();       // 修订号一致：从快照文件恢复
+    double from_file = now_s(CLOCK_MONOTONIC) - t0;
+
+    printf("  startup load from database / snapshot file: %.1f / %.1f ms\n", from_db * 1e3, from_file * 1e3);
+    close_temp_db();
+    library.set_ann(Config::Gallery::ANN_ENABLED);
+    reset_library();
+}
+
+// 按部门过滤的检索：模板分属 FILTER_DEPARTMENTS 个部门，只检索其中一个部门时只扫描其分区
+static const int FILTER_DEPARTMENTS = 10;
+
+static void bench_filter(const std::vector<std::vector<float>>& templates, std::mt19937& rng) {
+    FeatureLibrary& library = FeatureLibrary::instance();
+    library.set_ann(false);
+    reset_library();
+
+    std::vector<service::UserTemplates> entries(templates.size());
+    for (size_t i = 0; i < templates.size(); ++i) {
+        entries[i].user = make_user((int64_t)i);
+        entries[i].user.department = "d" + std::to_string(i % FILTER_DEPARTMENTS);
+        entries[i].features.emplace_back(templates[i]);
+    }
+    library.add_users(entries);
+    library.set_ann(false);     // 合并增量区，基础存储按部门分区
+
+    std::vector<float> raw(DIM);
+    std::vector<Embedding> queries;
+    for (int q = 0; q < RECALL_QUERIES; ++q) {
+        random_unit(rng, raw.data(), DIM);
+        queries.emplace_back(raw);
+    }
+    service::TagMask one = library.department_tags({"d0"});
+
+    std::string suffix = "/N:" + std::to_string(templates.size());
+    size_t qi = 0;
+    for (service::TagMask tags : {service::TAGS_ACTIVE, one}) {
+        run_benchmark("BM_LibrarySearchFiltered" + suffix + (tags == one ? "/1of10" : "/all"), [&]() {
+            std::vector<service::SearchMatch> top = library.search_topk(queries[qi++ % RECALL_QUERIES], 2, nullptr, tags);
+            do_not_optimize(top.data());
+        });
+    }
+
+    library.set_ann(Config::Gallery::ANN_ENABLED);
+    reset_library();
+}
+
+static int cmd_bench(const std::vector<size_t>& sizes) {
+    printf("kernel: %s, dim: %d\n", feature_kernel_isa(), DIM);
+    printf("%-36s %15s %15s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+    printf("------------------------------------------------------------------------------\n");
+
+    std::mt19937 rng(3);
+    std::vector<float> query(DIM);
+    random_unit(rng, query.data(), DIM);
+
+    // FaceNet 输出到 Embedding：运行时转成 float 后再复制归一化 (want_float=1)，
+    // 与直接读取半精度原始输出、转换与归一化融合为一次的路径
+    std::vector<uint16_t> raw_output(DIM);
+    std::vector<float> float_output(DIM);
+    feature_f32_to_f16(query.data(), DIM, raw_output.data());
+    Embedding embedding;
+    run_benchmark("BM_EmbedFloatOutput", [&]() {
+        feature_f16_to_f32(raw_output.data(), DIM, float_output.data());
+        embedding.assign(float_output.data());
+        do_not_optimize(embedding.data());
+    });
+    run_benchmark("BM_EmbedFp16Output", [&]() {
+        embedding.assign_f16(raw_output.data());
+        do_not_optimize(embedding.data());
+    });
+
+    for (size_t n : sizes) {
+        // 原实现：每个模板一个堆上的 std::vector，逐个标量点积
+        std::vector<std::vector<float>> legacy(n, std::vector<float>(DIM));
+        FeatureMatrix matrix(DIM);
+        matrix.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            random_unit(rng, legacy[i].data(), DIM);
+            matrix.append((int64_t)i, legacy[i].data());
+        }
+
+        std::string suffix = "/N:" + std::to_string(n);
+        run_benchmark("BM_SearchLegacy" + suffix, [&]() {
+            float best = -1.0f;
+            size_t best_i = 0;
+            for (size_t i = 0; i < legacy.size(); ++i) {
+                float dot = 0.0f;
+                for (int k = 0; k < DIM; ++k) dot += query[k] * legacy[i][k];
+                if (dot > best) { best = dot; best_i = i; }
+            }
+            do_not_optimize(&best_i);
+        });
+        run_benchmark("BM_SearchMatrix" + suffix, [&]() {
+            float score;
+            long best = matrix.best_match(query.data(), score);
+            do_not_optimize(&best);
+        });
+        printf("  gallery memory: %.1f MB\n", n * matrix.stride() * sizeof(float) / (1024.0 * 1024.0));
+
+        bench_library(legacy, rng);
+        bench_filter(legacy, rng);
+        bench_startup(legacy);
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    // 聚类中心与 int8 的 float 映射文件放在临时目录，不覆盖应用的文件
+    FeatureLibrary::instance().set_index_path(TEMP_IVF);
+    FeatureLibrary::instance().set_float_store_path(TEMP_FLOAT_STORE);
+    std::string command = argv[1];
+    int rc = 1;
+    if (command == "test") {
+        rc = cmd_test();
+    } else if (command == "bench") {
+        std::vector<size_t> sizes;
+        for (int i = 2; i < argc; ++i) sizes.push_back(strtoul(argv[i], nullptr, 10));
+        if (sizes.empty()) sizes.assign(std::begin(DEFAULT_SIZES), std::end(DEFAULT_SIZES));
+        rc = cmd_bench(sizes);
+    } else {
+        print_usage();
+    }
+    unlink(TEMP_IVF.c_str());
+    unlink(TEMP_FLOAT_STORE.c_str());
+    return rc;
+}
@@ -0,0 +1,363 @@
+/**
+ * @file gallery_loadgen.cc
+ * @brief 特征库负载生成器：合成身份的规模测试
+ * @details 生成 N 个身份 × M 个模板的合成 512 维特征 (按身份聚集，类内/类间离散度可调)，
+ *          经 UserDao / FaceFeatureDao 写入临时数据库，再通过 FeatureLibrary::load_from_database
+ *          加载 (与程序启动走同一路径)，输出写库/加载耗时、内存、检索延迟分位数以及在识别阈值下的
+ *          top-1 准确率。用于按在册人数评估新站点所需的硬件。
+ *
+ *          合成模型：身份中心 c = normalize(sqrt(ρ)·s + sqrt(1-ρ)·r)，s 为所有身份共享的方向、
+ *          r 为身份自己的随机方向，两个身份中心的期望余弦为 ρ (--inter)；
+ *          每个样本 (注册模板或查询) = normalize(c + σ·g/sqrt(d))，g ~ N(0, I)，
+ *          同一身份两个样本的期望余弦约为 1/(1+σ²) (--intra)。
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/feature_kernels.h"
+#include "core/embedding.h"
+#include "service/feature_library.h"
+#include "service/scan_pool.h"
+#include "service/hot_gallery.h"
+#include "database/database_manager.h"
+#include "database/user_dao.h"
+#include "database/face_feature_dao.h"
+#include "config.h"
+
+using service::FeatureLibrary;
+
+static const int DIM = Config::Model::FEATURE_DIM;
+static const int RECENT_IDENTITIES = 32;   // --revisit 的候选：最近出现过的身份数 (模拟几分钟内的人流与常客)
+
+struct LoadgenOptions {
+    int identities = 10000;         // 在册身份数 N
+    int templates = 3;              // 每个身份的模板数 M
+    float intra = 0.7f;             // 类内离散度 σ (同人样本余弦约 1/(1+σ²))
+    float inter = 0.05f;            // 类间中心的期望余弦 ρ
+    int queries = 2000;             // 查询数
+    float unknown = 0.2f;           // 查询中未注册身份的比例
+    float revisit = 0.0f;           // 注册身份的查询来自最近出现过的身份的比例
+    bool hot = false;               // 经热层 (HotGallery) 检索
+    float threshold = Config::Default::RECOGNITION_THRESHOLD;
+    bool int8 = Config::Gallery::INT8_STORAGE;
+    bool ann = Config::Gallery::ANN_ENABLED;
+    int scan_threads = 0;           // 0 = ScanPool 默认
+    unsigned seed = 1;
+    std::string db_path = "./gallery_loadgen.db";
+    bool keep_db = false;
+};
+
+void print_usage() {
+    printf("Usage:\n");
+    printf("  gallery_loadgen [options]\n");
+    printf("    --identities N     在册身份数 (默认 10000)\n");
+    printf("    --templates M      每个身份的模板数 (默认 3)\n");
+    printf("    --intra S          类内离散度 σ，同人样本余弦约 1/(1+σ²) (默认 0.7)\n");
+    printf("    --inter R          不同身份中心的期望余弦 (默认 0.05)\n");
+    printf("    --queries Q        查询数 (默认 2000)\n");
+    printf("    --unknown F        查询中未注册身份的比例 (默认 0.2)\n");
+    printf("    --revisit P        注册身份的查询中重复最近 %d 个身份之一的比例 (默认 0)\n", RECENT_IDENTITIES);
+    printf("    --hot              先检索最近匹配用户的热层 (与识别线程相同)，分层输出命中率与延迟\n");
+    printf("    --threshold T      识别阈值 (默认 %.2f)\n", Config::Default::RECOGNITION_THRESHOLD);
+    printf("    --int8 / --float   模板存储格式 (默认 %s)\n", Config::Gallery::INT8_STORAGE ? "int8" : "float");
+    printf("    --ann / --exact    是否允许 IVF 近似检索 (默认 %s)\n", Config::Gallery::ANN_ENABLED ? "ann" : "exact");
+    printf("    --scan-threads K   并行扫描线程数 (默认按 CPU 数)\n");
+    printf("    --seed S           随机种子 (默认 1)\n");
+    printf("    --db PATH          临时数据库路径 (默认 ./gallery_loadgen.db，运行前清空)\n");
+    printf("    --keep-db          结束后保留数据库与快照文件 (<db>.snapshot)\n");
+}
+
+static bool parse_options(int argc, char* argv[], LoadgenOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--identities" && has_value) opt.identities = atoi(argv[++i]);
+        else if (arg == "--templates" && has_value) opt.templates = atoi(argv[++i]);
+        else if (arg == "--intra" && has_value) opt.intra = (float)atof(argv[++i]);
+        else if (arg == "--inter" && has_value) opt.inter = (float)atof(argv[++i]);
+        else if (arg == "--queries" && has_value) opt.queries = atoi(argv[++i]);
+        else if (arg == "--unknown" && has_value) opt.unknown = (float)atof(argv[++i]);
+        else if (arg == "--revisit" && has_value) opt.revisit = (float)atof(argv[++i]);
+        else if (arg == "--threshold" && has_value) opt.threshold = (float)atof(argv[++i]);
+        else if (arg == "--scan-threads" && has_value) opt.scan_threads = atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) opt.seed = (unsigned)atoi(argv[++i]);
+        else if (arg == "--db" && has_value) opt.db_path = argv[++i];
+        else if (arg == "--int8") opt.int8 = true;
+        else if (arg == "--float") opt.int8 = false;
+        else if (arg == "--ann") opt.ann = true;
+        else if (arg == "--exact") opt.ann = false;
+        else if (arg == "--keep-db") opt.keep_db = true;
+        else if (arg == "--hot") opt.hot = true;
+        else return false;
+    }
+    return opt.identities > 0 && opt.templates > 0 && opt.queries > 0 && opt.intra >= 0.0f &&
+           opt.inter >= 0.0f && opt.inter < 1.0f && opt.unknown >= 0.0f && opt.unknown <= 1.0f &&
+           opt.revisit >= 0.0f && opt.revisit <= 1.0f;
+}
+
+static double now_s() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 进程常驻内存 (MB)
+static double rss_mb() {
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0.0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+// 合成身份：中心按身份编号确定性生成，不需要保存 N×d 的中心矩阵
+class SyntheticIdentities {
+public:
+    explicit SyntheticIdentities(const LoadgenOptions& opt) : opt_(opt), shared_(DIM) {
+        std::mt19937 rng(opt.seed);
+        gaussian(rng, shared_.data());
+        feature_normalize(shared_.data(), DIM);
+    }
+
+    // 身份 identity 的一个样本 (注册模板或查询)；identity >= N 为未注册身份
+    void sample(int identity, std::mt19937& rng, float* out) const {
+        std::vector<float> center(DIM);
+        std::mt19937 center_rng(opt_.seed * 2654435761u + (unsigned)identity + 1);
+        gaussian(center_rng, center.data());
+        feature_normalize(center.data(), DIM);
+
+        float a = sqrtf(opt_.inter), b = sqrtf(1.0f - opt_.inter);
+        float noise = opt_.intra / sqrtf((float)DIM);
+        std::normal_distribution<float> g(0.0f, 1.0f);
+        for (int i = 0; i < DIM; ++i) {
+            out[i] = a * shared_[i] + b * center[i] + noise * g(rng);
+        }
+        feature_normalize(out, DIM);
+    }
+
+private:
+    static void gaussian(std::mt19937& rng, float* v) {
+        std::normal_distribution<float> g(0.0f, 1.0f);
+        for (int i = 0; i < DIM; ++i) v[i] = g(rng);
+    }
+
+    const LoadgenOptions& opt_;
+    std::vector<float> shared_;
+};
+
+// 经 DAO 写入 N 个用户与 N×M 个模板 (单个事务)，user_ids[i] 为身份 i 的数据库 ID
+static bool populate(const LoadgenOptions& opt, const SyntheticIdentities& ids, std::vector<int64_t>& user_ids) {
+    db::DatabaseManager& dbm = db::DatabaseManager::instance();
+    db::UserDao user_dao;
+    db::FaceFeatureDao feature_dao;
+    std::mt19937 rng(opt.seed + 17);
+
+    float raw[DIM];
+    user_ids.assign(opt.identities, -1);
+    if (!dbm.begin_transaction()) return false;
+    for (int i = 0; i < opt.identities; ++i) {
+        db::User user;
+        user.user_name = "synthetic_" + std::to_string(i);
+        user.department = "loadgen";
+        user_ids[i] = user_dao.add_user(user);
+        if (user_ids[i] < 0) {
+            dbm.rollback_transaction();
+            return false;
+        }
+
+        db::FaceFeature feature;
+        feature.user_id = user_ids[i];
+        for (int t = 0; t < opt.templates; ++t) {
+            ids.sample(i, rng, raw);
+            feature.feature_vector.assign(raw);
+            if (feature_dao.add_feature(feature) < 0) {
+                dbm.rollback_transaction();
+                return false;
+            }
+        }
+    }
+    return dbm.commit_transaction();
+}
+
+// 快照、聚类中心与 float 映射文件和数据库放在一起，不覆盖应用的文件
+static std::string snapshot_path(const LoadgenOptions& opt) {
+    return opt.db_path + ".snapshot";
+}
+
+static std::string index_path(const LoadgenOptions& opt) {
+    return opt.db_path + ".ivf";
+}
+
+static std::string float_store_path(const LoadgenOptions& opt) {
+    return opt.db_path + ".float";
+}
+
+static void remove_files(const LoadgenOptions& opt) {
+    unlink(opt.db_path.c_str());
+    unlink(snapshot_path(opt).c_str());
+    unlink(index_path(opt).c_str());
+    unlink(float_store_path(opt).c_str());
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    return sorted[(size_t)(p * (sorted.size() - 1))];
+}
+
+int main(int argc, char* argv[]) {
+    LoadgenOptions opt;
+    if (!parse_options(argc, argv, opt)) {
+        print_usage();
+        return 1;
+    }
+
+    FeatureLibrary& library = FeatureLibrary::instance();
+    library.set_snapshot_path(snapshot_path(opt));
+    library.set_index_path(index_path(opt));
+    library.set_float_store_path(float_store_path(opt));
+    library.set_quantized(opt.int8);
+    library.set_ann(opt.ann);
+    if (opt.scan_threads > 0) service::ScanPool::instance().resize(opt.scan_threads);
+
+    printf("kernel: %s, identities: %d x %d templates, intra %.2f (same-identity cos ~%.2f), inter %.2f\n",
+           feature_kernel_isa(), opt.identities, opt.templates, opt.intra, 1.0f / (1.0f + opt.intra * opt.intra),
+           opt.inter);
+    printf("storage: %s, ann: %s, scan threads: %d, threshold %.2f, margin %.2f\n", opt.int8 ? "int8" : "float",
+           opt.ann ? "on" : "off", service::ScanPool::instance().threads(), opt.threshold,
+           Config::Recognition::MATCH_MARGIN);
+
+    remove_files(opt);
+    if (!db::DatabaseManager::instance().open(opt.db_path)) {
+        fprintf(stderr, "cannot open %s\n", opt.db_path.c_str());
+        return 1;
+    }
+
+    // 1. 写库
+    SyntheticIdentities ids(opt);
+    std::vector<int64_t> user_ids;
+    double t0 = now_s();
+    if (!populate(opt, ids, user_ids)) {
+        fprintf(stderr, "populate failed\n");
+        db::DatabaseManager::instance().close();
+        remove_files(opt);
+        return 1;
+    }
+    double populate_s = now_s() - t0;
+
+    // 2. 加载：冷启动 (从数据库重建) 与热启动 (快照文件)
+    double rss_before = rss_mb();
+    t0 = now_s();
+    library.load_from_database();
+    double load_db_ms = (now_s() - t0) * 1e3;
+    library.flush_snapshot_file();
+    t0 = now_s();
+    library.load_from_database();
+    double load_file_ms = (now_s() - t0) * 1e3;
+    double rss_after = rss_mb();
+
+    // 3. 检索：按 RecognitionThread 的判定 (阈值 + 与第二名的差值)
+    std::mt19937 rng(opt.seed + 29);
+    std::uniform_int_distribution<int> enrolled(0, opt.identities - 1);
+    std::uniform_int_distribution<int> stranger(opt.identities, 2 * opt.identities);
+    std::bernoulli_distribution is_unknown(opt.unknown);
+    std::bernoulli_distribution is_revisit(opt.revisit);
+    std::vector<int> recent;        // 最近出现过的注册身份 (环形)
+    size_t recent_next = 0;
+    service::HotGallery hot(opt.hot ? Config::Gallery::HOT_MAX_TEMPLATES : 0);
+
+    int known = 0, correct = 0, wrong = 0, rejected = 0;
+    int unknown = 0, false_accepts = 0;
+    std::vector<double> latency_us, hot_us, full_us;
+    latency_us.reserve(opt.queries);
+    float raw[DIM];
+    std::vector<Embedding> batch(1);    // 识别线程的批量检索，每批一个查询
+    for (int q = 0; q < opt.queries; ++q) {
+        bool stranger_query = is_unknown(rng);
+        int identity = stranger_query ? stranger(rng) : enrolled(rng);
+        if (!stranger_query && !recent.empty() && is_revisit(rng)) {
+            identity = recent[std::uniform_int_distribution<size_t>(0, recent.size() - 1)(rng)];
+        } else if (!stranger_query) {
+            if (recent.size() < RECENT_IDENTITIES) recent.push_back(identity);
+            else recent[recent_next++ % RECENT_IDENTITIES] = identity;
+        }
+        ids.sample(identity, rng, raw);
+        batch[0].assign(raw);
+
+        float margin = 0.0f;
+        std::vector<service::SearchMatch> top;
+        bool from_hot = false;
+        double q0 = now_s();
+        if (opt.hot) {
+            std::vector<float> margins;
+            std::vector<bool> tiers;
+            top = std::move(hot.search_batch(batch, 2, opt.threshold, &margins, &tiers)[0]);
+            margin = margins[0];
+            from_hot = tiers[0];
+        } else {
+            top = library.search_topk(batch[0], 2, &margin);
+        }
+        double us = (now_s() - q0) * 1e6;
+        latency_us.push_back(us);
+        (from_hot ? hot_us : full_us).push_back(us);
+
+        int64_t decided = -1;
+        if (!top.empty() && top[0].similarity >= opt.threshold && margin >= Config::Recognition::MATCH_MARGIN) {
+            decided = top[0].user_id;
+            hot.touch(decided);
+        }
+
+        if (stranger_query) {
+            unknown++;
+            if (decided != -1) false_accepts++;
+        } else {
+            known++;
+            if (decided == user_ids[identity]) correct++;
+            else if (decided == -1) rejected++;
+            else wrong++;
+        }
+    }
+    std::sort(latency_us.begin(), latency_us.end());
+    std::sort(hot_us.begin(), hot_us.end());
+    std::sort(full_us.begin(), full_us.end());
+
+    printf("populate (UserDao + FaceFeatureDao): %.2f s (%.0f templates/s)\n", populate_s,
+           opt.identities * (double)opt.templates / populate_s);
+    printf("load: from database %.1f ms, from snapshot file %.1f ms\n", load_db_ms, load_file_ms);
+    printf("memory: gallery %.1f MB, process RSS %.1f -> %.1f MB, ann active: %s\n",
+           library.memory_bytes() / (1024.0 * 1024.0), rss_before, rss_after, library.ann_active() ? "yes" : "no");
+    printf("search latency us: p50 %.0f, p99 %.0f, max %.0f\n", percentile(latency_us, 0.5),
+           percentile(latency_us, 0.99), latency_us.back());
+    if (opt.hot) {
+        printf("hot tier: %zu users / %zu templates, hit rate %.1f%%\n", hot.user_count(), hot.template_count(),
+               100.0 * hot_us.size() / opt.queries);
+        if (!hot_us.empty()) {
+            printf("  hot hits  us: p50 %.0f, p99 %.0f\n", percentile(hot_us, 0.5), percentile(hot_us, 0.99));
+        }
+        if (!full_us.empty()) {
+            printf("  fall-through us: p50 %.0f, p99 %.0f\n", percentile(full_us, 0.5), percentile(full_us, 0.99));
+        }
+    }
+    int total_correct = correct + (unknown - false_accepts);
+    printf("top-1 accuracy: %.2f%% (%d queries)\n", 100.0 * total_correct / opt.queries, opt.queries);
+    if (known > 0) {
+        printf("  enrolled %d: correct %.2f%%, wrong identity %.2f%%, rejected %.2f%%\n", known,
+               100.0 * correct / known, 100.0 * wrong / known, 100.0 * rejected / known);
+    }
+    if (unknown > 0) {
+        printf("  unknown %d: false accept %.2f%%\n", unknown, 100.0 * false_accepts / unknown);
+    }
+
+    library.flush_snapshot_file();
+    db::DatabaseManager::instance().close();
+    if (!opt.keep_db) remove_files(opt);
+    return 0;
+}
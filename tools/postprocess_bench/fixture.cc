@@ -0,0 +1,395 @@
+/**
+ * @file fixture.cc
+ * @brief 后处理测试夹具实现
+ */
+
+#include "fixture.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static const char FIXTURE_MAGIC[4] = {'R', 'K', 'F', 'X'};
+static const int32_t FIXTURE_VERSION = 1;
+
+// YOLOv8-face RKOPT 输出布局
+static const int NUM_STRIDES = 3;
+static const int STRIDES[NUM_STRIDES] = {8, 16, 32};
+static const int NUM_ANCHORS = 8400;   // 80*80 + 40*40 + 20*20
+static const int DFL_CHANNELS = 65;    // 4*16 DFL + 1 conf
+
+// 合成张量的量化参数 (与板端输出量级接近)
+static const int32_t SYN_ZP = -10;
+static const float SYN_SCALE = 0.1f;
+
+// ============================================
+// 二进制读写辅助
+// ============================================
+
+template <typename T>
+static void write_pod(std::ofstream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+static bool read_pod(std::ifstream& in, T& v) {
+    in.read(reinterpret_cast<char*>(&v), sizeof(T));
+    return static_cast<bool>(in);
+}
+
+bool save_fixture(const std::string& path, const PostprocessFixture& fixture) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        printf("Open fixture %s for write failed.\n", path.c_str());
+        return false;
+    }
+
+    out.write(FIXTURE_MAGIC, sizeof(FIXTURE_MAGIC));
+    write_pod(out, FIXTURE_VERSION);
+    write_pod(out, static_cast<int32_t>(fixture.model_in_h));
+    write_pod(out, static_cast<int32_t>(fixture.model_in_w));
+    write_pod(out, static_cast<int32_t>(fixture.img_width));
+    write_pod(out, static_cast<int32_t>(fixture.img_height));
+    write_pod(out, static_cast<int32_t>(fixture.attrs.size()));
+
+    for (size_t i = 0; i < fixture.attrs.size(); ++i) {
+        const rknn_tensor_attr& attr = fixture.attrs[i];
+        write_pod(out, static_cast<uint32_t>(attr.index));
+        write_pod(out, static_cast<uint32_t>(attr.n_dims));
+        for (int d = 0; d < 4; ++d) {
+            write_pod(out, static_cast<uint32_t>(attr.dims[d]));
+        }
+        write_pod(out, static_cast<uint32_t>(attr.n_elems));
+        write_pod(out, static_cast<uint32_t>(attr.size));
+        write_pod(out, static_cast<int32_t>(attr.fmt));
+        write_pod(out, static_cast<int32_t>(attr.type));
+        write_pod(out, static_cast<int32_t>(attr.qnt_type));
+        write_pod(out, static_cast<int32_t>(attr.zp));
+        write_pod(out, static_cast<float>(attr.scale));
+
+        const std::vector<uint8_t>& buf = fixture.buffers[i];
+        write_pod(out, static_cast<uint32_t>(buf.size()));
+        out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+    }
+    return static_cast<bool>(out);
+}
+
+bool load_fixture(const std::string& path, PostprocessFixture& fixture) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        printf("Open fixture %s failed.\n", path.c_str());
+        return false;
+    }
+
+    char magic[4];
+    in.read(magic, sizeof(magic));
+    int32_t version = 0;
+    if (!in || memcmp(magic, FIXTURE_MAGIC, sizeof(magic)) != 0 || !read_pod(in, version) ||
+        version != FIXTURE_VERSION) {
+        printf("Fixture %s: bad header.\n", path.c_str());
+        return false;
+    }
+
+    int32_t model_in_h, model_in_w, img_width, img_height, n_output;
+    if (!read_pod(in, model_in_h) || !read_pod(in, model_in_w) ||
+        !read_pod(in, img_width) || !read_pod(in, img_height) || !read_pod(in, n_output) ||
+        n_output < 0 || n_output > 16) {
+        printf("Fixture %s: bad header.\n", path.c_str());
+        return false;
+    }
+    fixture.model_in_h = model_in_h;
+    fixture.model_in_w = model_in_w;
+    fixture.img_width = img_width;
+    fixture.img_height = img_height;
+    fixture.attrs.assign(n_output, rknn_tensor_attr());
+    fixture.buffers.assign(n_output, std::vector<uint8_t>());
+
+    for (int i = 0; i < n_output; ++i) {
+        rknn_tensor_attr& attr = fixture.attrs[i];
+        memset(&attr, 0, sizeof(attr));
+
+        uint32_t u32;
+        int32_t i32;
+        float f32;
+        bool ok = read_pod(in, u32); attr.index = u32;
+        ok = ok && read_pod(in, u32); attr.n_dims = u32;
+        for (int d = 0; d < 4; ++d) {
+            ok = ok && read_pod(in, u32); attr.dims[d] = u32;
+        }
+        ok = ok && read_pod(in, u32); attr.n_elems = u32;
+        ok = ok && read_pod(in, u32); attr.size = u32;
+        ok = ok && read_pod(in, i32); attr.fmt = static_cast<rknn_tensor_format>(i32);
+        ok = ok && read_pod(in, i32); attr.type = static_cast<rknn_tensor_type>(i32);
+        ok = ok && read_pod(in, i32); attr.qnt_type = static_cast<rknn_tensor_qnt_type>(i32);
+        ok = ok && read_pod(in, i32); attr.zp = i32;
+        ok = ok && read_pod(in, f32); attr.scale = f32;
+
+        uint32_t buf_size = 0;
+        ok = ok && read_pod(in, buf_size);
+        if (!ok) {
+            printf("Fixture %s: truncated attr %d.\n", path.c_str(), i);
+            return false;
+        }
+        fixture.buffers[i].resize(buf_size);
+        in.read(reinterpret_cast<char*>(fixture.buffers[i].data()), buf_size);
+        if (!in) {
+            printf("Fixture %s: truncated tensor %d.\n", path.c_str(), i);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool save_golden(const std::string& path, const std::vector<GoldenFace>& faces) {
+    FILE* fp = fopen(path.c_str(), "w");
+    if (!fp) {
+        printf("Open golden %s for write failed.\n", path.c_str());
+        return false;
+    }
+    fprintf(fp, "# left top right bottom prop p1x p1y p2x p2y p3x p3y p4x p4y p5x p5y\n");
+    for (const auto& f : faces) {
+        fprintf(fp, "%d %d %d %d %.6f %d %d %d %d %d %d %d %d %d %d\n",
+                f.box.left, f.box.top, f.box.right, f.box.bottom, f.prop,
+                f.point.point_1_x, f.point.point_1_y, f.point.point_2_x, f.point.point_2_y,
+                f.point.point_3_x, f.point.point_3_y, f.point.point_4_x, f.point.point_4_y,
+                f.point.point_5_x, f.point.point_5_y);
+    }
+    fclose(fp);
+    return true;
+}
+
+bool load_golden(const std::string& path, std::vector<GoldenFace>& faces) {
+    std::ifstream in(path);
+    if (!in) {
+        printf("Open golden %s failed.\n", path.c_str());
+        return false;
+    }
+    faces.clear();
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        GoldenFace f;
+        ss >> f.box.left >> f.box.top >> f.box.right >> f.box.bottom >> f.prop
+           >> f.point.point_1_x >> f.point.point_1_y >> f.point.point_2_x >> f.point.point_2_y
+           >> f.point.point_3_x >> f.point.point_3_y >> f.point.point_4_x >> f.point.point_4_y
+           >> f.point.point_5_x >> f.point.point_5_y;
+        if (!ss) {
+            printf("Golden %s: bad line: %s\n", path.c_str(), line.c_str());
+            return false;
+        }
+        faces.push_back(f);
+    }
+    return true;
+}
+
+// ============================================
+// 合成场景
+// ============================================
+
+// 人脸描述：所在特征图、网格坐标、四边 DFL 距离 (网格单位)
+struct SynFace {
+    int stride_idx;
+    int gx, gy;
+    int dl, dt, dr, db;
+};
+
+// 少量人脸的手工布局 (覆盖三个 stride，互不重叠)
+static const SynFace HAND_FACES[] = {
+    {2, 10, 9, 3, 4, 3, 4},    // stride 32: 大脸
+    {0, 8, 8, 4, 5, 4, 5},     // stride 8: 小脸
+    {1, 34, 6, 3, 3, 3, 4},    // stride 16
+    {0, 70, 66, 4, 5, 4, 5},   // stride 8
+    {1, 6, 32, 2, 3, 2, 3},    // stride 16
+};
+static const int NUM_HAND_FACES = sizeof(HAND_FACES) / sizeof(HAND_FACES[0]);
+
+// 五个关键点在框内的相对位置 (左眼、右眼、鼻子、左嘴角、右嘴角)
+static const float KPT_REL[5][2] = {
+    {0.30f, 0.35f}, {0.70f, 0.35f}, {0.50f, 0.55f}, {0.35f, 0.75f}, {0.65f, 0.75f}
+};
+
+static int8_t quantize(float v) {
+    float q = roundf(v / SYN_SCALE) + SYN_ZP;
+    q = std::max(-128.0f, std::min(127.0f, q));
+    return static_cast<int8_t>(q);
+}
+
+static float dequantize(int8_t q) {
+    return (static_cast<float>(q) - SYN_ZP) * SYN_SCALE;
+}
+
+static int anchor_offset(int stride_idx) {
+    int offset = 0;
+    for (int i = 0; i < stride_idx; ++i) {
+        int grid = 640 / STRIDES[i];
+        offset += grid * grid;
+    }
+    return offset;
+}
+
+// 与 postprocess.cc 中 clamp 相同的截断语义 (返回 int)
+static int clamp_like_impl(float val, int min, int max) {
+    return val > min ? (val < max ? val : max) : min;
+}
+
+// 写入一个候选框: 置信度 logit + 四边 DFL (目标 bin 取大 logit，其余取小 logit)
+static void write_candidate(std::vector<uint8_t>& buf, int grid, int gx, int gy,
+                            const int dist[4], float conf_logit) {
+    int8_t* data = reinterpret_cast<int8_t*>(buf.data());
+    int plane = grid * grid;
+    int offset = gy * grid + gx;
+    for (int side = 0; side < 4; ++side) {
+        for (int bin = 0; bin < DFL_LEN; ++bin) {
+            data[(side * DFL_LEN + bin) * plane + offset] = quantize(bin == dist[side] ? 7.0f : -5.0f);
+        }
+    }
+    data[64 * plane + offset] = quantize(conf_logit);
+}
+
+void make_synthetic_scene(int num_faces, PostprocessFixture& fixture, std::vector<GoldenFace>& golden) {
+    fixture = PostprocessFixture();
+    golden.clear();
+
+    // 1. 构造人脸布局
+    std::vector<SynFace> faces;
+    if (num_faces <= NUM_HAND_FACES) {
+        faces.assign(HAND_FACES, HAND_FACES + num_faces);
+    } else {
+        // 网格布局 (stride 16，每个框 64x80，间距足够避免 NMS 互相抑制)
+        for (int i = 0; i < num_faces; ++i) {
+            SynFace f = {1, 3 + (i % 6) * 6, 3 + (i / 6) * 7, 2, 2, 2, 3};
+            faces.push_back(f);
+        }
+    }
+
+    // 2. 分配张量
+    for (int s = 0; s < NUM_STRIDES; ++s) {
+        int grid = fixture.model_in_w / STRIDES[s];
+        rknn_tensor_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.index = s;
+        attr.n_dims = 4;
+        attr.dims[0] = 1;
+        attr.dims[1] = DFL_CHANNELS;
+        attr.dims[2] = grid;
+        attr.dims[3] = grid;
+        attr.n_elems = DFL_CHANNELS * grid * grid;
+        attr.size = attr.n_elems;
+        attr.fmt = RKNN_TENSOR_NCHW;
+        attr.type = RKNN_TENSOR_INT8;
+        attr.qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+        attr.zp = SYN_ZP;
+        attr.scale = SYN_SCALE;
+        fixture.attrs.push_back(attr);
+
+        // 背景: DFL 取小 logit，置信度取 -10 (sigmoid ≈ 0)
+        std::vector<uint8_t> buf(attr.size, static_cast<uint8_t>(quantize(-5.0f)));
+        int8_t* data = reinterpret_cast<int8_t*>(buf.data());
+        for (int i = 0; i < grid * grid; ++i) {
+            data[64 * grid * grid + i] = quantize(-10.0f);
+        }
+        fixture.buffers.push_back(buf);
+    }
+
+    rknn_tensor_attr kpt_attr;
+    memset(&kpt_attr, 0, sizeof(kpt_attr));
+    kpt_attr.index = 3;
+    kpt_attr.n_dims = 4;
+    kpt_attr.dims[0] = 1;
+    kpt_attr.dims[1] = 5;
+    kpt_attr.dims[2] = 3;
+    kpt_attr.dims[3] = NUM_ANCHORS;
+    kpt_attr.n_elems = 5 * 3 * NUM_ANCHORS;
+    kpt_attr.size = kpt_attr.n_elems * sizeof(float);
+    kpt_attr.fmt = RKNN_TENSOR_NCHW;
+    kpt_attr.type = RKNN_TENSOR_FLOAT32;
+    kpt_attr.qnt_type = RKNN_TENSOR_QNT_NONE;
+    kpt_attr.scale = 1.0f;
+    fixture.attrs.push_back(kpt_attr);
+    fixture.buffers.push_back(std::vector<uint8_t>(kpt_attr.size, 0));
+    float* kpt = reinterpret_cast<float*>(fixture.buffers[3].data());
+
+    float scale_w = static_cast<float>(fixture.model_in_w) / fixture.img_width;
+    float scale_h = static_cast<float>(fixture.model_in_h) / fixture.img_height;
+
+    // 3. 写入每个人脸 (置信度互不相同，保证排序确定)
+    for (size_t i = 0; i < faces.size(); ++i) {
+        const SynFace& f = faces[i];
+        int stride = STRIDES[f.stride_idx];
+        int grid = fixture.model_in_w / stride;
+        float conf_logit = 1.0f + 0.1f * static_cast<float>(i);
+
+        int dist[4] = {f.dl, f.dt, f.dr, f.db};
+        write_candidate(fixture.buffers[f.stride_idx], grid, f.gx, f.gy, dist, conf_logit);
+
+        // 右侧相邻格子放一个完全重合、置信度更低的候选框，应被 NMS 抑制
+        int dup_dist[4] = {f.dl + 1, f.dt, f.dr - 1, f.db};
+        write_candidate(fixture.buffers[f.stride_idx], grid, f.gx + 1, f.gy, dup_dist, conf_logit - 0.5f);
+
+        float x1 = (f.gx + 0.5f - f.dl) * stride;
+        float y1 = (f.gy + 0.5f - f.dt) * stride;
+        float x2 = (f.gx + 0.5f + f.dr) * stride;
+        float y2 = (f.gy + 0.5f + f.db) * stride;
+        float bw = x2 - x1;
+        float bh = y2 - y1;
+
+        // 关键点 (取 .25 偏移，避免截断边界)
+        int kpt_index = anchor_offset(f.stride_idx) + f.gy * grid + f.gx;
+        int kpt_xy[5][2];
+        for (int k = 0; k < 5; ++k) {
+            float kx = x1 + KPT_REL[k][0] * bw + 0.25f;
+            float ky = y1 + KPT_REL[k][1] * bh + 0.25f;
+            kpt[k * 3 * NUM_ANCHORS + 0 * NUM_ANCHORS + kpt_index] = kx;
+            kpt[k * 3 * NUM_ANCHORS + 1 * NUM_ANCHORS + kpt_index] = ky;
+            kpt[k * 3 * NUM_ANCHORS + 2 * NUM_ANCHORS + kpt_index] = 1.0f;
+            kpt_xy[k][0] = (int)(clamp_like_impl(kx, 0, fixture.model_in_w) / scale_w);
+            kpt_xy[k][1] = (int)(clamp_like_impl(ky, 0, fixture.model_in_h) / scale_h);
+        }
+
+        GoldenFace g;
+        g.box.left   = (int)(clamp_like_impl(x1, 0, fixture.model_in_w) / scale_w);
+        g.box.top    = (int)(clamp_like_impl(y1, 0, fixture.model_in_h) / scale_h);
+        g.box.right  = (int)(clamp_like_impl(x2, 0, fixture.model_in_w) / scale_w);
+        g.box.bottom = (int)(clamp_like_impl(y2, 0, fixture.model_in_h) / scale_h);
+        g.prop = 1.0f / (1.0f + expf(-dequantize(quantize(conf_logit))));
+        g.point.point_1_x = kpt_xy[0][0];
+        g.point.point_1_y = kpt_xy[0][1];
+        g.point.point_2_x = kpt_xy[1][0];
+        g.point.point_2_y = kpt_xy[1][1];
+        g.point.point_3_x = kpt_xy[2][0];
+        g.point.point_3_y = kpt_xy[2][1];
+        g.point.point_4_x = kpt_xy[3][0];
+        g.point.point_4_y = kpt_xy[3][1];
+        g.point.point_5_x = kpt_xy[4][0];
+        g.point.point_5_y = kpt_xy[4][1];
+        golden.push_back(g);
+    }
+
+    // 输出按置信度降序
+    std::sort(golden.begin(), golden.end(),
+              [](const GoldenFace& a, const GoldenFace& b) { return a.prop > b.prop; });
+}
+
+int run_postprocess(const PostprocessFixture& fixture, float conf_threshold, float nms_threshold,
+                    detect_result_group_t* group) {
+    int n_output = static_cast<int>(fixture.attrs.size());
+    std::vector<rknn_output> outputs(n_output);
+    memset(outputs.data(), 0, sizeof(rknn_output) * n_output);
+    for (int i = 0; i < n_output; ++i) {
+        outputs[i].is_prealloc = 1;
+        outputs[i].want_float = 0;
+        outputs[i].buf = const_cast<uint8_t*>(fixture.buffers[i].data());
+        outputs[i].size = fixture.buffers[i].size();
+    }
+
+    float scale_w = static_cast<float>(fixture.model_in_w) / fixture.img_width;
+    float scale_h = static_cast<float>(fixture.model_in_h) / fixture.img_height;
+
+    return post_process_yolov8_face(outputs.data(), const_cast<rknn_tensor_attr*>(fixture.attrs.data()),
+                                    n_output, fixture.model_in_h, fixture.model_in_w,
+                                    conf_threshold, nms_threshold, scale_w, scale_h, group);
+}
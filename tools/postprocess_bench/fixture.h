@@ -0,0 +1,65 @@
+/**
+ * @file fixture.h
+ * @brief 后处理测试夹具 (Fixture) 读写与合成场景生成
+ * @details 夹具文件保存一帧 YOLOv8-face 的 4 个 RKNN 输出张量及其 rknn_tensor_attr，
+ *          Golden 文件保存该帧期望的检测框/关键点 (文本格式，便于 diff)。
+ */
+
+#ifndef POSTPROCESS_BENCH_FIXTURE_H
+#define POSTPROCESS_BENCH_FIXTURE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "rknn_api.h"
+#include "core/postprocess.h"
+
+// 一帧后处理输入
+struct PostprocessFixture {
+    int model_in_h = 640;
+    int model_in_w = 640;
+    int img_width = 1280;              // 原图宽 (用于坐标还原)
+    int img_height = 720;              // 原图高
+    std::vector<rknn_tensor_attr> attrs;
+    std::vector<std::vector<uint8_t>> buffers;
+};
+
+// 一个期望检测结果
+struct GoldenFace {
+    BOX_RECT box;
+    KEY_POINT point;
+    float prop;
+};
+
+/**
+ * @brief 保存/读取夹具 (二进制，小端)
+ * @details 格式: "RKFX" | version | model_in_h | model_in_w | img_width | img_height | n_output
+ *          然后每个输出: attr 关键字段 + 数据长度 + 原始数据
+ */
+bool save_fixture(const std::string& path, const PostprocessFixture& fixture);
+bool load_fixture(const std::string& path, PostprocessFixture& fixture);
+
+/**
+ * @brief 保存/读取 Golden 结果 (文本，每行一个人脸)
+ * @details 行格式: left top right bottom prop p1x p1y p2x p2y p3x p3y p4x p4y p5x p5y
+ */
+bool save_golden(const std::string& path, const std::vector<GoldenFace>& faces);
+bool load_golden(const std::string& path, std::vector<GoldenFace>& faces);
+
+/**
+ * @brief 生成合成场景
+ * @details 按 RKOPT 格式构造 int8 DFL/置信度张量与 float 关键点张量，
+ *          每个人脸旁附带一个重复候选框用于覆盖 NMS 路径。
+ *          Golden 由构造参数解析计算得到，不依赖被测实现。
+ * @param num_faces 人脸数量 (0 ~ 30)
+ */
+void make_synthetic_scene(int num_faces, PostprocessFixture& fixture, std::vector<GoldenFace>& golden);
+
+/**
+ * @brief 对夹具执行 post_process_yolov8_face
+ * @details 与 yolov8_face_postprocess 相同的坐标缩放逻辑，但不依赖 librknnrt
+ */
+int run_postprocess(const PostprocessFixture& fixture, float conf_threshold, float nms_threshold,
+                    detect_result_group_t* group);
+
+#endif // POSTPROCESS_BENCH_FIXTURE_H
@@ -0,0 +1,550 @@
+/**
+ * @file postprocess_bench.cc
+ * @brief 后处理核心的 Golden 测试与微基准
+ * @details 覆盖 post_process_yolov8_face / similar_transform_5pt / align_face / l2_normalize / cos_similarity。
+ *          在 PC (x86) 上运行，不需要 librknnrt 与 NPU。
+ */
+
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fixture.h"
+#include "core/postprocess.h"
+#include "core/face_tracker.h"
+#include "app/identity_cache.h"
+#include "service/feature_library.h"
+#include "config.h"
+
+static const int SCENE_FACES[] = {0, 1, 5, 30};
+static const int BOX_TOLERANCE = 2;        // 像素 (缩放回原图后 1 个模型像素 = 2 个原图像素)
+static const float PROP_TOLERANCE = 1e-3f;
+
+// ArcFace 112x112 模板关键点
+static const float ARCFACE_DST[5][2] = {
+    {38.2946f, 51.6963f}, {73.5318f, 51.5014f}, {56.0252f, 71.7366f},
+    {41.5493f, 92.3655f}, {70.7299f, 92.2041f}
+};
+
+void print_usage() {
+    printf("Usage:\n");
+    printf("  postprocess_bench gen <fixture_dir>      生成 0/1/5/30 人脸的合成夹具与 Golden\n");
+    printf("  postprocess_bench check <fixture_dir>    校验目录下所有 *.fixture 与对应 *.golden\n");
+    printf("  postprocess_bench record <fixture_file>  用当前实现为板端录制的夹具生成 Golden\n");
+    printf("  postprocess_bench bench <fixture_dir>    运行微基准\n");
+    printf("  postprocess_bench test <fixture_dir>     gen (若缺失) + check，供 ctest 调用\n");
+}
+
+static std::string scene_name(int num_faces) {
+    char name[64];
+    snprintf(name, sizeof(name), "scene_%dfaces", num_faces);
+    return name;
+}
+
+static std::string replace_ext(const std::string& path, const std::string& ext) {
+    size_t dot = path.rfind('.');
+    return (dot == std::string::npos ? path : path.substr(0, dot)) + ext;
+}
+
+static bool file_exists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+static std::vector<std::string> list_fixtures(const std::string& dir) {
+    std::vector<std::string> files;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return files;
+    struct dirent* ent;
+    while ((ent = readdir(d)) != nullptr) {
+        std::string name = ent->d_name;
+        if (name.size() > 8 && name.compare(name.size() - 8, 8, ".fixture") == 0) {
+            files.push_back(dir + "/" + name);
+        }
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static std::vector<GoldenFace> to_golden(const detect_result_group_t& group) {
+    std::vector<GoldenFace> faces;
+    for (int i = 0; i < group.count; ++i) {
+        GoldenFace f;
+        f.box = group.results[i].box;
+        f.point = group.results[i].point;
+        f.prop = group.results[i].prop;
+        faces.push_back(f);
+    }
+    return faces;
+}
+
+// ============================================
+// gen / record
+// ============================================
+
+static int cmd_gen(const std::string& dir) {
+    mkdir(dir.c_str(), 0755);
+    for (int n : SCENE_FACES) {
+        PostprocessFixture fixture;
+        std::vector<GoldenFace> golden;
+        make_synthetic_scene(n, fixture, golden);
+        std::string base = dir + "/" + scene_name(n);
+        if (!save_fixture(base + ".fixture", fixture) || !save_golden(base + ".golden", golden)) {
+            return 1;
+        }
+        printf("Generated %s (%zu faces)\n", base.c_str(), golden.size());
+    }
+    return 0;
+}
+
+static int cmd_record(const std::string& fixture_path) {
+    PostprocessFixture fixture;
+    if (!load_fixture(fixture_path, fixture)) return 1;
+
+    detect_result_group_t group;
+    if (run_postprocess(fixture, BOX_THRESH, NMS_THRESH, &group) != 0) {
+        printf("post_process_yolov8_face failed on %s\n", fixture_path.c_str());
+        return 1;
+    }
+    std::string golden_path = replace_ext(fixture_path, ".golden");
+    if (!save_golden(golden_path, to_golden(group))) return 1;
+    printf("Recorded %s (%d faces)\n", golden_path.c_str(), group.count);
+    return 0;
+}
+
+// ============================================
+// check
+// ============================================
+
+static bool near_int(int a, int b, int tol) {
+    return abs(a - b) <= tol;
+}
+
+static bool compare_face(const GoldenFace& got, const GoldenFace& want) {
+    const int* g_box = &got.box.left;
+    const int* w_box = &want.box.left;
+    for (int i = 0; i < 4; ++i) {
+        if (!near_int(g_box[i], w_box[i], BOX_TOLERANCE)) return false;
+    }
+    const int* g_pt = &got.point.point_1_x;
+    const int* w_pt = &want.point.point_1_x;
+    for (int i = 0; i < 10; ++i) {
+        if (!near_int(g_pt[i], w_pt[i], BOX_TOLERANCE)) return false;
+    }
+    return fabsf(got.prop - want.prop) <= PROP_TOLERANCE;
+}
+
+static void print_face(const char* tag, const GoldenFace& f) {
+    printf("    %s box=[%d,%d,%d,%d] prop=%.4f kpt0=(%d,%d)\n", tag,
+           f.box.left, f.box.top, f.box.right, f.box.bottom, f.prop,
+           f.point.point_1_x, f.point.point_1_y);
+}
+
+static bool check_fixture(const std::string& fixture_path) {
+    PostprocessFixture fixture;
+    std::vector<GoldenFace> golden;
+    std::string golden_path = replace_ext(fixture_path, ".golden");
+    if (!load_fixture(fixture_path, fixture) || !load_golden(golden_path, golden)) {
+        return false;
+    }
+
+    detect_result_group_t group;
+    if (run_postprocess(fixture, BOX_THRESH, NMS_THRESH, &group) != 0) {
+        printf("[FAIL] %s: post_process_yolov8_face returned error\n", fixture_path.c_str());
+        return false;
+    }
+    std::vector<GoldenFace> got = to_golden(group);
+
+    if (got.size() != golden.size()) {
+        printf("[FAIL] %s: expected %zu faces, got %zu\n", fixture_path.c_str(), golden.size(), got.size());
+        return false;
+    }
+    for (size_t i = 0; i < got.size(); ++i) {
+        if (!compare_face(got[i], golden[i])) {
+            printf("[FAIL] %s: face %zu mismatch\n", fixture_path.c_str(), i);
+            print_face("want", golden[i]);
+            print_face("got ", got[i]);
+            return false;
+        }
+    }
+    printf("[ OK ] %s (%zu faces)\n", fixture_path.c_str(), got.size());
+    return true;
+}
+
+static bool check_l2_normalize() {
+    std::mt19937 rng(42);
+    std::normal_distribution<float> dist(0.0f, 3.0f);
+    std::vector<float> v(FACENET_FEATURE_DIM), ref(FACENET_FEATURE_DIM);
+    for (int i = 0; i < FACENET_FEATURE_DIM; ++i) ref[i] = v[i] = dist(rng);
+
+    l2_normalize(v.data());
+
+    double norm = 0.0, ref_norm = 0.0;
+    for (int i = 0; i < FACENET_FEATURE_DIM; ++i) {
+        norm += (double)v[i] * v[i];
+        ref_norm += (double)ref[i] * ref[i];
+    }
+    ref_norm = sqrt(ref_norm);
+    for (int i = 0; i < FACENET_FEATURE_DIM; ++i) {
+        if (fabs(v[i] - ref[i] / ref_norm) > 1e-5) {
+            printf("[FAIL] l2_normalize: element %d = %f, want %f\n", i, v[i], ref[i] / ref_norm);
+            return false;
+        }
+    }
+    if (fabs(sqrt(norm) - 1.0) > 1e-4) {
+        printf("[FAIL] l2_normalize: norm = %f\n", sqrt(norm));
+        return false;
+    }
+    printf("[ OK ] l2_normalize\n");
+    return true;
+}
+
+static bool check_cos_similarity() {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> a(FACENET_FEATURE_DIM), b(FACENET_FEATURE_DIM);
+    for (int i = 0; i < FACENET_FEATURE_DIM; ++i) {
+        a[i] = dist(rng);
+        b[i] = 0.6f * a[i] + 0.4f * dist(rng);
+    }
+
+    double dot = 0.0, na = 0.0, nb = 0.0;
+    for (int i = 0; i < FACENET_FEATURE_DIM; ++i) {
+        dot += (double)a[i] * b[i];
+        na += (double)a[i] * a[i];
+        nb += (double)b[i] * b[i];
+    }
+    double ref = dot / (sqrt(na) * sqrt(nb));
+
+    float got = cos_similarity(a.data(), b.data());
+    float self = cos_similarity(a.data(), a.data());
+    if (fabs(got - ref) > 1e-5 || fabs(self - 1.0f) > 1e-5) {
+        printf("[FAIL] cos_similarity: got %f (want %f), self %f\n", got, ref, self);
+        return false;
+    }
+    printf("[ OK ] cos_similarity\n");
+    return true;
+}
+
+// 已知相似变换 dst = s*R*src + t，检查求解结果 (闭式解与兼容接口各验证一次)
+static bool check_similar_transform_case(float s, float theta, float tx, float ty) {
+    float c = cosf(theta), sn = sinf(theta);
+    float src_pts[10], dst_pts[10];
+    cv::Mat src(5, 2, CV_32F), dst(5, 2, CV_32F);
+    for (int i = 0; i < 5; ++i) {
+        float dx = ARCFACE_DST[i][0] - tx;
+        float dy = ARCFACE_DST[i][1] - ty;
+        // src = R^T (dst - t) / s
+        src_pts[2 * i] = (c * dx + sn * dy) / s;
+        src_pts[2 * i + 1] = (-sn * dx + c * dy) / s;
+        dst_pts[2 * i] = ARCFACE_DST[i][0];
+        dst_pts[2 * i + 1] = ARCFACE_DST[i][1];
+        src.at<float>(i, 0) = src_pts[2 * i];
+        src.at<float>(i, 1) = src_pts[2 * i + 1];
+        dst.at<float>(i, 0) = dst_pts[2 * i];
+        dst.at<float>(i, 1) = dst_pts[2 * i + 1];
+    }
+
+    float m[6];
+    similar_transform_5pt(src_pts, dst_pts, m);
+    cv::Mat T = similarTransform(src, dst);
+
+    const float want[2][3] = {{s * c, -s * sn, tx}, {s * sn, s * c, ty}};
+    for (int r = 0; r < 2; ++r) {
+        for (int col = 0; col < 3; ++col) {
+            float tol = (col == 2) ? 1e-2f : 1e-4f;
+            float got = m[r * 3 + col];
+            if (fabsf(got - want[r][col]) > tol) {
+                printf("[FAIL] similar_transform_5pt(s=%.2f, theta=%.2f): M(%d,%d) = %f, want %f\n",
+                       s, theta, r, col, got, want[r][col]);
+                return false;
+            }
+            got = T.at<float>(r, col);
+            if (fabsf(got - want[r][col]) > tol) {
+                printf("[FAIL] similarTransform(s=%.2f, theta=%.2f): T(%d,%d) = %f, want %f\n",
+                       s, theta, r, col, got, want[r][col]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool check_similar_transform() {
+    bool ok = check_similar_transform_case(0.45f, 0.0f, -20.0f, -35.0f) &&
+              check_similar_transform_case(0.40f, 0.2f, 12.0f, -7.0f) &&
+              check_similar_transform_case(1.30f, -0.6f, 30.0f, 5.0f) &&
+              check_similar_transform_case(0.25f, 3.0f, 80.0f, 140.0f);
+    if (ok) printf("[ OK ] similarTransform\n");
+    return ok;
+}
+
+// 两个匀速运动的人脸 (中途一个短暂漏检)，检查 ID 稳定、状态流转正确
+static bool check_face_tracker() {
+    FaceTracker tracker;
+    int id_a = -1, id_b = -1;
+    for (int frame = 0; frame < 30; ++frame) {
+        detect_result_group_t group;
+        memset(&group, 0, sizeof(group));
+        bool b_visible = frame < 10 || frame >= 14;  // 第 10~13 帧漏检 B
+
+        detect_result_t& a = group.results[group.count++];
+        a.box = {100 + frame * 6, 180 + frame * 6, 100, 200};
+        if (b_visible) {
+            detect_result_t& b = group.results[group.count++];
+            b.box = {800 - frame * 4, 860 - frame * 4, 300 + frame * 2, 380 + frame * 2};
+        }
+
+        tracker.update(&group);
+
+        if (frame == 0) {
+            id_a = group.results[0].track_id;
+            id_b = group.results[1].track_id;
+            if (id_a == id_b || group.results[0].track_state != TRACK_NEW) {
+                printf("[FAIL] FaceTracker: bad initial tracks (%d, %d)\n", id_a, id_b);
+                return false;
+            }
+            continue;
+        }
+        if (group.results[0].track_id != id_a || (b_visible && group.results[1].track_id != id_b)) {
+            printf("[FAIL] FaceTracker: id switch at frame %d\n", frame);
+            return false;
+        }
+        if (frame >= Config::Tracker::CONFIRM_HITS && group.results[0].track_state != TRACK_CONFIRMED) {
+            printf("[FAIL] FaceTracker: track not confirmed at frame %d\n", frame);
+            return false;
+        }
+        if (!b_visible) {
+            bool lost = false;
+            for (const auto& t : tracker.tracks()) {
+                if (t.id == id_b) lost = (t.state == TRACK_LOST);
+            }
+            if (!lost) {
+                printf("[FAIL] FaceTracker: missing face not in LOST state at frame %d\n", frame);
+                return false;
+            }
+        }
+    }
+
+    // 全部消失后超过 MAX_LOST_FRAMES 帧应被删除
+    for (int frame = 0; frame <= Config::Tracker::MAX_LOST_FRAMES; ++frame) {
+        detect_result_group_t group;
+        memset(&group, 0, sizeof(group));
+        tracker.update(&group);
+    }
+    if (!tracker.tracks().empty()) {
+        printf("[FAIL] FaceTracker: %zu track(s) not removed\n", tracker.tracks().size());
+        return false;
+    }
+    printf("[ OK ] FaceTracker\n");
+    return true;
+}
+
+// 已锁定的轨迹在特征库变更 (注册其他用户) 后复核：仍是同一用户时保持锁定，且不再报告"刚锁定"
+static bool check_identity_cache() {
+    service::FeatureLibrary& library = service::FeatureLibrary::instance();
+    library.load_from_database(); // 未打开数据库时只清空内存
+
+    db::User user;
+    user.user_id = 1;
+    user.user_name = "user_1";
+    Embedding feature(std::vector<float>(Config::Model::FEATURE_DIM, 1.0f));
+    library.add_user(user, feature);
+
+    IdentityCache cache;
+    detect_result_t face;
+    memset(&face, 0, sizeof(face));
+    face.track_id = 7;
+    face.quality = 0.8f;
+    auto now = std::chrono::steady_clock::now();
+    float similarity = Config::Recognition::CONFIDENT_SIMILARITY;
+
+    bool ok = cache.need_recognition(face, now);
+    cache.begin_recognition(face.track_id);
+    ok = ok && cache.update(face, user.user_id, user.user_name, similarity, feature, now);
+    ok = ok && !cache.need_recognition(face, now);
+    if (!ok) {
+        printf("[FAIL] IdentityCache: track not locked on first confident match\n");
+        return false;
+    }
+
+    db::User other = user;
+    other.user_id = 2;
+    other.user_name = "user_2";
+    library.add_user(other, Embedding(std::vector<float>(Config::Model::FEATURE_DIM, -1.0f)));
+    if (!cache.need_recognition(face, now) || !cache.is_locked(face.track_id)) {
+        printf("[FAIL] IdentityCache: library change must re-verify without unlocking\n");
+        return false;
+    }
+    cache.begin_recognition(face.track_id);
+    if (cache.update(face, user.user_id, user.user_name, similarity, feature, now)) {
+        printf("[FAIL] IdentityCache: re-verified identity reported as newly confirmed\n");
+        return false;
+    }
+    if (!cache.is_locked(face.track_id) || cache.need_recognition(face, now)) {
+        printf("[FAIL] IdentityCache: track not locked after re-verification\n");
+        return false;
+    }
+
+    library.load_from_database();
+    printf("[ OK ] IdentityCache\n");
+    return true;
+}
+
+static int cmd_check(const std::string& dir) {
+    int failed = 0;
+    std::vector<std::string> fixtures = list_fixtures(dir);
+    if (fixtures.empty()) {
+        printf("[FAIL] no *.fixture found in %s\n", dir.c_str());
+        failed++;
+    }
+    for (const auto& f : fixtures) {
+        if (!check_fixture(f)) failed++;
+    }
+    if (!check_l2_normalize()) failed++;
+    if (!check_cos_similarity()) failed++;
+    if (!check_similar_transform()) failed++;
+    if (!check_face_tracker()) failed++;
+    if (!check_identity_cache()) failed++;
+
+    printf("%s: %d failure(s)\n", failed ? "FAILED" : "PASSED", failed);
+    return failed ? 1 : 0;
+}
+
+static int cmd_test(const std::string& dir) {
+    if (!file_exists(dir + "/" + scene_name(SCENE_FACES[0]) + ".fixture")) {
+        if (cmd_gen(dir) != 0) return 1;
+    }
+    return cmd_check(dir);
+}
+
+// ============================================
+// bench (输出格式参照 Google Benchmark)
+// ============================================
+
+static const double MIN_BENCH_TIME_S = 0.5;
+
+static void do_not_optimize(const void* p) {
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+static double now_s(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+template <typename Fn>
+static void run_benchmark(const std::string& name, Fn&& fn) {
+    fn();  // 预热
+    long iters = 1;
+    while (true) {
+        double w0 = now_s(CLOCK_MONOTONIC);
+        double c0 = now_s(CLOCK_THREAD_CPUTIME_ID);
+        for (long i = 0; i < iters; ++i) fn();
+        double wall = now_s(CLOCK_MONOTONIC) - w0;
+        double cpu = now_s(CLOCK_THREAD_CPUTIME_ID) - c0;
+        if (wall >= MIN_BENCH_TIME_S || iters >= (1L << 30)) {
+            printf("%-36s %12.0f ns %12.0f ns %12ld\n", name.c_str(),
+                   wall * 1e9 / iters, cpu * 1e9 / iters, iters);
+            return;
+        }
+        iters *= (wall < MIN_BENCH_TIME_S / 10) ? 10 : 2;
+    }
+}
+
+static int cmd_bench(const std::string& dir) {
+    printf("%-36s %15s %15s %12s\n", "Benchmark", "Time", "CPU", "Iterations");
+    printf("------------------------------------------------------------------------------\n");
+
+    for (int n : SCENE_FACES) {
+        PostprocessFixture fixture;
+        std::string path = dir + "/" + scene_name(n) + ".fixture";
+        if (!load_fixture(path, fixture)) {
+            std::vector<GoldenFace> unused;
+            make_synthetic_scene(n, fixture, unused);
+        }
+        detect_result_group_t group;
+        run_benchmark("BM_PostProcessYolov8Face/faces:" + std::to_string(n), [&]() {
+            run_postprocess(fixture, BOX_THRESH, NMS_THRESH, &group);
+            do_not_optimize(&group);
+        });
+    }
+
+    float src_pts[10], dst_pts[10];
+    for (int i = 0; i < 5; ++i) {
+        src_pts[2 * i] = ARCFACE_DST[i][0] * 1.7f + 300.0f;
+        src_pts[2 * i + 1] = ARCFACE_DST[i][1] * 1.7f + 120.0f + i;
+        dst_pts[2 * i] = ARCFACE_DST[i][0];
+        dst_pts[2 * i + 1] = ARCFACE_DST[i][1];
+    }
+    run_benchmark("BM_SimilarTransform5pt", [&]() {
+        float m[6];
+        similar_transform_5pt(src_pts, dst_pts, m);
+        do_not_optimize(m);
+    });
+
+    cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar(90, 120, 150));
+    cv::Mat aligned(112, 112, CV_8UC3);
+    KEY_POINT point;
+    point.point_1_x = (int)src_pts[0]; point.point_1_y = (int)src_pts[1];
+    point.point_2_x = (int)src_pts[2]; point.point_2_y = (int)src_pts[3];
+    point.point_3_x = (int)src_pts[4]; point.point_3_y = (int)src_pts[5];
+    point.point_4_x = (int)src_pts[6]; point.point_4_y = (int)src_pts[7];
+    point.point_5_x = (int)src_pts[8]; point.point_5_y = (int)src_pts[9];
+    run_benchmark("BM_AlignFace/112x112", [&]() {
+        align_face(frame, point, aligned);
+        do_not_optimize(aligned.data);
+    });
+
+    std::mt19937 rng(1);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> a(FACENET_FEATURE_DIM), b(FACENET_FEATURE_DIM);
+    for (int i = 0; i < FACENET_FEATURE_DIM; ++i) {
+        a[i] = dist(rng);
+        b[i] = dist(rng);
+    }
+    run_benchmark("BM_L2Normalize", [&]() {
+        l2_normalize(a.data());
+        do_not_optimize(a.data());
+    });
+    run_benchmark("BM_CosSimilarity", [&]() {
+        float sim = cos_similarity(a.data(), b.data());
+        do_not_optimize(&sim);
+    });
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        print_usage();
+        return 1;
+    }
+
+    std::string command = argv[1];
+    std::string target = argv[2];
+
+    if (command == "gen") {
+        return cmd_gen(target);
+    } else if (command == "check") {
+        return cmd_check(target);
+    } else if (command == "record") {
+        return cmd_record(target);
+    } else if (command == "bench") {
+        return cmd_bench(target);
+    } else if (command == "test") {
+        return cmd_test(target);
+    }
+
+    print_usage();
+    return 1;
+}